@@ -26,6 +26,7 @@
 #include <cerrno>
 #include <vector>
 #include <array>
+#include <chrono>
 #include <map>
 #include <filesystem>
 #include "libfswatch/c++/event.hpp"
@@ -112,6 +113,7 @@ static bool vflag = false;
 static int version_flag = false;
 static bool xflag = false;
 static double lvalue = 1.0;
+static long debounce_ms = 0;
 static std::string monitor_name;
 static std::string tformat = "%c";
 static std::string batch_marker = event::get_event_flag_name(fsw_event_flag::NoOp);
@@ -135,6 +137,7 @@ static const int OPT_FILTER_FROM = 135;
 static const int OPT_NO_DEFER = 136;
 static const int OPT_PRUNE = 137;
 static const int OPT_FILTER_MODE = 138;
+static const int OPT_DEBOUNCE = 139;
 
 static void list_monitor_types(std::ostream& stream)
 {
@@ -170,6 +173,7 @@ static void usage(std::ostream& stream)
   stream << "     --batch-marker    " << _("Print a marker at the end of every batch.\n");
   stream << " -a, --access          " << _("Watch file accesses.\n");
   stream << " -b, --bubble-events   " << _("Bubble events with the same timestamp and path.\n");
+  stream << "     --debounce=MS     " << _("Merge the events of a path until it is quiet for MS milliseconds.\n");
   stream << " -d, --directories     " << _("Watch directories only.\n");
   stream << " -e, --exclude=REGEX   " << _("Exclude paths matching REGEX.\n");
   stream << " -E, --extended        " << _("Use extended regular expressions.\n");
@@ -178,7 +182,7 @@ static void usage(std::ostream& stream)
   stream << "     --filter-mode=MODE\n";
   stream << "                       " << _("Set filter mode: legacy or conjunctive.") << "\n";
   stream << "     --format=FORMAT   " << _("Use the specified record format.") << "\n";
-  stream << "                       " << _("Directives: %p path, %f flags, %t time, %c correlation, %K process id kind, %P process id.") << "\n";
+  stream << "                       " << _("Directives: %p path, %s secondary path, %f flags, %t time, %c correlation, %K process id kind, %P process id.") << "\n";
   stream << " -f, --format-time     " << _("Print the event time using the specified format.\n");
   stream << "     --fire-idle-event " << _("Fire idle events.\n");
   stream << " -h, --help            " << _("Show this message.\n");
@@ -222,8 +226,8 @@ static void usage(std::ostream& stream)
   stream << " -e  Exclude paths matching REGEX.\n";
   stream << " -E  Use extended regular expressions.\n";
   stream << " -f  Print the event time stamp with the specified format.\n";
-  stream << "     Format directives include %p path, %f flags, %t time, %c correlation,\n";
-  stream << "     %K process id kind, and %P process id.\n";
+  stream << "     Format directives include %p path, %s secondary path, %f flags, %t time,\n";
+  stream << "     %c correlation, %K process id kind, and %P process id.\n";
   stream << " -h  Show this message.\n";
   stream << " -i  Include paths matching REGEX.\n";
   stream << " -I  Use case insensitive regular expressions.\n";
@@ -326,6 +330,27 @@ static bool parse_filter_mode(const char *pOptarg)
   return false;
 }
 
+static bool parse_debounce(const char *pOptarg)
+{
+  char *end;
+  errno = 0;
+  debounce_ms = strtol(pOptarg, &end, 10);
+
+  if (end == pOptarg || *end != '\0' || debounce_ms <= 0)
+  {
+    std::cerr << _("Invalid value: ") << pOptarg << std::endl;
+    return false;
+  }
+
+  if (errno == ERANGE)
+  {
+    std::cerr << _("Value out of range: ") << pOptarg << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
 static bool validate_latency(double latency, const char *pOptarg)
 {
   if (latency == 0.0)
@@ -403,12 +428,12 @@ static void print_event_timestamp(const event& evt)
 
 static void print_event_flags(const event& evt)
 {
-  const std::vector<fsw_event_flag>& flags = evt.get_flags();
+  const event_flag_set& flags = evt.get_flag_set();
 
   if (nflag)
   {
     int mask = 0;
-    for (const fsw_event_flag& flag : flags)
+    for (const fsw_event_flag flag : flags)
     {
       mask += static_cast<int> (flag);
     }
@@ -417,12 +442,13 @@ static void print_event_flags(const event& evt)
   }
   else
   {
-    for (size_t i = 0; i < flags.size(); ++i)
+    bool first = true;
+    for (const fsw_event_flag flag : flags)
     {
-      std::cout << flags[i];
-
       // Event flag separator is currently hard-coded.
-      if (i != flags.size() - 1) std::cout << event_flag_separator;
+      if (!first) std::cout << event_flag_separator;
+      std::cout << flag;
+      first = false;
     }
   }
 }
@@ -565,6 +591,7 @@ static void start_monitor(int argc, char **argv, int argIndex)
   active_monitor->set_follow_symlinks(Lflag);
   active_monitor->set_watch_access(aflag);
   active_monitor->set_bubble_events(bflag);
+  active_monitor->set_debounce(std::chrono::milliseconds(debounce_ms));
 
   active_monitor->start();
 }
@@ -581,6 +608,7 @@ static void parse_opts(int argc, char **argv)
     {"allow-overflow",       no_argument,       nullptr,       OPT_ALLOW_OVERFLOW},
     {"batch-marker",         optional_argument, nullptr,       OPT_BATCH_MARKER},
     {"bubble-events",        no_argument,       nullptr,       'b'},
+    {"debounce",             required_argument, nullptr,       OPT_DEBOUNCE},
     {"directories",          no_argument,       nullptr,       'd'},
     {"event",                required_argument, nullptr,       OPT_EVENT_TYPE},
     {"event-flags",          no_argument,       nullptr,       'x'},
@@ -777,6 +805,13 @@ static void parse_opts(int argc, char **argv)
       noDeferFlag = true;
       break;
 
+    case OPT_DEBOUNCE:
+      if (!parse_debounce(optarg))
+      {
+        exit(FSW_EXIT_OPT);
+      }
+      break;
+
     case '?':
       usage(std::cerr);
       exit(FSW_EXIT_UNK_OPT);
@@ -886,6 +921,7 @@ static int printf_event(const event& evt,
    * %f - event flags (event separator will be formatted with a separate option)
    * %K - process id kind, if supported by the monitor
    * %P - process id, if supported by the monitor
+   * %s - secondary path, such as the destination of a rename, if any
    */
   for (size_t i = 0; i < format.length(); ++i)
   {
@@ -931,6 +967,9 @@ static int printf_event(const event& evt,
     case 'P':
       callback.format_P(evt);
       break;
+    case 's':
+      os << evt.get_secondary_path();
+      break;
     case 't':
       callback.format_t(evt);
       break;
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libfswatch/gettext_defs.h"
+#include "directory_reader.hpp"
+#include "libfswatch/c/libfswatch_log.h"
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#  include <sys/syscall.h>
+#endif
+
+namespace fsw
+{
+  namespace
+  {
+    bool is_dot_or_dot_dot(const char *name)
+    {
+      return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+    }
+
+#ifdef DT_UNKNOWN
+    entry_type get_dirent_type(unsigned char type)
+    {
+      switch (type)
+      {
+      case DT_UNKNOWN:
+        return entry_type::unknown;
+      case DT_DIR:
+        return entry_type::directory;
+      case DT_LNK:
+        return entry_type::symlink;
+      default:
+        return entry_type::other;
+      }
+    }
+#endif
+
+#ifdef __linux__
+    // Layout of the records returned by getdents64(), which glibc only
+    // declares since version 2.30.
+    struct linux_dirent64
+    {
+      uint64_t d_ino;
+      int64_t d_off;
+      unsigned short d_reclen;
+      unsigned char d_type;
+      char d_name[];
+    };
+
+    // Large enough to list most directories with a single system call.
+    constexpr size_t DIRENT_BUFFER_SIZE = 32 * 1024;
+#endif
+  }
+
+#ifdef __linux__
+  struct directory_reader::reader_state
+  {
+    int fd = -1;
+    size_t offset = 0;
+    size_t length = 0;
+    alignas(linux_dirent64) char buffer[DIRENT_BUFFER_SIZE];
+  };
+
+  directory_reader::directory_reader(const std::string& path) :
+    state(new reader_state)
+  {
+    state->fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (state->fd == -1) fsw_logf_perror(_("Cannot open directory %s"), path.c_str());
+  }
+
+  directory_reader::~directory_reader()
+  {
+    if (state->fd != -1) close(state->fd);
+  }
+
+  bool directory_reader::is_open() const
+  {
+    return state->fd != -1;
+  }
+
+  bool directory_reader::next(directory_entry_info& entry)
+  {
+    if (state->fd == -1) return false;
+
+    for (;;)
+    {
+      if (state->offset >= state->length)
+      {
+        const long count = syscall(SYS_getdents64, state->fd, state->buffer, sizeof(state->buffer));
+
+        if (count <= 0)
+        {
+          if (count == -1) fsw_log_perror("getdents64");
+          return false;
+        }
+
+        state->offset = 0;
+        state->length = static_cast<size_t>(count);
+      }
+
+      const auto *record = reinterpret_cast<const linux_dirent64 *>(state->buffer + state->offset);
+      state->offset += record->d_reclen;
+
+      if (is_dot_or_dot_dot(record->d_name)) continue;
+
+      entry.name = record->d_name;
+      entry.name_length = strlen(record->d_name);
+      entry.type = get_dirent_type(record->d_type);
+      break;
+    }
+
+    if (entry.type == entry_type::unknown)
+    {
+      struct stat fd_stat;
+      if (stat(entry.name, fd_stat, false)) entry.type = get_entry_type(fd_stat.st_mode);
+    }
+
+    return true;
+  }
+
+  bool directory_reader::stat(const char *name, struct stat& fd_stat, bool follow_symlink) const
+  {
+    return fstatat(state->fd, name, &fd_stat, follow_symlink ? 0 : AT_SYMLINK_NOFOLLOW) == 0;
+  }
+
+  bool directory_reader::read_symlink(const char *name, std::string& target) const
+  {
+    char buffer[PATH_MAX];
+    const ssize_t length = readlinkat(state->fd, name, buffer, sizeof(buffer));
+    if (length == -1) return false;
+
+    target.assign(buffer, static_cast<size_t>(length));
+    return true;
+  }
+#else
+  struct directory_reader::reader_state
+  {
+    DIR *dir = nullptr;
+  };
+
+  directory_reader::directory_reader(const std::string& path) :
+    state(new reader_state)
+  {
+    state->dir = opendir(path.c_str());
+    if (state->dir == nullptr) fsw_logf_perror(_("Cannot open directory %s"), path.c_str());
+  }
+
+  directory_reader::~directory_reader()
+  {
+    if (state->dir != nullptr) closedir(state->dir);
+  }
+
+  bool directory_reader::is_open() const
+  {
+    return state->dir != nullptr;
+  }
+
+  bool directory_reader::next(directory_entry_info& entry)
+  {
+    if (state->dir == nullptr) return false;
+
+    for (;;)
+    {
+      errno = 0;
+      const struct dirent *record = readdir(state->dir);
+
+      if (record == nullptr)
+      {
+        if (errno != 0) fsw_log_perror("readdir");
+        return false;
+      }
+
+      if (is_dot_or_dot_dot(record->d_name)) continue;
+
+      entry.name = record->d_name;
+      entry.name_length = strlen(record->d_name);
+#  ifdef DT_UNKNOWN
+      entry.type = get_dirent_type(record->d_type);
+#  else
+      entry.type = entry_type::unknown;
+#  endif
+      break;
+    }
+
+    if (entry.type == entry_type::unknown)
+    {
+      struct stat fd_stat;
+      if (stat(entry.name, fd_stat, false)) entry.type = get_entry_type(fd_stat.st_mode);
+    }
+
+    return true;
+  }
+
+  bool directory_reader::stat(const char *name, struct stat& fd_stat, bool follow_symlink) const
+  {
+    return fstatat(dirfd(state->dir), name, &fd_stat, follow_symlink ? 0 : AT_SYMLINK_NOFOLLOW) == 0;
+  }
+
+  bool directory_reader::read_symlink(const char *name, std::string& target) const
+  {
+    char buffer[PATH_MAX];
+    const ssize_t length = readlinkat(dirfd(state->dir), name, buffer, sizeof(buffer));
+    if (length == -1) return false;
+
+    target.assign(buffer, static_cast<size_t>(length));
+    return true;
+  }
+#endif
+
+  entry_type get_entry_type(mode_t mode)
+  {
+    if (S_ISDIR(mode)) return entry_type::directory;
+    if (S_ISLNK(mode)) return entry_type::symlink;
+
+    return entry_type::other;
+  }
+
+  entry_type get_entry_type(const std::string& path)
+  {
+    struct stat fd_stat;
+
+    if (lstat(path.c_str(), &fd_stat) == 0) return get_entry_type(fd_stat.st_mode);
+    if (errno != ENOENT) fsw_logf_perror(_("Cannot lstat %s"), path.c_str());
+
+    return entry_type::unknown;
+  }
+}
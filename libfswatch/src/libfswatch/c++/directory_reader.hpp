@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file
+ * @brief Header of the fsw::directory_reader class.
+ *
+ * This header file defines the fsw::directory_reader class, which lists the
+ * entries of a directory through its file descriptor.
+ *
+ * @copyright Copyright (c) 2026 Enrico M. Crisostomo
+ * @license GNU General Public License v. 3.0
+ * @author Enrico M. Crisostomo
+ * @version 1.22.0
+ */
+#ifndef FSW_DIRECTORY_READER_H
+#  define FSW_DIRECTORY_READER_H
+
+#  include <cstddef>
+#  include <cstdint>
+#  include <memory>
+#  include <string>
+#  include <sys/stat.h>
+
+namespace fsw
+{
+  /**
+   * @brief Type of a directory entry.
+   */
+  enum class entry_type : uint8_t
+  {
+    unknown,    /**< The type could not be determined. */
+    directory,  /**< A directory. */
+    symlink,    /**< A symbolic link, which is not followed. */
+    other       /**< Any other type of file. */
+  };
+
+  /**
+   * @brief Entry of a directory.
+   *
+   * The name points into the buffer of the fsw::directory_reader that read the
+   * entry and is valid until the next entry is read.
+   */
+  struct directory_entry_info
+  {
+    /**
+     * @brief The null-terminated name of the entry.
+     */
+    const char *name = nullptr;
+    /**
+     * @brief The length of the name.
+     */
+    size_t name_length = 0;
+    /**
+     * @brief The type of the entry.
+     */
+    entry_type type = entry_type::unknown;
+  };
+
+  /**
+   * @brief Directory reader.
+   *
+   * Listing a directory with @c std::filesystem::directory_iterator and then
+   * querying the status of each entry by path performs a path lookup and an
+   * @c lstat() call per entry.  This class opens the directory once and lists
+   * its entries with @c getdents64() on Linux, and with @c readdir() on the
+   * other systems, taking the type of the entries from @c d_type.  Only the
+   * entries whose type the file system does not report are queried, with an
+   * @c fstatat() call relative to the directory descriptor, and so are the
+   * statuses requested with stat().
+   */
+  class directory_reader
+  {
+  public:
+    /**
+     * @brief Opens a directory.
+     *
+     * @param path The path of the directory.  Symbolic links are followed.
+     */
+    explicit directory_reader(const std::string& path);
+
+    /**
+     * @brief Closes the directory.
+     */
+    ~directory_reader();
+
+    directory_reader(const directory_reader&) = delete;
+    directory_reader& operator=(const directory_reader&) = delete;
+
+    /**
+     * @brief Checks whether the directory was opened.
+     *
+     * @return @c true if the directory was opened, @c false otherwise.
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Reads the next entry of the directory.
+     *
+     * The @c . and @c .. entries are skipped.
+     *
+     * @param entry The entry to fill.
+     * @return @c true if an entry was read, @c false at the end of the
+     * directory or if an error occurred.
+     */
+    bool next(directory_entry_info& entry);
+
+    /**
+     * @brief Gets the status of an entry of the directory.
+     *
+     * @param name The name of the entry.
+     * @param fd_stat The @c stat structure where the status is written.
+     * @param follow_symlink @c true if symbolic links must be followed.
+     * @return @c true if the function succeeds, @c false otherwise.
+     */
+    bool stat(const char *name, struct stat& fd_stat, bool follow_symlink) const;
+
+    /**
+     * @brief Reads the target of a symbolic link in the directory.
+     *
+     * @param name The name of the symbolic link.
+     * @param target The string where the target is written.
+     * @return @c true if the function succeeds, @c false otherwise.
+     */
+    bool read_symlink(const char *name, std::string& target) const;
+
+  private:
+    struct reader_state;
+    std::unique_ptr<reader_state> state;
+  };
+
+  /**
+   * @brief Gets the type of a file from its mode.
+   *
+   * @param mode The mode of the file.
+   * @return The type of the file.
+   */
+  entry_type get_entry_type(mode_t mode);
+
+  /**
+   * @brief Gets the type of a file without following symbolic links.
+   *
+   * @param path The path of the file.
+   * @return The type of the file, or fsw::entry_type::unknown if its status
+   * cannot be read.
+   */
+  entry_type get_entry_type(const std::string& path);
+}
+
+#endif  /* FSW_DIRECTORY_READER_H */
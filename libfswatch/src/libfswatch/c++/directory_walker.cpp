@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "directory_walker.hpp"
+#include "directory_reader.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace fsw
+{
+  namespace
+  {
+    constexpr size_t DEFAULT_THREAD_COUNT = 4;
+
+    struct work_queue
+    {
+      std::mutex mutex;
+      std::deque<std::filesystem::path> directories;
+    };
+
+    class walk_state
+    {
+    public:
+      walk_state(const directory_walker::visit_function& visit,
+                 size_t thread_count,
+                 bool visit_files) :
+        visit(visit), queues(thread_count), visit_files(visit_files)
+      {
+      }
+
+      void run(const std::filesystem::path& root)
+      {
+        std::optional<std::filesystem::path> directory;
+
+        try
+        {
+          directory = visit(root, entry_type::unknown, true);
+        }
+        catch (...)
+        {
+          fail(std::current_exception());
+        }
+
+        if (directory) push(0, {std::move(*directory)});
+
+        work(0);
+
+        // Threads are only started by running threads, so that none is
+        // started after the last one is joined.
+        for (;;)
+        {
+          std::thread helper;
+
+          {
+            std::lock_guard<std::mutex> guard(threads_mutex);
+            if (threads.empty()) break;
+            helper = std::move(threads.back());
+            threads.pop_back();
+          }
+
+          helper.join();
+        }
+
+        if (error) std::rethrow_exception(error);
+      }
+
+      size_t directories() const
+      {
+        return listed;
+      }
+
+      size_t threads_started() const
+      {
+        return started + 1;
+      }
+
+    private:
+      void work(size_t self)
+      {
+        for (;;)
+        {
+          std::filesystem::path directory;
+
+          if (pop(self, directory))
+          {
+            list(self, directory);
+
+            if (--pending == 0) wake_all();
+            continue;
+          }
+
+          std::unique_lock<std::mutex> guard(idle_mutex);
+          idle_condition.wait(guard, [this]
+          {
+            return pending == 0 || queued > 0 || failed;
+          });
+
+          if (pending == 0 || failed) return;
+        }
+      }
+
+      void list(size_t self, const std::filesystem::path& directory)
+      {
+        ++listed;
+        if (failed) return;
+
+        // Symbolic links are visited as well, since they may have to be
+        // followed, and so are the other files if requested.
+        std::vector<std::pair<std::filesystem::path, entry_type>> entries;
+        directory_reader reader(directory.string());
+        directory_entry_info entry;
+
+        while (reader.next(entry))
+        {
+          if (entry.type == entry_type::other && !visit_files) continue;
+          entries.emplace_back(directory / entry.name, entry.type);
+        }
+
+        std::vector<std::filesystem::path> children;
+
+        try
+        {
+          std::lock_guard<std::mutex> guard(visit_mutex);
+
+          for (const auto& [path, type] : entries)
+          {
+            auto child = visit(path, type, false);
+            if (child) children.push_back(std::move(*child));
+          }
+        }
+        catch (...)
+        {
+          fail(std::current_exception());
+          return;
+        }
+
+        if (!children.empty()) push(self, std::move(children));
+      }
+
+      void push(size_t self, std::vector<std::filesystem::path> directories)
+      {
+        const size_t count = directories.size();
+        pending += count;
+
+        {
+          std::lock_guard<std::mutex> guard(queues[self].mutex);
+          for (auto& directory : directories)
+            queues[self].directories.push_back(std::move(directory));
+        }
+
+        const size_t waiting = (queued += count);
+        wake_one();
+
+        if (waiting > 1) start_thread();
+      }
+
+      bool pop(size_t self, std::filesystem::path& directory)
+      {
+        // The newest directory of the own queue, or the oldest of another.
+        for (size_t i = 0; i < queues.size(); ++i)
+        {
+          work_queue& queue = queues[(self + i) % queues.size()];
+          std::lock_guard<std::mutex> guard(queue.mutex);
+
+          if (queue.directories.empty()) continue;
+
+          if (i == 0)
+          {
+            directory = std::move(queue.directories.back());
+            queue.directories.pop_back();
+          }
+          else
+          {
+            directory = std::move(queue.directories.front());
+            queue.directories.pop_front();
+          }
+
+          --queued;
+          return true;
+        }
+
+        return false;
+      }
+
+      void start_thread()
+      {
+        std::lock_guard<std::mutex> guard(threads_mutex);
+        if (started + 1 >= queues.size()) return;
+
+        const size_t index = ++started;
+        threads.emplace_back([this, index] { work(index); });
+      }
+
+      void fail(std::exception_ptr e)
+      {
+        {
+          std::lock_guard<std::mutex> guard(idle_mutex);
+          if (!error) error = std::move(e);
+          failed = true;
+        }
+
+        idle_condition.notify_all();
+      }
+
+      void wake_one()
+      {
+        {
+          std::lock_guard<std::mutex> guard(idle_mutex);
+        }
+
+        idle_condition.notify_one();
+      }
+
+      void wake_all()
+      {
+        {
+          std::lock_guard<std::mutex> guard(idle_mutex);
+        }
+
+        idle_condition.notify_all();
+      }
+
+      const directory_walker::visit_function& visit;
+      std::vector<work_queue> queues;
+      const bool visit_files;
+      std::mutex visit_mutex;
+      // Directories queued or being listed.
+      std::atomic<size_t> pending{0};
+      std::atomic<size_t> queued{0};
+      std::atomic<size_t> listed{0};
+      std::atomic<bool> failed{false};
+      std::exception_ptr error;
+      std::mutex idle_mutex;
+      std::condition_variable idle_condition;
+      std::mutex threads_mutex;
+      std::vector<std::thread> threads;
+      size_t started = 0;
+    };
+  }
+
+  directory_walker::directory_walker(visit_function visit, size_t thread_count, bool visit_files) :
+    visit(std::move(visit)), thread_count(std::max<size_t>(thread_count, 1)), visit_files(visit_files)
+  {
+  }
+
+  walk_statistics directory_walker::walk(const std::filesystem::path& root)
+  {
+    const auto start = std::chrono::steady_clock::now();
+
+    walk_state state(visit, thread_count, visit_files);
+    state.run(root);
+
+    walk_statistics statistics;
+    statistics.directories = state.directories();
+    statistics.threads = state.threads_started();
+    statistics.elapsed = std::chrono::steady_clock::now() - start;
+
+    return statistics;
+  }
+
+  size_t directory_walker::default_thread_count()
+  {
+    return DEFAULT_THREAD_COUNT;
+  }
+}
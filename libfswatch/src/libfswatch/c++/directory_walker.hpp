@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file
+ * @brief Header of the fsw::directory_walker class.
+ *
+ * This header file defines the fsw::directory_walker class, a parallel
+ * directory tree walker used by the monitors to scan the watched paths.
+ *
+ * @copyright Copyright (c) 2026 Enrico M. Crisostomo
+ * @license GNU General Public License v. 3.0
+ * @author Enrico M. Crisostomo
+ * @version 1.22.0
+ */
+#ifndef FSW_DIRECTORY_WALKER_H
+#  define FSW_DIRECTORY_WALKER_H
+
+#  include "directory_reader.hpp"
+#  include <chrono>
+#  include <cstddef>
+#  include <filesystem>
+#  include <functional>
+#  include <optional>
+
+namespace fsw
+{
+  /**
+   * @brief Statistics of a walk.
+   */
+  struct walk_statistics
+  {
+    /**
+     * @brief Number of directories whose entries have been listed.
+     */
+    size_t directories = 0;
+    /**
+     * @brief Number of threads that listed directories, including the caller.
+     */
+    size_t threads = 0;
+    /**
+     * @brief Duration of the walk.
+     */
+    std::chrono::steady_clock::duration elapsed{};
+  };
+
+  /**
+   * @brief Parallel directory tree walker.
+   *
+   * Listing the entries of the directories of a large tree dominates the time
+   * required to scan it, especially when the tree is not cached.  This class
+   * lists directories concurrently on a pool of threads, while the paths they
+   * discover are visited one at a time, so that the visitor can register
+   * watches without synchronization.
+   *
+   * Each thread owns a double-ended queue of directories to list: it pushes
+   * and pops directories at the back, so that the walk proceeds depth first
+   * and the threads work on separate subtrees, while idle threads steal the
+   * oldest directories, the roots of the largest pending subtrees, from the
+   * front of the queue of the others.
+   *
+   * The thread calling walk() takes part in the walk, and the other threads
+   * are started only when more directories are pending than threads are
+   * working, so that walking a small tree does not start any thread.
+   */
+  class directory_walker
+  {
+  public:
+    /**
+     * @brief Function visiting a path.
+     *
+     * The function is invoked with the path to visit, its type as listed in
+     * its parent directory, and whether it is the root of the walk.  The type
+     * of the root is fsw::entry_type::unknown, and so is the type of an entry
+     * that could not be determined: the function must query the status of
+     * the path in these cases only.  The function returns the directory to
+     * list to visit the children of the path, which may differ from the path
+     * itself when it is a symbolic link to follow, or no value if the children
+     * of the path must not be visited.  Invocations are serialized.
+     */
+    using visit_function =
+      std::function<std::optional<std::filesystem::path>(const std::filesystem::path&,
+                                                          entry_type,
+                                                          bool)>;
+
+    /**
+     * @brief Constructs a walker.
+     *
+     * @param visit The function visiting the paths.
+     * @param thread_count The maximum number of threads listing directories,
+     * including the thread calling walk().  @c 0 is treated as @c 1.
+     * @param visit_files @c true if all the entries of the directories must be
+     * visited, @c false if only their subdirectories and symbolic links must.
+     */
+    directory_walker(visit_function visit, size_t thread_count, bool visit_files = false);
+
+    /**
+     * @brief Visits a path and, recursively, its children.
+     *
+     * Unless the walker visits files, only the subdirectories and the
+     * symbolic links of a directory are visited.  If a visit throws,
+     * the walk is stopped and the exception is rethrown once all the threads
+     * have finished.
+     *
+     * @param root The path to visit.
+     * @return The statistics of the walk.
+     */
+    walk_statistics walk(const std::filesystem::path& root);
+
+    /**
+     * @brief Gets the default number of threads of a walker.
+     *
+     * Listing uncached directories is bound by I/O rather than CPU, so the
+     * default does not depend on the number of hardware threads.
+     *
+     * @return The default number of threads, 4.
+     */
+    static size_t default_thread_count();
+
+  private:
+    visit_function visit;
+    size_t thread_count;
+    bool visit_files;
+  };
+}
+
+#endif  /* FSW_DIRECTORY_WALKER_H */
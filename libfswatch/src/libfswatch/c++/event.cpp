@@ -22,24 +22,48 @@ using namespace std;
 
 namespace fsw
 {
-  event::event(string path, time_t evt_time, vector<fsw_event_flag> flags) :
-    path(std::move(path)), evt_time(evt_time), evt_flags(std::move(flags))
+  event_flag_set::event_flag_set(std::initializer_list<fsw_event_flag> flags)
   {
+    for (const fsw_event_flag flag : flags) insert(flag);
   }
 
-  event::event(string path, time_t evt_time, vector<fsw_event_flag> flags, unsigned long correlation_id) :
-    path(std::move(path)), evt_time(evt_time), evt_flags(std::move(flags)), correlation_id(correlation_id)
+  event_flag_set::event_flag_set(const vector<fsw_event_flag>& flags)
+  {
+    for (const fsw_event_flag flag : flags) insert(flag);
+  }
+
+  size_t event_flag_set::size() const
+  {
+    size_t count = 0;
+
+    for (uint16_t bits = mask; bits != 0; bits &= bits - 1) ++count;
+
+    return count;
+  }
+
+  vector<fsw_event_flag> event_flag_set::to_vector() const
+  {
+    return vector<fsw_event_flag>(begin(), end());
+  }
+
+  event::event(string path, time_t evt_time, event_flag_set flags) :
+    path(std::move(path)), evt_time(evt_time), evt_flags(flags)
+  {
+  }
+
+  event::event(string path, time_t evt_time, event_flag_set flags, unsigned long correlation_id) :
+    path(std::move(path)), evt_time(evt_time), evt_flags(flags), correlation_id(correlation_id)
   {
   }
 
   event::event(string path,
                time_t evt_time,
-               vector<fsw_event_flag> flags,
+               event_flag_set flags,
                unsigned long correlation_id,
                process_metadata process) :
     path(std::move(path)),
     evt_time(evt_time),
-    evt_flags(std::move(flags)),
+    evt_flags(flags),
     correlation_id(correlation_id),
     process(process)
   {
@@ -47,21 +71,46 @@ namespace fsw
 
   event::~event() = default;
 
-  string event::get_path() const
+  const string& event::get_path() const
   {
     return path;
   }
 
+  const string& event::get_secondary_path() const
+  {
+    return secondary_path;
+  }
+
+  bool event::has_secondary_path() const
+  {
+    return !secondary_path.empty();
+  }
+
+  void event::set_secondary_path(string secondary_path)
+  {
+    this->secondary_path = std::move(secondary_path);
+  }
+
   time_t event::get_time() const
   {
     return evt_time;
   }
 
   vector<fsw_event_flag> event::get_flags() const
+  {
+    return evt_flags.to_vector();
+  }
+
+  const event_flag_set& event::get_flag_set() const
   {
     return evt_flags;
   }
 
+  void event::set_flag_set(const event_flag_set& flags)
+  {
+    evt_flags = flags;
+  }
+
   unsigned long event::get_correlation_id() const
   {
     return correlation_id;
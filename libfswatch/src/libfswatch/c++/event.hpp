@@ -28,6 +28,10 @@
 
 #  include <string>
 #  include <ctime>
+#  include <cstddef>
+#  include <cstdint>
+#  include <initializer_list>
+#  include <iterator>
 #  include <vector>
 #  include <iostream>
 #  include <optional>
@@ -50,6 +54,222 @@ namespace fsw
     bool has_pidfd = false;
   };
 
+  /**
+   * @brief Compact set of event flags.
+   *
+   * Every fsw_event_flag but fsw_event_flag::NoOp is a distinct power of 2
+   * lower than 2<sup>15</sup>: a set of flags is thus stored as a 16 bit mask
+   * where fsw_event_flag::NoOp is mapped to the most significant bit.  Sets
+   * are cheap to copy and never allocate memory.
+   *
+   * Iterating over a set yields its flags in increasing order of their value.
+   */
+  class event_flag_set
+  {
+  public:
+    /**
+     * @brief Bit used to represent fsw_event_flag::NoOp.
+     */
+    static constexpr uint16_t NOOP_BIT = 1u << 15;
+
+    /**
+     * @brief Forward iterator over the flags of a set.
+     */
+    class const_iterator
+    {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = fsw_event_flag;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const fsw_event_flag *;
+      using reference = fsw_event_flag;
+
+      const_iterator() = default;
+
+      fsw_event_flag operator*() const
+      {
+        if (remaining & NOOP_BIT) return fsw_event_flag::NoOp;
+
+        return static_cast<fsw_event_flag>(remaining & (~remaining + 1));
+      }
+
+      const_iterator& operator++()
+      {
+        if (remaining & NOOP_BIT) remaining &= ~NOOP_BIT;
+        else remaining &= remaining - 1;
+
+        return *this;
+      }
+
+      const_iterator operator++(int)
+      {
+        const_iterator previous = *this;
+        ++*this;
+        return previous;
+      }
+
+      bool operator==(const const_iterator& other) const
+      {
+        return remaining == other.remaining;
+      }
+
+      bool operator!=(const const_iterator& other) const
+      {
+        return remaining != other.remaining;
+      }
+
+    private:
+      friend class event_flag_set;
+
+      explicit const_iterator(uint16_t remaining) : remaining(remaining)
+      {
+      }
+
+      uint16_t remaining = 0;
+    };
+
+    using iterator = const_iterator;
+
+    /**
+     * @brief Constructs an empty set.
+     */
+    event_flag_set() = default;
+
+    /**
+     * @brief Constructs a set containing the specified flags.
+     *
+     * @param flags The flags of the set.
+     */
+    event_flag_set(std::initializer_list<fsw_event_flag> flags);
+
+    /**
+     * @brief Constructs a set containing the specified flags.
+     *
+     * This constructor is not explicit so that code passing a vector of flags
+     * to the fsw::event constructors keeps compiling.  Duplicate flags are
+     * merged.
+     *
+     * @param flags The flags of the set.
+     */
+    event_flag_set(const std::vector<fsw_event_flag>& flags);
+
+    /**
+     * @brief Constructs a set from its bit mask.
+     *
+     * @param mask The bit mask, as returned by get_mask().
+     * @return The set represented by @p mask.
+     */
+    static event_flag_set from_mask(uint16_t mask)
+    {
+      event_flag_set set;
+      set.mask = mask;
+      return set;
+    }
+
+    /**
+     * @brief Returns the bit mask of the set.
+     *
+     * The bits of the mask are the values of the flags in the set, with the
+     * exception of fsw_event_flag::NoOp, represented by
+     * event_flag_set::NOOP_BIT.
+     *
+     * @return The bit mask of the set.
+     */
+    uint16_t get_mask() const
+    {
+      return mask;
+    }
+
+    /**
+     * @brief Checks whether the set contains a flag.
+     */
+    bool contains(fsw_event_flag flag) const
+    {
+      return (mask & to_bit(flag)) != 0;
+    }
+
+    /**
+     * @brief Adds a flag to the set.
+     */
+    void insert(fsw_event_flag flag)
+    {
+      mask |= to_bit(flag);
+    }
+
+    /**
+     * @brief Removes a flag from the set.
+     */
+    void erase(fsw_event_flag flag)
+    {
+      mask &= static_cast<uint16_t>(~to_bit(flag));
+    }
+
+    /**
+     * @brief Removes all the flags from the set.
+     */
+    void clear()
+    {
+      mask = 0;
+    }
+
+    /**
+     * @brief Checks whether the set is empty.
+     */
+    bool empty() const
+    {
+      return mask == 0;
+    }
+
+    /**
+     * @brief Returns the number of flags in the set.
+     */
+    size_t size() const;
+
+    const_iterator begin() const
+    {
+      return const_iterator(mask);
+    }
+
+    const_iterator end() const
+    {
+      return const_iterator();
+    }
+
+    /**
+     * @brief Returns the flags of the set as a vector.
+     */
+    std::vector<fsw_event_flag> to_vector() const;
+
+    /**
+     * @brief Adds the flags of another set to this set.
+     */
+    event_flag_set& operator|=(const event_flag_set& other)
+    {
+      mask |= other.mask;
+      return *this;
+    }
+
+    bool operator==(const event_flag_set& other) const
+    {
+      return mask == other.mask;
+    }
+
+    bool operator!=(const event_flag_set& other) const
+    {
+      return mask != other.mask;
+    }
+
+  private:
+    static uint16_t to_bit(fsw_event_flag flag)
+    {
+      if (flag == fsw_event_flag::NoOp) return NOOP_BIT;
+
+      return static_cast<uint16_t>(flag);
+    }
+
+    uint16_t mask = 0;
+  };
+
   /**
    * @brief Type representing a file change event.
    *
@@ -58,8 +278,10 @@ namespace fsw
    *
    *   - The path.
    *   - The time the event was raised.
-   *   - A vector of flags specifying the type of the event.
+   *   - A set of flags specifying the type of the event.
    *   - The correlation id of the event, if supported by the monitor, otherwise 0.
+   *   - The secondary path of the event, if any, such as the destination of a
+   *     rename reported as a single event.
    */
   class event
   {
@@ -69,32 +291,32 @@ namespace fsw
      *
      * @param path The path the event refers to.
      * @param evt_time The time the event was raised.
-     * @param flags The vector of flags specifying the type of the event.
+     * @param flags The flags specifying the type of the event.
      */
-    event(std::string path, time_t evt_time, std::vector<fsw_event_flag> flags);
+    event(std::string path, time_t evt_time, event_flag_set flags);
 
     /**
      * @brief Constructs an event.
      *
      * @param path The path the event refers to.
      * @param evt_time The time the event was raised.
-     * @param flags The vector of flags specifying the type of the event.
+     * @param flags The flags specifying the type of the event.
      * @param correlation_id The correlation_id of the file the event refers to.
      */
-    event(std::string path, time_t evt_time, std::vector<fsw_event_flag> flags, unsigned long correlation_id);
+    event(std::string path, time_t evt_time, event_flag_set flags, unsigned long correlation_id);
 
     /**
      * @brief Constructs an event with optional process metadata.
      *
      * @param path The path the event refers to.
      * @param evt_time The time the event was raised.
-     * @param flags The vector of flags specifying the type of the event.
+     * @param flags The flags specifying the type of the event.
      * @param correlation_id The correlation_id of the file the event refers to.
      * @param process The optional process metadata associated with the event.
      */
     event(std::string path,
           time_t evt_time,
-          std::vector<fsw_event_flag> flags,
+          event_flag_set flags,
           unsigned long correlation_id,
           process_metadata process);
 
@@ -105,12 +327,44 @@ namespace fsw
      */
     virtual ~event();
 
+    event(const event&) = default;
+    event(event&&) noexcept = default;
+    event& operator=(const event&) = default;
+    event& operator=(event&&) noexcept = default;
+
     /**
      * @brief Returns the path of the event.
      *
+     * The returned reference is valid as long as the event is.
+     *
      * @return The path of the event.
      */
-    std::string get_path() const;
+    const std::string& get_path() const;
+
+    /**
+     * @brief Returns the secondary path of the event.
+     *
+     * An event reporting a rename as a single event carries the source of the
+     * rename as its path, and the destination as its secondary path.  The
+     * returned reference is valid as long as the event is.
+     *
+     * @return The secondary path of the event, or an empty string if the event
+     * has none.
+     */
+    const std::string& get_secondary_path() const;
+
+    /**
+     * @brief Returns true if the event has a secondary path.
+     */
+    bool has_secondary_path() const;
+
+    /**
+     * @brief Sets the secondary path of the event.
+     *
+     * @param secondary_path The secondary path of the event.  An empty path
+     * removes the secondary path.
+     */
+    void set_secondary_path(std::string secondary_path);
 
     /**
      * @brief Returns the time of the event.
@@ -122,10 +376,27 @@ namespace fsw
     /**
      * @brief Returns the flags of the event.
      *
+     * This function allocates a new vector at each invocation: use
+     * get_flag_set() instead.
+     *
      * @return The flags of the event.
      */
     std::vector<fsw_event_flag> get_flags() const;
 
+    /**
+     * @brief Returns the set of flags of the event.
+     *
+     * @return The set of flags of the event.
+     */
+    const event_flag_set& get_flag_set() const;
+
+    /**
+     * @brief Replaces the set of flags of the event.
+     *
+     * @param flags The new set of flags of the event.
+     */
+    void set_flag_set(const event_flag_set& flags);
+
     /**
      * @brief Returns the correlation_id of the file of the event.
      * @return The correlation_id of the file of the event.
@@ -188,8 +459,9 @@ namespace fsw
 
   private:
     std::string path;
+    std::string secondary_path;
     time_t evt_time;
-    std::vector<fsw_event_flag> evt_flags;
+    event_flag_set evt_flags;
     unsigned long correlation_id = 0;
     process_metadata process;
   };
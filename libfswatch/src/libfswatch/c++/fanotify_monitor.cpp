@@ -24,13 +24,19 @@
 #include "libfswatch/gettext_defs.h"
 #include "libfswatch_exception.hpp"
 #include "../c/libfswatch_log.h"
-#include "path_utils.hpp"
+#include "directory_walker.hpp"
+#include "file_handle_key.hpp"
+#include "file_handle_table.hpp"
+#include "handle_path_cache.hpp"
+#include "missing_root_set.hpp"
+#include "path_tree.hpp"
 #include "string/string_utils.hpp"
 
 #include <algorithm>
 #include <array>
 #include <cerrno>
-#include <cmath>
+#include <chrono>
+#include <cstdlib>
 #include <cstdint>
 #include <cstring>
 #include <ctime>
@@ -45,7 +51,6 @@
 #include <sys/vfs.h>
 #include <unistd.h>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #ifndef O_LARGEFILE
@@ -60,9 +65,42 @@ namespace fsw
 {
   namespace
   {
-    constexpr size_t FANOTIFY_BUFFER_SIZE = 4096;
+    constexpr size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
     constexpr size_t FILE_HANDLE_BUFFER_SIZE = sizeof(struct file_handle) + MAX_HANDLE_SZ;
+    // An event carries at most two directory file handles with an entry name
+    // each, and the descriptor of the process.
+    constexpr size_t MAX_EVENT_SIZE =
+      sizeof(struct fanotify_event_metadata) +
+      2 * (sizeof(struct fanotify_event_info_fid) + FILE_HANDLE_BUFFER_SIZE + NAME_MAX + 1) +
+      sizeof(struct fanotify_event_info_header) + sizeof(int);
     constexpr int EPOLL_EVENT_COUNT = 2;
+    constexpr uint64_t ANCHOR_EVENT_MASK =
+      FAN_CREATE | FAN_MOVED_TO | FAN_DELETE_SELF | FAN_MOVE_SELF | FAN_ONDIR;
+    // The events supported by mount marks, which do not report the directory
+    // entry events.
+    constexpr uint64_t MOUNT_EVENT_MASK =
+      FAN_MODIFY | FAN_CLOSE_WRITE | FAN_ACCESS | FAN_OPEN | FAN_CLOSE_NOWRITE | FAN_ONDIR;
+    constexpr const char DELETED_SUFFIX[] = " (deleted)";
+#if defined(FAN_RENAME)
+    constexpr uint64_t RENAME_EVENT_MASK = FAN_RENAME;
+#else
+    constexpr uint64_t RENAME_EVENT_MASK = 0;
+#endif
+
+    enum class mark_scope
+    {
+      inode,
+      filesystem,
+      mount
+    };
+
+    // A root path watched by a filesystem or mount mark, and the path its
+    // events are resolved to.
+    struct scoped_root
+    {
+      std::string path;
+      std::string real_path;
+    };
 
     struct scoped_fd
     {
@@ -122,14 +160,6 @@ namespace fsw
       return value == "1" || value == "true" || value == "yes" || value == "on";
     }
 
-    static int latency_to_timeout_ms(double latency)
-    {
-      if (latency <= 0) return 0;
-      if (latency >= INT_MAX / 1000.0) return INT_MAX;
-
-      return static_cast<int>(std::ceil(latency * 1000.0));
-    }
-
     static void add_epoll_interest(int epoll_fd, int fd)
     {
       struct epoll_event event {};
@@ -163,21 +193,19 @@ namespace fsw
       }
     }
 
-    static std::string make_handle_key(const void *fsid,
-                                       size_t fsid_size,
-                                       const struct file_handle *handle)
+    static file_handle_key make_handle_key(const void *fsid,
+                                           size_t fsid_size,
+                                           const struct file_handle *handle)
     {
-      std::string key;
-      key.append(reinterpret_cast<const char *>(fsid), fsid_size);
-      key.append(reinterpret_cast<const char *>(&handle->handle_type), sizeof(handle->handle_type));
-      key.append(reinterpret_cast<const char *>(&handle->handle_bytes), sizeof(handle->handle_bytes));
-      key.append(reinterpret_cast<const char *>(handle->f_handle), handle->handle_bytes);
-
-      return key;
+      return file_handle_key(fsid,
+                             fsid_size,
+                             handle->handle_type,
+                             handle->f_handle,
+                             handle->handle_bytes);
     }
 
     static bool get_path_handle(const std::filesystem::path& path,
-                                std::string& key)
+                                file_handle_key& key)
     {
       struct statfs fs_stats{};
       if (statfs(path.c_str(), &fs_stats) != 0)
@@ -201,31 +229,31 @@ namespace fsw
       return true;
     }
 
-    static std::vector<fsw_event_flag> flags_from_mask(uint64_t mask)
+    static event_flag_set flags_from_mask(uint64_t mask)
     {
-      std::vector<fsw_event_flag> flags;
-
-      if (mask & FAN_ONDIR) flags.push_back(fsw_event_flag::IsDir);
-      if (mask & FAN_CREATE) flags.push_back(fsw_event_flag::Created);
-      if (mask & FAN_MODIFY) flags.push_back(fsw_event_flag::Updated);
-      if (mask & FAN_CLOSE_WRITE) flags.push_back(fsw_event_flag::CloseWrite);
-      if (mask & FAN_ATTRIB) flags.push_back(fsw_event_flag::AttributeModified);
-      if (mask & FAN_DELETE) flags.push_back(fsw_event_flag::Removed);
-      if (mask & FAN_DELETE_SELF) flags.push_back(fsw_event_flag::Removed);
+      event_flag_set flags;
+
+      if (mask & FAN_ONDIR) flags.insert(fsw_event_flag::IsDir);
+      if (mask & FAN_CREATE) flags.insert(fsw_event_flag::Created);
+      if (mask & FAN_MODIFY) flags.insert(fsw_event_flag::Updated);
+      if (mask & FAN_CLOSE_WRITE) flags.insert(fsw_event_flag::CloseWrite);
+      if (mask & FAN_ATTRIB) flags.insert(fsw_event_flag::AttributeModified);
+      if (mask & FAN_DELETE) flags.insert(fsw_event_flag::Removed);
+      if (mask & FAN_DELETE_SELF) flags.insert(fsw_event_flag::Removed);
       if (mask & FAN_MOVED_FROM)
       {
-        flags.push_back(fsw_event_flag::Removed);
-        flags.push_back(fsw_event_flag::MovedFrom);
+        flags.insert(fsw_event_flag::Removed);
+        flags.insert(fsw_event_flag::MovedFrom);
       }
       if (mask & FAN_MOVED_TO)
       {
-        flags.push_back(fsw_event_flag::Created);
-        flags.push_back(fsw_event_flag::MovedTo);
+        flags.insert(fsw_event_flag::Created);
+        flags.insert(fsw_event_flag::MovedTo);
       }
-      if (mask & FAN_MOVE_SELF) flags.push_back(fsw_event_flag::Renamed);
-      if (mask & FAN_ACCESS) flags.push_back(fsw_event_flag::PlatformSpecific);
-      if (mask & FAN_OPEN) flags.push_back(fsw_event_flag::PlatformSpecific);
-      if (mask & FAN_CLOSE_NOWRITE) flags.push_back(fsw_event_flag::PlatformSpecific);
+      if (mask & FAN_MOVE_SELF) flags.insert(fsw_event_flag::Renamed);
+      if (mask & FAN_ACCESS) flags.insert(fsw_event_flag::PlatformSpecific);
+      if (mask & FAN_OPEN) flags.insert(fsw_event_flag::PlatformSpecific);
+      if (mask & FAN_CLOSE_NOWRITE) flags.insert(fsw_event_flag::PlatformSpecific);
 
       return flags;
     }
@@ -234,6 +262,26 @@ namespace fsw
     {
       return (mask & FAN_ONDIR) != 0;
     }
+
+    static bool has_entry_name(uint8_t info_type)
+    {
+#if defined(FAN_RENAME)
+      if (info_type == FAN_EVENT_INFO_TYPE_OLD_DFID_NAME ||
+          info_type == FAN_EVENT_INFO_TYPE_NEW_DFID_NAME)
+        return true;
+#endif
+
+      return info_type == FAN_EVENT_INFO_TYPE_DFID_NAME;
+    }
+
+    static bool is_rename_target(uint8_t info_type)
+    {
+#if defined(FAN_RENAME)
+      return info_type == FAN_EVENT_INFO_TYPE_NEW_DFID_NAME;
+#else
+      return false;
+#endif
+    }
   }
 
   struct fanotify_monitor_impl
@@ -243,14 +291,44 @@ namespace fsw
     scoped_fd wake_fd;
     std::vector<event> events;
     std::vector<int> pidfds_to_close;
-    std::unordered_set<std::string> watched_paths;
-    std::unordered_map<std::string, std::string> handle_to_path;
+    // The marked paths, and their nodes by directory handle.
+    path_tree watched_paths;
+    file_handle_table<path_tree::node_id> handle_to_path;
     std::vector<std::string> paths_to_rescan;
     std::vector<std::string> paths_to_fire_create;
+    /*
+     * The root paths are not polled: the handles of the marked roots are
+     * tracked to find out when a root is removed, and the roots that do not
+     * exist are retried when their anchor, the nearest existing ancestor, is
+     * changed.  Anchors that are not marked directories are marked only to
+     * report the creation of their children, and are kept with their path to
+     * remove the mark.
+     */
+    std::unordered_multimap<file_handle_key, std::string, file_handle_key_hash> root_handles;
+    std::unordered_map<file_handle_key, std::string, file_handle_key_hash> anchor_handles;
+    missing_root_set<file_handle_key, file_handle_key_hash> missing_roots;
+    std::vector<std::string> roots_to_retry;
+    /*
+     * With filesystem and mount marks, the directories are not marked: the
+     * path of the directory of an event is resolved from its handle, opening
+     * it from a descriptor of its filesystem, and the events outside the
+     * watched paths are discarded.
+     */
+    mark_scope scope = mark_scope::inode;
+    std::vector<scoped_root> scoped_roots;
+    /*
+     * The handles are opened from a descriptor of their filesystem, by
+     * filesystem ID.  The most recently resolved paths are cached, and are
+     * invalidated when their directory is moved or removed.
+     */
+    std::unordered_map<std::uint64_t, scoped_fd> mount_fds;
+    handle_path_cache handle_cache;
     process_id_kind process_kind = process_id_kind::pid;
     bool report_pidfd = false;
+    bool report_renames = false;
     bool initialized = false;
     time_t curr_time = 0;
+    size_t scan_threads = 1;
   };
 
   fanotify_monitor::fanotify_monitor(std::vector<std::string> paths_to_monitor,
@@ -289,6 +367,31 @@ namespace fsw
     }
 
     impl->report_pidfd = string_to_bool(get_property(REPORT_PIDFD_PROPERTY));
+    impl->scan_threads = get_scan_threads();
+
+    const std::string mark_scope_property = get_property(MARK_SCOPE_PROPERTY);
+    if (mark_scope_property.empty() || mark_scope_property == "inode")
+      impl->scope = mark_scope::inode;
+    else if (mark_scope_property == "filesystem")
+      impl->scope = mark_scope::filesystem;
+    else if (mark_scope_property == "mount")
+      impl->scope = mark_scope::mount;
+    else
+      throw libfsw_exception(std::string(_("Invalid value: ")) + mark_scope_property);
+
+    // Mount marks do not report the renames.
+    impl->report_renames =
+      string_to_bool(get_property(REPORT_RENAMES_PROPERTY)) && impl->scope != mark_scope::mount;
+
+#if !defined(FAN_RENAME)
+    if (impl->report_renames)
+      throw libfsw_exception(std::string(REPORT_RENAMES_PROPERTY) +
+                             "=true requires FAN_RENAME support in the build headers.");
+#endif
+
+    // Mount marks do not report the moves and removals that invalidate the
+    // cached paths.
+    impl->handle_cache.set_capacity(impl->scope == mark_scope::mount ? 0 : get_handle_cache_size());
 
     if (impl->report_pidfd && impl->process_kind == process_id_kind::tid)
       throw libfsw_exception(_("fanotify.report-pidfd=true is incompatible with fanotify.process-id=tid."));
@@ -344,6 +447,16 @@ namespace fsw
       throw libfsw_exception(_("Cannot initialize fanotify."));
     }
 
+    // Kernels not supporting FAN_RENAME reject it as an invalid mask before
+    // looking for the mark to remove.
+    if (impl->report_renames &&
+        fanotify_mark(fanotify_fd.get(), FAN_MARK_REMOVE, RENAME_EVENT_MASK, AT_FDCWD, "/") != 0 &&
+        errno == EINVAL)
+    {
+      throw libfsw_exception(std::string(REPORT_RENAMES_PROPERTY) +
+                             "=true requires FAN_RENAME support in the kernel (Linux 5.17).");
+    }
+
     scoped_fd wake_fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
     if (wake_fd.get() < 0)
     {
@@ -367,12 +480,27 @@ namespace fsw
     impl->initialized = true;
   }
 
+  size_t fanotify_monitor::get_scan_threads()
+  {
+    return get_unsigned_property(SCAN_THREADS_PROPERTY, directory_walker::default_thread_count(), 1);
+  }
+
+  size_t fanotify_monitor::get_handle_cache_size()
+  {
+    return get_unsigned_property(HANDLE_CACHE_SIZE_PROPERTY, handle_path_cache::DEFAULT_CAPACITY);
+  }
+
+  size_t fanotify_monitor::get_buffer_size()
+  {
+    return get_unsigned_property(BUFFER_SIZE_PROPERTY, DEFAULT_BUFFER_SIZE, MAX_EVENT_SIZE);
+  }
+
   bool fanotify_monitor::is_watched(const std::string& path) const
   {
-    return impl->watched_paths.find(path) != impl->watched_paths.end();
+    return impl->watched_paths.find(path) != path_tree::npos;
   }
 
-  bool fanotify_monitor::add_mark(const std::filesystem::path& path)
+  uint64_t fanotify_monitor::get_event_mask() const
   {
     uint64_t event_mask =
       FAN_MODIFY | FAN_CLOSE_WRITE | FAN_ATTRIB |
@@ -385,9 +513,22 @@ namespace fsw
       event_mask |= FAN_ACCESS | FAN_OPEN | FAN_CLOSE_NOWRITE;
     }
 
+    if (impl->report_renames)
+    {
+      event_mask &= ~(FAN_MOVED_FROM | FAN_MOVED_TO);
+      event_mask |= RENAME_EVENT_MASK;
+    }
+
+    if (impl->scope == mark_scope::mount) event_mask &= MOUNT_EVENT_MASK;
+
+    return event_mask;
+  }
+
+  bool fanotify_monitor::add_mark(const std::filesystem::path& path)
+  {
     if (fanotify_mark(impl->fanotify_fd.get(),
                       FAN_MARK_ADD,
-                      event_mask,
+                      get_event_mask(),
                       AT_FDCWD,
                       path.c_str()) != 0)
     {
@@ -395,12 +536,13 @@ namespace fsw
       return false;
     }
 
-    impl->watched_paths.insert(path.string());
+    const path_tree::node_id node = impl->watched_paths.insert(path.string());
 
-    std::string handle_key;
+    file_handle_key handle_key;
     if (get_path_handle(path, handle_key))
     {
-      impl->handle_to_path[handle_key] = path.string();
+      impl->handle_to_path.insert_or_assign(handle_key, node);
+      add_mount_fd(handle_key.get_fsid(), path.string());
     }
 
     FSW_ELOGF(_("fanotify added: %s\n"), path.c_str());
@@ -408,45 +550,338 @@ namespace fsw
   }
 
   void fanotify_monitor::scan(const std::filesystem::path& path, const bool is_root_path)
+  {
+    directory_walker walker([this, is_root_path](const std::filesystem::path& p,
+                                                         entry_type type,
+                                                         bool is_walk_root)
+                            {
+                              return visit_path(p, type, is_root_path && is_walk_root);
+                            },
+                            impl->scan_threads);
+
+    const walk_statistics statistics = walker.walk(path);
+
+    if (is_root_path)
+    {
+      FSW_ELOGF(_("Scanned %s: %zu directories in %.3f s using %zu threads.\n"),
+                path.c_str(),
+                statistics.directories,
+                std::chrono::duration<double>(statistics.elapsed).count(),
+                statistics.threads);
+    }
+  }
+
+  std::optional<std::filesystem::path> fanotify_monitor::visit_path(const std::filesystem::path& path,
+                                                                    entry_type type,
+                                                                    const bool is_root_path)
   {
     try
     {
-      auto status = std::filesystem::symlink_status(path);
+      if (type == entry_type::unknown) type = get_entry_type(path.string());
+      if (type == entry_type::unknown) return std::nullopt;
 
-      if (!std::filesystem::exists(status)) return;
+      if (follow_symlinks && type == entry_type::symlink)
+        return visit_path(std::filesystem::read_symlink(path), entry_type::unknown, is_root_path);
 
-      if (follow_symlinks && std::filesystem::is_symlink(status))
+      const bool is_dir = type == entry_type::directory;
+      if (should_prune_path(path.string(), is_dir, is_root_path)) return std::nullopt;
+      if (!is_dir && !is_root_path) return std::nullopt;
+      if (!is_dir && directory_only) return std::nullopt;
+      if (is_watched(path.string())) return std::nullopt;
+      if (!add_mark(path)) return std::nullopt;
+      if (!recursive || !is_dir) return std::nullopt;
+
+      return path;
+    }
+    catch (const std::filesystem::filesystem_error& e)
+    {
+      FSW_ELOGF(_("Filesystem error: %s"), e.what());
+    }
+
+    return std::nullopt;
+  }
+
+  void fanotify_monitor::scan_root_paths()
+  {
+    for (const std::string& path : paths)
+    {
+      if (impl->scope == mark_scope::inode) watch_root(path);
+      else add_scope_mark(path);
+    }
+  }
+
+  void fanotify_monitor::add_scope_mark(const std::string& root)
+  {
+    // The filesystem of a missing root is the filesystem of its nearest
+    // existing ancestor, whose mark reports the root as soon as it exists.
+    const std::string marked_path =
+      get_entry_type(root) != entry_type::unknown ? root : find_anchor_path(root);
+
+    const unsigned int mark_type =
+      impl->scope == mark_scope::filesystem ? FAN_MARK_FILESYSTEM : FAN_MARK_MOUNT;
+
+    if (marked_path.empty() ||
+        fanotify_mark(impl->fanotify_fd.get(),
+                      FAN_MARK_ADD | mark_type,
+                      get_event_mask(),
+                      AT_FDCWD,
+                      marked_path.c_str()) != 0)
+    {
+      fsw_logf_perror(_("Cannot mark %s"), marked_path.c_str());
+      throw libfsw_exception(std::string(_("Cannot mark the filesystem of ")) + root +
+                             _(": filesystem and mount marks require CAP_SYS_ADMIN."));
+    }
+
+    struct statfs fs_stats{};
+    if (statfs(marked_path.c_str(), &fs_stats) == 0)
+      add_mount_fd(file_handle_key::to_fsid(&fs_stats.f_fsid, sizeof(fs_stats.f_fsid)), marked_path);
+
+    // The resolved paths do not contain symbolic links.
+    std::error_code error;
+    std::string real_path = std::filesystem::weakly_canonical(root, error).string();
+    if (error) real_path = root;
+    while (real_path.size() > 1 && real_path.back() == '/') real_path.pop_back();
+
+    std::string path = root;
+    while (path.size() > 1 && path.back() == '/') path.pop_back();
+
+    FSW_ELOGF(_("fanotify marked the %s of %s.\n"),
+              impl->scope == mark_scope::filesystem ? "filesystem" : "mount",
+              root.c_str());
+
+    impl->scoped_roots.push_back({std::move(path), std::move(real_path)});
+  }
+
+  void fanotify_monitor::add_mount_fd(const std::uint64_t fsid, const std::string& path)
+  {
+    if (impl->mount_fds.find(fsid) != impl->mount_fds.end()) return;
+
+    // The handles of a filesystem are opened from a descriptor of any of its
+    // objects, which cannot be an O_PATH descriptor.
+    scoped_fd mount_fd(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (mount_fd.get() >= 0) impl->mount_fds.emplace(fsid, std::move(mount_fd));
+  }
+
+  bool fanotify_monitor::resolve_directory(const file_handle_key& handle_key,
+                                           struct file_handle *handle,
+                                           std::string& path)
+  {
+    if (const std::string *cached_path = impl->handle_cache.find(handle_key))
+    {
+      path = *cached_path;
+      return true;
+    }
+
+    const auto mount_fd = impl->mount_fds.find(handle_key.get_fsid());
+    if (mount_fd == impl->mount_fds.end()) return false;
+
+    scoped_fd directory_fd(open_by_handle_at(mount_fd->second.get(), handle, O_PATH | O_CLOEXEC));
+    if (directory_fd.get() < 0)
+    {
+      // The directory may have been removed in the meantime.
+      if (errno != ESTALE) fsw_log_perror("open_by_handle_at");
+      return false;
+    }
+
+    std::array<char, PATH_MAX> link{};
+    const std::string fd_path = "/proc/self/fd/" + std::to_string(directory_fd.get());
+    const ssize_t length = readlink(fd_path.c_str(), link.data(), link.size());
+    if (length <= 0 || static_cast<size_t>(length) == link.size()) return false;
+
+    path.assign(link.data(), static_cast<size_t>(length));
+
+    const size_t suffix_length = sizeof(DELETED_SUFFIX) - 1;
+    if (path[0] != '/' ||
+        (path.size() > suffix_length &&
+         path.compare(path.size() - suffix_length, suffix_length, DELETED_SUFFIX) == 0))
+    {
+      return false;
+    }
+
+    impl->handle_cache.insert(handle_key, path);
+    return true;
+  }
+
+  void fanotify_monitor::invalidate_directory(const file_handle_key& handle_key)
+  {
+    // The paths of the directories in a moved directory are stale as well.
+    const std::string *cached_path = impl->handle_cache.find(handle_key);
+    if (cached_path == nullptr) return;
+
+    const std::string path = *cached_path;
+    impl->handle_cache.erase_tree(path);
+  }
+
+  bool fanotify_monitor::get_scoped_path(std::string& path) const
+  {
+    for (const scoped_root& root : impl->scoped_roots)
+    {
+      if (path == root.real_path)
       {
-        scan(std::filesystem::read_symlink(path), is_root_path);
-        return;
+        path = root.path;
+        return true;
       }
 
-      const bool is_dir = std::filesystem::is_directory(status);
-      if (should_prune_path(path.string(), is_dir, is_root_path)) return;
-      if (!is_dir && !is_root_path) return;
-      if (!is_dir && directory_only) return;
-      if (is_watched(path.string())) return;
-      if (!add_mark(path)) return;
-      if (!recursive || !is_dir) return;
+      const bool is_filesystem_root = root.real_path == "/";
+      if (path.compare(0, root.real_path.size(), root.real_path) != 0) continue;
+      if (!is_filesystem_root && path[root.real_path.size()] != '/') continue;
+
+      const size_t relative_start = root.real_path.size() + (is_filesystem_root ? 0 : 1);
+      const size_t name_start = path.rfind('/') + 1;
+
+      // Without recursion, only the children of the root are reported.
+      if (!recursive && name_start != relative_start) continue;
 
-      const auto entries = get_subdirectories(path);
-      for (const auto& entry : entries)
+      std::string scoped_path = root.path;
+      if (scoped_path.back() != '/') scoped_path.append(1, '/');
+      scoped_path.append(path, relative_start, std::string::npos);
+
+      // The events in pruned directories are discarded, as if the directories
+      // were not marked.
+      const size_t scoped_start = scoped_path.size() - (path.size() - relative_start);
+      bool pruned = false;
+
+      for (size_t separator = scoped_path.find('/', scoped_start);
+           separator != std::string::npos && !pruned;
+           separator = scoped_path.find('/', separator + 1))
       {
-        scan(entry, false);
+        pruned = should_prune_path(scoped_path.substr(0, separator), true, false);
       }
+
+      if (pruned) continue;
+
+      path = std::move(scoped_path);
+      return true;
     }
-    catch (const std::filesystem::filesystem_error& e)
+
+    return false;
+  }
+
+  void fanotify_monitor::watch_root(const std::string& root)
+  {
+    // The anchor is marked before checking again whether the root exists, so
+    // that a root created in the meantime is not missed.
+    if (get_entry_type(root) == entry_type::unknown)
     {
-      FSW_ELOGF(_("Filesystem error: %s"), e.what());
+      anchor_root(root);
+      if (get_entry_type(root) == entry_type::unknown) return;
+    }
+
+    impl->missing_roots.erase(root);
+    if (!is_watched(root)) scan(root, true);
+
+    std::filesystem::path marked_path = root;
+    if (follow_symlinks && get_entry_type(root) == entry_type::symlink)
+    {
+      std::error_code error;
+      marked_path = std::filesystem::read_symlink(root, error);
+      if (error) return;
     }
+
+    file_handle_key handle_key;
+    if (!is_watched(marked_path.string()) || !get_path_handle(marked_path, handle_key)) return;
+
+    const auto range = impl->root_handles.equal_range(handle_key);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      if (it->second == root) return;
+    }
+
+    impl->root_handles.emplace(std::move(handle_key), root);
   }
 
-  void fanotify_monitor::scan_root_paths()
+  void fanotify_monitor::anchor_root(const std::string& root)
   {
-    for (const std::string& path : paths)
+    const std::string anchor = find_anchor_path(root);
+    file_handle_key handle_key;
+    bool anchored = !anchor.empty() && get_path_handle(anchor, handle_key);
+
+    // Adding a mark extends the mask of an existing mark of the directory.
+    if (anchored && !impl->handle_to_path.contains(handle_key))
     {
-      if (!is_watched(path)) scan(path, true);
+      anchored = fanotify_mark(impl->fanotify_fd.get(),
+                               FAN_MARK_ADD | FAN_MARK_ONLYDIR,
+                               ANCHOR_EVENT_MASK,
+                               AT_FDCWD,
+                               anchor.c_str()) == 0;
+
+      if (!anchored) fsw_logf_perror(_("Cannot mark %s"), anchor.c_str());
+      else impl->anchor_handles.emplace(handle_key, anchor);
     }
+
+    const auto now = std::chrono::steady_clock::now();
+
+    if (!anchored)
+    {
+      FSW_ELOGF(_("Missing root %s: retrying with a backoff.\n"), root.c_str());
+      impl->missing_roots.insert(root, std::nullopt, now);
+      return;
+    }
+
+    FSW_ELOGF(_("Missing root %s: watching %s.\n"), root.c_str(), anchor.c_str());
+    impl->missing_roots.insert(root, handle_key, now);
+  }
+
+  void fanotify_monitor::retry_missing_roots()
+  {
+    if (impl->missing_roots.empty() && impl->roots_to_retry.empty()) return;
+
+    std::vector<std::string> roots = std::move(impl->roots_to_retry);
+    impl->roots_to_retry.clear();
+
+    for (std::string& root : impl->missing_roots.get_due(std::chrono::steady_clock::now()))
+      roots.push_back(std::move(root));
+
+    std::sort(roots.begin(), roots.end());
+    roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+
+    for (const std::string& root : roots) watch_root(root);
+
+    release_anchors();
+  }
+
+  void fanotify_monitor::release_anchors()
+  {
+    auto it = impl->anchor_handles.begin();
+
+    while (it != impl->anchor_handles.end())
+    {
+      if (impl->missing_roots.is_anchor(it->first))
+      {
+        ++it;
+        continue;
+      }
+
+      // The directory may have been marked as part of a watched tree, in which
+      // case the anchor events are part of its mask.  The path of the anchor
+      // may be stale, in which case the mark is left until the directory is
+      // removed.
+      if (!impl->handle_to_path.contains(it->first))
+      {
+        fanotify_mark(impl->fanotify_fd.get(),
+                      FAN_MARK_REMOVE | FAN_MARK_ONLYDIR,
+                      ANCHOR_EVENT_MASK,
+                      AT_FDCWD,
+                      it->second.c_str());
+      }
+
+      it = impl->anchor_handles.erase(it);
+    }
+  }
+
+  void fanotify_monitor::forget_directory(const file_handle_key& handle_key)
+  {
+    const path_tree::node_id *node = impl->handle_to_path.find(handle_key);
+    if (node == nullptr) return;
+
+    impl->watched_paths.release(*node);
+    impl->handle_to_path.erase(handle_key);
+
+    // A removed root is marked again as soon as it exists.
+    const auto roots = impl->root_handles.equal_range(handle_key);
+    for (auto root = roots.first; root != roots.second; ++root)
+      impl->roots_to_retry.push_back(root->second);
+    impl->root_handles.erase(roots.first, roots.second);
   }
 
   void fanotify_monitor::process_pending_paths()
@@ -457,6 +892,8 @@ namespace fsw
     }
 
     impl->paths_to_rescan.clear();
+
+    retry_missing_roots();
   }
 
   void fanotify_monitor::process_synthetic_events()
@@ -465,22 +902,26 @@ namespace fsw
     {
       FSW_ELOGF(_("Synthetic event: processing directory: %s\n"), path.c_str());
 
-      const auto entries = get_directory_entries(path);
+      directory_reader reader(path);
+      directory_entry_info entry;
 
-      for (const auto& entry : entries)
+      while (reader.next(entry))
       {
-        std::vector<fsw_event_flag> flags{fsw_event_flag::Created};
+        event_flag_set flags{fsw_event_flag::Created};
 
-        try
-        {
-          if (entry.is_directory()) flags.push_back(fsw_event_flag::IsDir);
-        }
-        catch (const std::filesystem::filesystem_error& e)
+        // Symbolic links to directories are reported as directories.
+        bool is_dir = entry.type == entry_type::directory;
+        if (entry.type == entry_type::symlink)
         {
-          FSW_ELOGF(_("Filesystem error: %s"), e.what());
+          struct stat fd_stat;
+          is_dir = reader.stat(entry.name, fd_stat, true) && S_ISDIR(fd_stat.st_mode);
         }
 
-        impl->events.emplace_back(entry.path().string(), impl->curr_time, flags);
+        if (is_dir) flags.insert(fsw_event_flag::IsDir);
+
+        impl->events.emplace_back((std::filesystem::path(path) / entry.name).string(),
+                                  impl->curr_time,
+                                  flags);
       }
     }
 
@@ -505,6 +946,11 @@ namespace fsw
       }
 
       std::string path;
+      std::string target_path;
+      file_handle_key self_key;
+      bool anchor_only = false;
+      bool out_of_scope = false;
+      bool target_out_of_scope = false;
       int pidfd = -1;
       bool has_pidfd = false;
 
@@ -521,25 +967,120 @@ namespace fsw
         case FAN_EVENT_INFO_TYPE_DFID_NAME:
         case FAN_EVENT_INFO_TYPE_DFID:
         case FAN_EVENT_INFO_TYPE_FID:
+#if defined(FAN_RENAME)
+        case FAN_EVENT_INFO_TYPE_OLD_DFID_NAME:
+        case FAN_EVENT_INFO_TYPE_NEW_DFID_NAME:
+#endif
         {
           auto *fid = reinterpret_cast<struct fanotify_event_info_fid *>(info);
           auto *file_handle = reinterpret_cast<struct file_handle *>(fid->handle);
-          std::string handle_key = make_handle_key(&fid->fsid, sizeof(fid->fsid), file_handle);
 
-          auto cached_path = impl->handle_to_path.find(handle_key);
-          if (cached_path == impl->handle_to_path.end()) break;
+          const file_handle_key handle_key = make_handle_key(&fid->fsid, sizeof(fid->fsid), file_handle);
 
-          path = cached_path->second;
+          // The destination of a rename is resolved into a path of its own.
+          const bool is_target = is_rename_target(info->info_type);
+          std::string& record_path = is_target ? target_path : path;
+          bool& record_out_of_scope = is_target ? target_out_of_scope : out_of_scope;
+          bool& record_anchor_only = is_target ? target_out_of_scope : anchor_only;
 
-          if (info->info_type == FAN_EVENT_INFO_TYPE_DFID_NAME)
+          if (impl->scope != mark_scope::inode)
           {
-            const char *name = reinterpret_cast<const char *>(
-              file_handle->f_handle + file_handle->handle_bytes);
+            if (metadata->mask & (FAN_DELETE_SELF | FAN_MOVE_SELF)) invalidate_directory(handle_key);
 
-            if (name[0] != '\0' && std::strcmp(name, ".") != 0)
+            if (!resolve_directory(handle_key, file_handle, record_path))
             {
-              path = (std::filesystem::path(path) / name).string();
+              record_out_of_scope = true;
+              break;
             }
+
+            if (has_entry_name(info->info_type))
+            {
+              const char *name = reinterpret_cast<const char *>(
+                file_handle->f_handle + file_handle->handle_bytes);
+
+              if (std::strcmp(name, ".") != 0)
+              {
+                if (record_path.back() != '/') record_path.append(1, '/');
+                record_path.append(name);
+              }
+            }
+
+            // The directory may be moved before its own event is received.
+            const bool is_move_source =
+              (metadata->mask & FAN_MOVED_FROM) || ((metadata->mask & RENAME_EVENT_MASK) && !is_target);
+            if (is_move_source && is_directory_event(metadata->mask))
+              impl->handle_cache.erase_tree(record_path);
+
+            // The events outside the watched paths are discarded.
+            record_out_of_scope = !get_scoped_path(record_path);
+            break;
+          }
+
+          if (!impl->missing_roots.empty() &&
+              (metadata->mask & (ANCHOR_EVENT_MASK | RENAME_EVENT_MASK) & ~FAN_ONDIR) &&
+              impl->missing_roots.is_anchor(handle_key))
+          {
+            for (std::string& root : impl->missing_roots.get_anchored(handle_key))
+              impl->roots_to_retry.push_back(std::move(root));
+          }
+
+          const path_tree::node_id *cached_path = impl->handle_to_path.find(handle_key);
+          if (cached_path == nullptr)
+          {
+            // The events of the directories marked only as anchors are not
+            // notified, and their mark is gone once they are removed.
+            auto anchor = impl->anchor_handles.find(handle_key);
+            if (anchor != impl->anchor_handles.end())
+            {
+              record_anchor_only = true;
+              if (metadata->mask & FAN_DELETE_SELF) impl->anchor_handles.erase(anchor);
+              break;
+            }
+
+            // The handle of a marked directory is unknown if it could not be
+            // read when the directory was marked, or if the directory was
+            // moved: the directory is looked up by the path it is resolved to,
+            // and is dropped if it is no longer watched.
+            if (metadata->mask & (FAN_DELETE_SELF | FAN_MOVE_SELF)) invalidate_directory(handle_key);
+
+            std::string resolved_path;
+            if (!resolve_directory(handle_key, file_handle, resolved_path)) break;
+
+            const path_tree::node_id node = impl->watched_paths.find(resolved_path);
+            if (node == path_tree::npos)
+            {
+              record_out_of_scope = true;
+              break;
+            }
+
+            FSW_ELOGF(_("fanotify resolved the handle of %s.\n"), resolved_path.c_str());
+            cached_path = &impl->handle_to_path.insert_or_assign(handle_key, node);
+          }
+
+          if (metadata->mask & (FAN_DELETE_SELF | FAN_MOVE_SELF))
+          {
+            invalidate_directory(handle_key);
+            self_key = handle_key;
+          }
+
+          const char *name = "";
+          if (has_entry_name(info->info_type))
+          {
+            name = reinterpret_cast<const char *>(
+              file_handle->f_handle + file_handle->handle_bytes);
+            if (std::strcmp(name, ".") == 0) name = "";
+          }
+
+          // The path of the directory is materialized only now that the event
+          // is known to refer to a watched directory.
+          const size_t name_length = std::strlen(name);
+          record_path.clear();
+          impl->watched_paths.append_path(*cached_path, record_path, 1 + name_length);
+
+          if (name_length > 0)
+          {
+            if (record_path.empty() || record_path.back() != '/') record_path.append(1, '/');
+            record_path.append(name, name_length);
           }
 
           break;
@@ -565,13 +1106,53 @@ namespace fsw
           reinterpret_cast<char *>(info) + info->len);
       }
 
+      uint64_t mask = metadata->mask;
+
+      /*
+       * A rename whose source and destination are both watched is reported as
+       * a single event, and as a move out of or into the watched paths if
+       * only one of them is.
+       */
+      if (mask & RENAME_EVENT_MASK)
+      {
+        const bool has_source = !anchor_only && !out_of_scope && !path.empty();
+        const bool has_target = !target_out_of_scope && !target_path.empty();
+
+        mask &= ~RENAME_EVENT_MASK;
+        if (has_source) mask |= FAN_MOVED_FROM;
+        if (has_target) mask |= FAN_MOVED_TO;
+
+        if (!has_source) path = std::move(target_path);
+        if (!has_source || !has_target) target_path.clear();
+
+        anchor_only = false;
+        out_of_scope = !has_source && !has_target;
+      }
+
+      if (anchor_only || out_of_scope) continue;
+
       if (path.empty())
       {
         FSW_ELOG(_("fanotify event path could not be reconstructed.\n"));
         continue;
       }
 
-      std::vector<fsw_event_flag> flags = flags_from_mask(metadata->mask);
+      // A removed or moved directory is no longer watched at its path.
+      if (!self_key.empty()) forget_directory(self_key);
+
+      event_flag_set flags;
+      if (target_path.empty())
+      {
+        flags = flags_from_mask(mask);
+      }
+      else
+      {
+        flags = flags_from_mask(mask & ~(FAN_MOVED_FROM | FAN_MOVED_TO));
+        flags.insert(fsw_event_flag::Renamed);
+        flags.insert(fsw_event_flag::MovedFrom);
+        flags.insert(fsw_event_flag::MovedTo);
+      }
+
       if (flags.empty()) continue;
 
       process_metadata process;
@@ -583,23 +1164,38 @@ namespace fsw
       process.pidfd = pidfd;
       process.has_pidfd = has_pidfd;
 
-      if (recursive &&
-          is_directory_event(metadata->mask) &&
-          (metadata->mask & (FAN_CREATE | FAN_MOVED_TO)))
+      /*
+       * With filesystem marks, the directories created in the watched trees
+       * are not marked, and their entries are reported by the mark, except
+       * those of the directories moved into the watched trees.
+       */
+      const std::string& destination = target_path.empty() ? path : target_path;
+
+      if (recursive && is_directory_event(mask))
       {
-        impl->paths_to_rescan.push_back(path);
-        impl->paths_to_fire_create.push_back(path);
+        if (impl->scope == mark_scope::inode && (mask & (FAN_CREATE | FAN_MOVED_TO)))
+        {
+          impl->paths_to_rescan.push_back(destination);
+          impl->paths_to_fire_create.push_back(destination);
+        }
+        else if (impl->scope != mark_scope::inode && (mask & FAN_MOVED_TO))
+        {
+          impl->paths_to_fire_create.push_back(destination);
+        }
       }
 
-      impl->events.emplace_back(path, impl->curr_time, flags, 0, process);
+      impl->events.emplace_back(std::move(path), impl->curr_time, flags, 0, process);
+      if (!target_path.empty()) impl->events.back().set_secondary_path(std::move(target_path));
     }
   }
 
   void fanotify_monitor::notify_and_clear_events()
   {
+    // The events are filtered and delivered in place, so that the next batch
+    // reuses the capacity of the vector.
     if (!impl->events.empty())
     {
-      notify_events(impl->events);
+      notify_events(std::move(impl->events));
       impl->events.clear();
     }
 
@@ -631,12 +1227,14 @@ namespace fsw
 
   void fanotify_monitor::run()
   {
+    std::vector<char> buffer(get_buffer_size());
+
     initialize();
 
-    const int timeout_ms = latency_to_timeout_ms(this->latency);
-    std::array<char, FANOTIFY_BUFFER_SIZE> buffer{};
     std::array<struct epoll_event, EPOLL_EVENT_COUNT> epoll_events{};
 
+    scan_root_paths();
+
     for (;;)
     {
       std::unique_lock<std::mutex> run_guard(run_mutex);
@@ -644,36 +1242,12 @@ namespace fsw
       run_guard.unlock();
 
       process_pending_paths();
-      scan_root_paths();
 
-      if (impl->watched_paths.empty())
-      {
-        int rv = epoll_wait(impl->epoll_fd.get(),
-                            epoll_events.data(),
-                            epoll_events.size(),
-                            timeout_ms);
-
-        if (rv == -1)
-        {
-          if (errno == EINTR) continue;
-          fsw_log_perror("epoll_wait");
-          continue;
-        }
-
-        if (rv > 0)
-        {
-          for (int i = 0; i < rv; ++i)
-          {
-            if (epoll_events[i].data.fd == impl->wake_fd.get())
-            {
-              drain_eventfd(impl->wake_fd.get());
-              return;
-            }
-          }
-        }
-
-        continue;
-      }
+      // The marks only change in response to events, so that the monitor
+      // sleeps until an event is received, the monitor is stopped, or a
+      // missing root whose anchor could not be marked has to be retried.
+      const int timeout_ms =
+        impl->missing_roots.get_timeout_ms(std::chrono::steady_clock::now());
 
       int rv = epoll_wait(impl->epoll_fd.get(),
                           epoll_events.data(),
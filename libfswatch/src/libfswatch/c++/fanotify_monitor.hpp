@@ -22,15 +22,21 @@
 #  define FSW_FANOTIFY_MONITOR_H
 
 #  include "monitor.hpp"
+#  include "directory_reader.hpp"
 #  include <string>
 #  include <vector>
+#  include <cstdint>
 #  include <filesystem>
 #  include <memory>
+#  include <optional>
 #  include <sys/types.h>
 
+struct file_handle;
+
 namespace fsw
 {
   struct fanotify_monitor_impl;
+  class file_handle_key;
 
   /**
    * @brief Linux fanotify monitor.
@@ -45,6 +51,65 @@ namespace fsw
     static constexpr const char *REPORT_PIDFD_PROPERTY = "fanotify.report-pidfd";
     static constexpr const char *UNLIMITED_QUEUE_PROPERTY = "fanotify.unlimited-queue";
     static constexpr const char *UNLIMITED_MARKS_PROPERTY = "fanotify.unlimited-marks";
+    /**
+     * @brief Name of the property setting the maximum number of threads
+     * listing directories while scanning the watched trees.
+     *
+     * The default is 4.  Marks are added by one thread at a time.  Setting
+     * the property to 1 scans the trees serially.
+     */
+    static constexpr const char *SCAN_THREADS_PROPERTY = "fanotify.scan-threads";
+    /**
+     * @brief Name of the property setting the scope of the fanotify marks.
+     *
+     * The supported values are:
+     *
+     *   - @c inode: each watched directory is marked, scanning the watched
+     *     trees at startup and when directories are created.  This is the
+     *     default.
+     *   - @c filesystem: the filesystems containing the watched paths are
+     *     marked, and the events are filtered by path.  No directory is
+     *     scanned, but the path of the directory of each event is resolved
+     *     from its file handle, which requires @c CAP_SYS_ADMIN and
+     *     @c CAP_DAC_READ_SEARCH.
+     *   - @c mount: the mounts containing the watched paths are marked, and
+     *     the events are filtered by path.  The kernel only supports the
+     *     modification and access events on mounts, so that the creation,
+     *     removal, renaming and attribute changes are not reported.
+     */
+    static constexpr const char *MARK_SCOPE_PROPERTY = "fanotify.mark-scope";
+    /**
+     * @brief Name of the property setting the maximum number of directory
+     * paths resolved from their file handle kept by the monitor.
+     *
+     * The path of the directory of an event whose file handle is not known,
+     * such as any event received by a filesystem mark, is resolved opening
+     * the directory by handle, and the most recently used paths are cached.
+     * The default is 16384.  Setting the property to 0 disables the cache.
+     */
+    static constexpr const char *HANDLE_CACHE_SIZE_PROPERTY = "fanotify.handle-cache-size";
+    /**
+     * @brief Name of the property setting the size, in bytes, of the buffer
+     * used to read events from the fanotify descriptor.
+     *
+     * The default size is 64 KiB.  Each event carries the file handle and the
+     * name of its directory entry, so that a 4 KiB buffer holds only a few
+     * dozen events.  The size cannot be smaller than the size of the largest
+     * fanotify event.
+     */
+    static constexpr const char *BUFFER_SIZE_PROPERTY = "fanotify.buffer-size";
+    /**
+     * @brief Name of the property requesting the renames to be reported as
+     * single events.
+     *
+     * When the property is @c true, the monitor requests @c FAN_RENAME events
+     * instead of @c FAN_MOVED_FROM and @c FAN_MOVED_TO, and reports a rename
+     * whose source and destination are both watched as a single event whose
+     * path is the source and whose secondary path is the destination.  A
+     * rename out of or into the watched paths is reported as before.
+     * @c FAN_RENAME requires Linux 5.17, and is not supported by mount marks.
+     */
+    static constexpr const char *REPORT_RENAMES_PROPERTY = "fanotify.report-renames";
 
     fanotify_monitor(std::vector<std::string> paths,
                      FSW_EVENT_CALLBACK *callback,
@@ -62,8 +127,27 @@ namespace fsw
 
     void initialize();
     void scan_root_paths();
+    void watch_root(const std::string& root);
+    void anchor_root(const std::string& root);
+    void retry_missing_roots();
+    void release_anchors();
+    void forget_directory(const file_handle_key& handle_key);
     void scan(const std::filesystem::path& path, bool is_root_path = false);
+    std::optional<std::filesystem::path> visit_path(const std::filesystem::path& path,
+                                                    entry_type type,
+                                                    bool is_root_path);
+    size_t get_scan_threads();
+    size_t get_handle_cache_size();
+    size_t get_buffer_size();
+    uint64_t get_event_mask() const;
     bool add_mark(const std::filesystem::path& path);
+    void add_scope_mark(const std::string& root);
+    void add_mount_fd(std::uint64_t fsid, const std::string& path);
+    bool resolve_directory(const file_handle_key& handle_key,
+                           struct file_handle *handle,
+                           std::string& path);
+    void invalidate_directory(const file_handle_key& handle_key);
+    bool get_scoped_path(std::string& path) const;
     bool is_watched(const std::string& path) const;
     void process_pending_paths();
     void process_synthetic_events();
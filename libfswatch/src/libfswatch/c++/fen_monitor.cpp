@@ -135,15 +135,15 @@ namespace fsw
     delete load;
   }
 
-  static vector<fsw_event_flag> decode_flags(uint32_t flag)
+  static event_flag_set decode_flags(uint32_t flag)
   {
-    vector<fsw_event_flag> evt_flags;
+    event_flag_set evt_flags;
 
     for (const FenFlagType &type : event_flag_type)
     {
       if (flag & type.flag)
       {
-        evt_flags.push_back(type.type);
+        evt_flags.insert(type.type);
       }
     }
 
@@ -324,7 +324,7 @@ namespace fsw
     if (event_flags & FILE_DELETE) load->descriptors_to_remove.insert(finfo);
     else load->paths_to_rescan.insert(finfo->fobj.fo_name);
 
-    notify_events(events);
+    notify_events(std::move(events));
   }
 
   void fen_monitor::rescan_removed()
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "file_handle_key.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace fsw
+{
+  namespace
+  {
+    // The mixing steps of splitmix64, which spread the bits of inode numbers
+    // and generations, the usual contents of a handle, to the low bits used
+    // to index the tables.
+    std::uint64_t mix(std::uint64_t hash, std::uint64_t value)
+    {
+      hash ^= value + 0x9e3779b97f4a7c15ULL;
+      hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+
+      return hash ^ (hash >> 31);
+    }
+  }
+
+  file_handle_key::file_handle_key(const void *filesystem_id,
+                                   size_t filesystem_id_size,
+                                   int handle_type,
+                                   const void *handle_bytes,
+                                   size_t handle_size) :
+    fsid(to_fsid(filesystem_id, filesystem_id_size)),
+    type(handle_type),
+    size(static_cast<std::uint32_t>(handle_size))
+  {
+    copy_bytes(handle_bytes);
+
+    std::uint64_t hash = mix(fsid, (static_cast<std::uint64_t>(size) << 32) |
+                                     static_cast<std::uint32_t>(type));
+    const unsigned char *handle = data();
+
+    for (size_t offset = 0; offset < size; offset += sizeof(std::uint64_t))
+    {
+      std::uint64_t word = 0;
+      std::memcpy(&word, handle + offset, std::min(sizeof(word), size - offset));
+      hash = mix(hash, word);
+    }
+
+    hash_value = hash != 0 ? hash : 1;
+  }
+
+  file_handle_key::file_handle_key(const file_handle_key& other) :
+    hash_value(other.hash_value),
+    fsid(other.fsid),
+    type(other.type),
+    size(other.size)
+  {
+    copy_bytes(other.data());
+  }
+
+  file_handle_key::file_handle_key(file_handle_key&& other) noexcept :
+    hash_value(other.hash_value),
+    fsid(other.fsid),
+    type(other.type),
+    size(other.size),
+    storage(other.storage)
+  {
+    other.hash_value = 0;
+    other.size = 0;
+  }
+
+  file_handle_key& file_handle_key::operator=(const file_handle_key& other)
+  {
+    if (this != &other) *this = file_handle_key(other);
+
+    return *this;
+  }
+
+  file_handle_key& file_handle_key::operator=(file_handle_key&& other) noexcept
+  {
+    if (this != &other)
+    {
+      release();
+      hash_value = other.hash_value;
+      fsid = other.fsid;
+      type = other.type;
+      size = other.size;
+      storage = other.storage;
+      other.hash_value = 0;
+      other.size = 0;
+    }
+
+    return *this;
+  }
+
+  file_handle_key::~file_handle_key()
+  {
+    release();
+  }
+
+  std::string file_handle_key::to_string() const
+  {
+    std::string key;
+    key.reserve(sizeof(fsid) + sizeof(type) + sizeof(size) + size);
+    key.append(reinterpret_cast<const char *>(&fsid), sizeof(fsid));
+    key.append(reinterpret_cast<const char *>(&type), sizeof(type));
+    key.append(reinterpret_cast<const char *>(&size), sizeof(size));
+    key.append(reinterpret_cast<const char *>(data()), size);
+
+    return key;
+  }
+
+  bool file_handle_key::operator==(const file_handle_key& other) const
+  {
+    return hash_value == other.hash_value &&
+           fsid == other.fsid &&
+           type == other.type &&
+           size == other.size &&
+           std::memcmp(data(), other.data(), size) == 0;
+  }
+
+  std::uint64_t file_handle_key::to_fsid(const void *fsid, size_t fsid_size)
+  {
+    std::uint64_t id = 0;
+    std::memcpy(&id, fsid, std::min(sizeof(id), fsid_size));
+
+    return id;
+  }
+
+  void file_handle_key::copy_bytes(const void *bytes)
+  {
+    if (size == 0) return;
+
+    if (size <= INLINE_SIZE)
+    {
+      std::memcpy(storage.bytes, bytes, size);
+      return;
+    }
+
+    storage.heap = new unsigned char[size];
+    std::memcpy(storage.heap, bytes, size);
+  }
+
+  void file_handle_key::release()
+  {
+    if (size > INLINE_SIZE) delete[] storage.heap;
+
+    size = 0;
+  }
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file
+ * @brief Header of the fsw::file_handle_key class.
+ *
+ * This header file defines the fsw::file_handle_key class, the key
+ * identifying a file by its file handle and the ID of its filesystem, used by
+ * the fanotify monitor to match events to directories.
+ *
+ * @copyright Copyright (c) 2026 Enrico M. Crisostomo
+ * @license GNU General Public License v. 3.0
+ * @author Enrico M. Crisostomo
+ * @version 1.22.0
+ */
+#ifndef FSW_FILE_HANDLE_KEY_H
+#  define FSW_FILE_HANDLE_KEY_H
+
+#  include <cstddef>
+#  include <cstdint>
+#  include <string>
+
+namespace fsw
+{
+  /**
+   * @brief Key of a file handle.
+   *
+   * A key is made of the ID of a filesystem and of the type and the bytes of
+   * a file handle of that filesystem, and carries a hash computed when the key
+   * is constructed.  The bytes of the handles up to INLINE_SIZE bytes long,
+   * which include the handles of the common local filesystems, are stored in
+   * the key, so that building the key of an event and looking it up allocates
+   * no memory.  Longer handles, such as those of some network and overlay
+   * filesystems, are stored on the heap.
+   *
+   * A default constructed key is empty, and is not equal to the key of any
+   * handle.
+   */
+  class file_handle_key
+  {
+  public:
+    /**
+     * @brief The maximum size of a handle stored in the key.
+     */
+    static constexpr size_t INLINE_SIZE = 24;
+
+    file_handle_key() = default;
+
+    /**
+     * @brief Constructs the key of a file handle.
+     *
+     * @param filesystem_id The ID of the filesystem of the file.
+     * @param filesystem_id_size The size of @p filesystem_id.  Only the
+     * first 8 bytes are used.
+     * @param handle_type The type of the handle.
+     * @param handle_bytes The bytes of the handle.
+     * @param handle_size The number of bytes of the handle.
+     */
+    file_handle_key(const void *filesystem_id,
+                    size_t filesystem_id_size,
+                    int handle_type,
+                    const void *handle_bytes,
+                    size_t handle_size);
+
+    file_handle_key(const file_handle_key& other);
+    file_handle_key(file_handle_key&& other) noexcept;
+    file_handle_key& operator=(const file_handle_key& other);
+    file_handle_key& operator=(file_handle_key&& other) noexcept;
+    ~file_handle_key();
+
+    /**
+     * @brief Checks whether the key is empty.
+     *
+     * @return @c true if the key was default constructed or moved from.
+     */
+    bool empty() const
+    {
+      return hash_value == 0;
+    }
+
+    /**
+     * @brief Gets the hash of the key.
+     *
+     * @return The hash of the key, which is not 0 unless the key is empty.
+     */
+    size_t hash() const
+    {
+      return static_cast<size_t>(hash_value);
+    }
+
+    /**
+     * @brief Gets the ID of the filesystem of the handle.
+     *
+     * @return The ID of the filesystem.
+     */
+    std::uint64_t get_fsid() const
+    {
+      return fsid;
+    }
+
+    /**
+     * @brief Gets the binary representation of the key.
+     *
+     * @return A string that is equal to the representation of another key
+     * if, and only if, the keys are equal.
+     */
+    std::string to_string() const;
+
+    bool operator==(const file_handle_key& other) const;
+
+    bool operator!=(const file_handle_key& other) const
+    {
+      return !(*this == other);
+    }
+
+    /**
+     * @brief Converts a filesystem ID to the representation used by the keys.
+     *
+     * @param fsid The ID of the filesystem.
+     * @param fsid_size The size of @p fsid.
+     * @return The ID of the filesystem.
+     */
+    static std::uint64_t to_fsid(const void *fsid, size_t fsid_size);
+
+  private:
+    const unsigned char *data() const
+    {
+      return size <= INLINE_SIZE ? storage.bytes : storage.heap;
+    }
+
+    void copy_bytes(const void *bytes);
+    void release();
+
+    std::uint64_t hash_value = 0;
+    std::uint64_t fsid = 0;
+    std::int32_t type = 0;
+    std::uint32_t size = 0;
+
+    union
+    {
+      unsigned char bytes[INLINE_SIZE];
+      unsigned char *heap;
+    } storage{};
+  };
+
+  /**
+   * @brief Hash function of fsw::file_handle_key, returning the hash computed
+   * when the key was constructed.
+   */
+  struct file_handle_key_hash
+  {
+    size_t operator()(const file_handle_key& key) const noexcept
+    {
+      return key.hash();
+    }
+  };
+}
+
+#endif  /* FSW_FILE_HANDLE_KEY_H */
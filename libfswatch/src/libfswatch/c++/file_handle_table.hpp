@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file
+ * @brief Header of the fsw::file_handle_table class.
+ *
+ * This header file defines the fsw::file_handle_table class, a hash table
+ * indexed by file handle, used by the fanotify monitor to find the directory
+ * of each event.
+ *
+ * @copyright Copyright (c) 2026 Enrico M. Crisostomo
+ * @license GNU General Public License v. 3.0
+ * @author Enrico M. Crisostomo
+ * @version 1.22.0
+ */
+#ifndef FSW_FILE_HANDLE_TABLE_H
+#  define FSW_FILE_HANDLE_TABLE_H
+
+#  include "file_handle_key.hpp"
+#  include <cstddef>
+#  include <cstdint>
+#  include <utility>
+#  include <vector>
+
+namespace fsw
+{
+  /**
+   * @brief Open addressing hash table indexed by file handle.
+   *
+   * The entries are stored contiguously, and are indexed by an array of slots
+   * holding the position of an entry and the low 32 bits of the hash of its
+   * key, which is computed when the key is constructed.  A key is looked up
+   * probing linearly from the slot selected by its hash, comparing only the
+   * keys whose hash matches, so that a lookup neither allocates memory nor
+   * follows pointers, except for the keys of long handles.  Slots are 8 bytes
+   * long, so that keeping the load of the slots below three quarters costs
+   * little memory.  Erasing an entry moves the last entry into its place, and
+   * shifts back the following slots of its probe sequence, so that no
+   * tombstone is left.
+   *
+   * @tparam T The type of the values.  It must be default constructible.
+   */
+  template<typename T>
+  class file_handle_table
+  {
+  public:
+    /**
+     * @brief Finds the value of a key.
+     *
+     * @param key The key.
+     * @return A pointer to the value of @p key, or @c nullptr if @p key is not
+     * present.  The pointer is invalidated by the next modification of the
+     * table.
+     */
+    T *find(const file_handle_key& key)
+    {
+      const size_t index = find_slot(key);
+      return index != npos ? &entries[slots[index].entry].value : nullptr;
+    }
+
+    /**
+     * @copydoc find(const file_handle_key&)
+     */
+    const T *find(const file_handle_key& key) const
+    {
+      const size_t index = find_slot(key);
+      return index != npos ? &entries[slots[index].entry].value : nullptr;
+    }
+
+    /**
+     * @brief Checks whether a key is present.
+     *
+     * @param key The key.
+     * @return @c true if @p key is present, @c false otherwise.
+     */
+    bool contains(const file_handle_key& key) const
+    {
+      return find_slot(key) != npos;
+    }
+
+    /**
+     * @brief Inserts a key, replacing its value if already present.
+     *
+     * @param key The key.  It must not be empty.
+     * @param value The value of @p key.
+     * @return A reference to the value of @p key, which is invalidated by the
+     * next modification of the table.
+     */
+    T& insert_or_assign(const file_handle_key& key, T value)
+    {
+      const size_t found = find_slot(key);
+      if (found != npos)
+      {
+        T& current = entries[slots[found].entry].value;
+        current = std::move(value);
+        return current;
+      }
+
+      if ((entries.size() + 1) * 4 > slots.size() * 3) grow();
+
+      const std::uint32_t hash = static_cast<std::uint32_t>(key.hash());
+      size_t index = hash & mask;
+      while (slots[index].entry != EMPTY) index = (index + 1) & mask;
+
+      slots[index] = slot{static_cast<std::uint32_t>(entries.size()), hash};
+      entries.push_back(entry{key, std::move(value)});
+
+      return entries.back().value;
+    }
+
+    /**
+     * @brief Removes a key.
+     *
+     * @param key The key.
+     * @return @c true if @p key was present, @c false otherwise.
+     */
+    bool erase(const file_handle_key& key)
+    {
+      size_t hole = find_slot(key);
+      if (hole == npos) return false;
+
+      const std::uint32_t position = slots[hole].entry;
+
+      // The slots following the hole in its probe sequence are moved back if
+      // their home slot does not lie between the hole and their slot.
+      for (size_t index = (hole + 1) & mask; slots[index].entry != EMPTY; index = (index + 1) & mask)
+      {
+        const size_t home = slots[index].hash & mask;
+        const bool stays = hole <= index ? (hole < home && home <= index)
+                                         : (hole < home || home <= index);
+        if (stays) continue;
+
+        slots[hole] = slots[index];
+        hole = index;
+      }
+
+      slots[hole] = slot();
+
+      // The last entry fills the position of the erased one.
+      const std::uint32_t last = static_cast<std::uint32_t>(entries.size() - 1);
+      if (position != last)
+      {
+        size_t index = entries[last].key.hash() & mask;
+        while (slots[index].entry != last) index = (index + 1) & mask;
+
+        slots[index].entry = position;
+        entries[position] = std::move(entries[last]);
+      }
+
+      entries.pop_back();
+
+      return true;
+    }
+
+    /**
+     * @brief Removes all the keys, releasing the memory of the table.
+     */
+    void clear()
+    {
+      std::vector<slot>().swap(slots);
+      std::vector<entry>().swap(entries);
+      mask = 0;
+    }
+
+    /**
+     * @brief Gets the number of keys in the table.
+     *
+     * @return The number of keys.
+     */
+    size_t size() const
+    {
+      return entries.size();
+    }
+
+    /**
+     * @brief Checks whether the table is empty.
+     *
+     * @return @c true if the table contains no keys.
+     */
+    bool empty() const
+    {
+      return entries.empty();
+    }
+
+  private:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+    static constexpr std::uint32_t EMPTY = UINT32_MAX;
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    struct slot
+    {
+      std::uint32_t entry = EMPTY;
+      std::uint32_t hash = 0;
+    };
+
+    struct entry
+    {
+      file_handle_key key;
+      T value{};
+    };
+
+    size_t find_slot(const file_handle_key& key) const
+    {
+      if (slots.empty() || key.empty()) return npos;
+
+      const std::uint32_t hash = static_cast<std::uint32_t>(key.hash());
+
+      for (size_t index = hash & mask; slots[index].entry != EMPTY; index = (index + 1) & mask)
+      {
+        if (slots[index].hash == hash && entries[slots[index].entry].key == key) return index;
+      }
+
+      return npos;
+    }
+
+    void grow()
+    {
+      std::vector<slot> grown(slots.empty() ? MIN_CAPACITY : slots.size() * 2);
+      const size_t grown_mask = grown.size() - 1;
+
+      for (const slot& current : slots)
+      {
+        if (current.entry == EMPTY) continue;
+
+        size_t index = current.hash & grown_mask;
+        while (grown[index].entry != EMPTY) index = (index + 1) & grown_mask;
+
+        grown[index] = current;
+      }
+
+      slots.swap(grown);
+      mask = grown_mask;
+    }
+
+    std::vector<slot> slots;
+    std::vector<entry> entries;
+    size_t mask = 0;
+  };
+}
+
+#endif  /* FSW_FILE_HANDLE_TABLE_H */
@@ -80,8 +80,9 @@ namespace fsw
     // where type may contains the following characters:
     //   - '+' or '-', to indicate whether the filter is an inclusion or an exclusion filter.
     //   - 'e', for an extended regular expression.
+    //   - 'g', for a glob pattern.
     //   - 'i', for a case insensitive regular expression.
-    regex filter_grammar("^([+-])([ei]*) (.+)$", regex_constants::extended);
+    regex filter_grammar("^([+-])([egi]*) (.+)$", regex_constants::extended);
     smatch fragments;
 
     if (!regex_match(filter, fragments, filter_grammar))
@@ -120,6 +121,9 @@ namespace fsw
       case 'e':
         filter_object.extended = true;
         break;
+      case 'g':
+        filter_object.glob = true;
+        break;
       case 'i':
         filter_object.case_sensitive = false;
         break;
@@ -52,6 +52,9 @@ namespace fsw
    *
    *   - It can be an _extended_ regular expression (monitor_filter::extended).
    *
+   *   - It can be a _glob_ pattern instead of a regular expression
+   *     (monitor_filter::glob).
+   *
    * Further information about how filtering works in `libfswatch` can be found
    * in @ref path-filtering.
    */
@@ -75,7 +78,7 @@ namespace fsw
      * @brief Flag indicating whether monitor_filter::text is a case sensitive
      * regular expression.
      */
-    bool case_sensitive;
+    bool case_sensitive = true;
 
     /**
      * @brief Flag indicating whether monitor_filter::text is an extended
@@ -85,7 +88,18 @@ namespace fsw
      *
      * http://pubs.opengroup.org/onlinepubs/9699919799/basedefs/V1_chap09.html#tag_09_04
      */
-    bool extended;
+    bool extended = false;
+
+    /**
+     * @brief Flag indicating whether monitor_filter::text is a glob pattern.
+     *
+     * A glob pattern must match the whole path.  `*` matches any sequence of
+     * characters, including `/`, `?` matches any single character, `[...]`
+     * matches a bracket expression (`[!...]` negates it) and `\` escapes the
+     * following character.  When this flag is set, monitor_filter::extended
+     * is ignored.
+     */
+    bool glob = false;
 
     /**
      * @brief Load filters from the specified file.
@@ -94,7 +108,7 @@ namespace fsw
      * A filter has the following structure:
      *
      *   - It is validated by the following regular expression:
-     *     `^([+-])([ei]*) (.+)$`
+     *     `^([+-])([egi]*) (.+)$`
      *
      *   - The first character is the filter type: `+` if it is an _inclusion_
      *     filter, `-` if it is an _exclusion_ filter.
@@ -103,6 +117,8 @@ namespace fsw
      *
      *     - `e` if it is an _extended_ regular expression.
      *
+     *     - `g` if it is a _glob_ pattern.
+     *
      *     - `i` if it is a _case insensitive_ regular expression.
      *
      *   - A space.
@@ -198,15 +198,15 @@ namespace fsw
 #endif
   }
 
-  static vector<fsw_event_flag> decode_flags(FSEventStreamEventFlags flag)
+  static event_flag_set decode_flags(FSEventStreamEventFlags flag)
   {
-    vector<fsw_event_flag> evt_flags;
+    event_flag_set evt_flags;
 
     for (const FSEventFlagType& type : event_flag_type)
     {
       if (flag & type.flag)
       {
-        evt_flags.push_back(type.type);
+        evt_flags.insert(type.type);
       }
     }
 
@@ -291,7 +291,7 @@ namespace fsw
 
     if (!events.empty())
     {
-      fse_monitor->notify_events(events);
+      fse_monitor->notify_events(std::move(events));
     }
   }
 
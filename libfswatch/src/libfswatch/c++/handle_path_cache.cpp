@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "handle_path_cache.hpp"
+#include <functional>
+#include <utility>
+
+namespace fsw
+{
+  bool handle_path_cache::path_less::operator()(const entry *lhs, const entry *rhs) const
+  {
+    const int order = lhs->second.path.compare(rhs->second.path);
+    if (order != 0) return order < 0;
+
+    return std::less<const entry *>()(lhs, rhs);
+  }
+
+  bool handle_path_cache::path_less::operator()(const entry *lhs, const std::string& rhs) const
+  {
+    return lhs->second.path < rhs;
+  }
+
+  bool handle_path_cache::path_less::operator()(const std::string& lhs, const entry *rhs) const
+  {
+    return lhs < rhs->second.path;
+  }
+
+  handle_path_cache::handle_path_cache(size_t capacity) :
+    max_size(capacity)
+  {
+  }
+
+  const std::string *handle_path_cache::find(const file_handle_key& key)
+  {
+    const auto cached = paths.find(key);
+    if (cached == paths.end()) return nullptr;
+
+    recency.splice(recency.begin(), recency, cached->second.position);
+
+    return &cached->second.path;
+  }
+
+  void handle_path_cache::insert(const file_handle_key& key, std::string path)
+  {
+    if (max_size == 0) return;
+
+    const auto cached = paths.find(key);
+    if (cached != paths.end())
+    {
+      // The entry is ordered by its path: it is indexed again.
+      index.erase(cached->second.index_position);
+      cached->second.path = std::move(path);
+      cached->second.index_position = index.insert(&*cached).first;
+      recency.splice(recency.begin(), recency, cached->second.position);
+      return;
+    }
+
+    if (paths.size() >= max_size) evict(paths.size() - max_size + 1);
+
+    const auto inserted = paths.emplace(key, cached_path{std::move(path), {}, {}}).first;
+    recency.push_front(&inserted->first);
+    inserted->second.position = recency.begin();
+    inserted->second.index_position = index.insert(&*inserted).first;
+  }
+
+  void handle_path_cache::erase(const file_handle_key& key)
+  {
+    const auto cached = paths.find(key);
+    if (cached == paths.end()) return;
+
+    recency.erase(cached->second.position);
+    index.erase(cached->second.index_position);
+    paths.erase(cached);
+  }
+
+  void handle_path_cache::erase_tree(const std::string& path)
+  {
+    if (path.empty()) return;
+
+    // The tree of a directory is made of the directory and of the paths
+    // starting with its path followed by a /.  The latter are contiguous in
+    // the index and precede the paths starting with its path followed by 0,
+    // the character following /.
+    const std::string base = path.back() == '/' ? path.substr(0, path.size() - 1) : path;
+
+    erase_range(index.lower_bound(path), index.upper_bound(path));
+    erase_range(index.lower_bound(base + '/'), index.lower_bound(base + '0'));
+  }
+
+  void handle_path_cache::clear()
+  {
+    recency.clear();
+    index.clear();
+    paths.clear();
+  }
+
+  void handle_path_cache::set_capacity(size_t capacity)
+  {
+    max_size = capacity;
+    if (paths.size() > max_size) evict(paths.size() - max_size);
+  }
+
+  size_t handle_path_cache::capacity() const
+  {
+    return max_size;
+  }
+
+  size_t handle_path_cache::size() const
+  {
+    return paths.size();
+  }
+
+  void handle_path_cache::evict(size_t count)
+  {
+    for (size_t i = 0; i < count && !recency.empty(); ++i)
+    {
+      // The key is owned by the element being erased.
+      const auto cached = paths.find(*recency.back());
+      recency.pop_back();
+      index.erase(cached->second.index_position);
+      paths.erase(cached);
+    }
+  }
+
+  void handle_path_cache::erase_range(path_index::iterator first, path_index::iterator last)
+  {
+    while (first != last)
+    {
+      // The key is owned by the element being erased.
+      const auto cached = paths.find((*first)->first);
+      first = index.erase(first);
+      recency.erase(cached->second.position);
+      paths.erase(cached);
+    }
+  }
+}
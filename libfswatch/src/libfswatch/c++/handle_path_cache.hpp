@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file
+ * @brief Header of the fsw::handle_path_cache class.
+ *
+ * This header file defines the fsw::handle_path_cache class, a bounded cache
+ * of the paths of directories by file handle, used by the fanotify monitor to
+ * avoid resolving the handle of a directory at each event.
+ *
+ * @copyright Copyright (c) 2026 Enrico M. Crisostomo
+ * @license GNU General Public License v. 3.0
+ * @author Enrico M. Crisostomo
+ * @version 1.22.0
+ */
+#ifndef FSW_HANDLE_PATH_CACHE_H
+#  define FSW_HANDLE_PATH_CACHE_H
+
+#  include "file_handle_key.hpp"
+#  include <cstddef>
+#  include <list>
+#  include <set>
+#  include <string>
+#  include <unordered_map>
+#  include <utility>
+
+namespace fsw
+{
+  /**
+   * @brief Least recently used cache of directory paths.
+   *
+   * Resolving the path of a directory from its file handle requires opening
+   * the directory and reading the link of its descriptor.  This cache keeps
+   * the paths of the most recently resolved directories, identified by their
+   * file handle, evicting the least recently used path once the capacity is
+   * reached.
+   *
+   * The cached paths are not validated: the monitor erases the path of a
+   * directory when it is moved or removed, together with the paths of the
+   * directories it contains.
+   */
+  class handle_path_cache
+  {
+  public:
+    /**
+     * @brief The default maximum number of cached paths.
+     */
+    static constexpr size_t DEFAULT_CAPACITY = 16384;
+
+    /**
+     * @brief Constructs a cache.
+     *
+     * @param capacity The maximum number of cached paths.  A cache whose
+     * capacity is @c 0 keeps no path.
+     */
+    explicit handle_path_cache(size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief Finds the path of a directory, marking it as the most recently
+     * used.
+     *
+     * @param key The file handle of the directory.
+     * @return The path of the directory, or @c nullptr if it is not cached.
+     * The pointer is invalidated by the next modification of the cache.
+     */
+    const std::string *find(const file_handle_key& key);
+
+    /**
+     * @brief Caches the path of a directory, evicting the least recently used
+     * path if the cache is full.
+     *
+     * @param key The file handle of the directory.
+     * @param path The path of the directory.
+     */
+    void insert(const file_handle_key& key, std::string path);
+
+    /**
+     * @brief Removes the path of a directory.
+     *
+     * @param key The file handle of the directory.
+     */
+    void erase(const file_handle_key& key);
+
+    /**
+     * @brief Removes the paths of a directory and of the directories it
+     * contains.
+     *
+     * @param path The path of the directory.
+     */
+    void erase_tree(const std::string& path);
+
+    /**
+     * @brief Removes all the paths.
+     */
+    void clear();
+
+    /**
+     * @brief Sets the maximum number of cached paths, evicting the least
+     * recently used paths in excess.
+     *
+     * @param capacity The maximum number of cached paths.
+     */
+    void set_capacity(size_t capacity);
+
+    /**
+     * @brief Gets the maximum number of cached paths.
+     *
+     * @return The maximum number of cached paths.
+     */
+    size_t capacity() const;
+
+    /**
+     * @brief Gets the number of cached paths.
+     *
+     * @return The number of cached paths.
+     */
+    size_t size() const;
+
+  private:
+    struct cached_path;
+    using entry = std::pair<const file_handle_key, cached_path>;
+
+    // Orders the entries by path, and entries with the same path by address.
+    // Paths can be compared with entries to look up a range of paths.
+    struct path_less
+    {
+      using is_transparent = void;
+
+      bool operator()(const entry *lhs, const entry *rhs) const;
+      bool operator()(const entry *lhs, const std::string& rhs) const;
+      bool operator()(const std::string& lhs, const entry *rhs) const;
+    };
+
+    using path_index = std::set<const entry *, path_less>;
+
+    struct cached_path
+    {
+      std::string path;
+      // The position of the key in the recency list.
+      std::list<const file_handle_key *>::iterator position;
+      // The position of the entry in the path index.
+      path_index::iterator index_position;
+    };
+
+    void evict(size_t count);
+    void erase_range(path_index::iterator first, path_index::iterator last);
+
+    std::unordered_map<file_handle_key, cached_path, file_handle_key_hash> paths;
+    // The keys of the cached paths, the most recently used first.  The keys
+    // are owned by the map, whose elements are never moved.
+    std::list<const file_handle_key *> recency;
+    // The entries of the map ordered by path, so that the paths of the
+    // directories contained in a directory can be found without scanning the
+    // whole cache.
+    path_index index;
+    size_t max_size;
+  };
+}
+
+#endif  /* FSW_HANDLE_PATH_CACHE_H */
@@ -23,8 +23,14 @@
 #include "inotify_monitor.hpp"
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cerrno>
+#include <chrono>
+#include <cstdlib>
 #include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
 #include <unordered_map>
 #include <unordered_set>
 #include <limits.h>
@@ -35,15 +41,31 @@
 #include <stdio.h>
 #include <sstream>
 #include <ctime>
-#include <cmath>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
 #include "libfswatch_exception.hpp"
 #include "../c/libfswatch_log.h"
-#include "path_utils.hpp"
+#include "directory_walker.hpp"
+#include "missing_root_set.hpp"
+#include "tree_snapshot.hpp"
+#include "watch_table.hpp"
 
 namespace fsw
 {
+  struct created_directory
+  {
+    std::string path;
+    // Whether the creation of the entries of the directory is notified.
+    bool notify;
+  };
+
+  // What the monitor does when the limit of inotify watches is reached.
+  enum class watch_limit_policy
+  {
+    warn,
+    fail,
+    poll
+  };
 
   struct inotify_monitor_impl
   {
@@ -52,34 +74,133 @@ namespace fsw
     int wake_handle = -1;
     std::vector<event> events;
     /*
-     * A map of file names by descriptor is kept in sync because the name field
-     * of the inotify_event structure is present only when it identifies a
-     * child of a watched directory.  In all the other cases, we store the path
-     * for easy retrieval.
-     */
-    std::unordered_set<int> watched_descriptors;
-    std::unordered_map<std::string, int> path_to_wd;
-    /*
-     * Since the inotify API maintains only works with watch
-     * descriptors a cache maintaining a relationship between a watch
-     * descriptor and the path used to get it is required to be able to map an
-     * event to the path it refers to.  From man inotify:
+     * Since the inotify API only works with watch descriptors, a table mapping
+     * each descriptor to the path used to get it is required to be able to
+     * map an event to the path it refers to.  From man inotify:
      *
      *   The inotify API identifies events via watch descriptors.  It is the
      *   application's responsibility to cache a mapping (if one is needed)
      *   between watch descriptors and pathnames.  Be aware that directory
      *   renamings may affect multiple cached pathnames.
+     *
+     * The path is required because the name field of the inotify_event
+     * structure is present only when it identifies a child of a watched
+     * directory.  The table also caches the verdicts of
+     * monitor::is_subtree_excluded() on the watched directories, used to
+     * discard the events of their children before their path is built.
      */
-    std::unordered_map<int, std::string> wd_to_path;
+    watch_table watches;
     std::unordered_set<int> descriptors_to_remove;
     std::unordered_set<int> watches_to_remove;
-    std::vector<std::string> paths_to_rescan;
-    std::vector<std::string> paths_to_fire_create;
+    /*
+     * The directories created in the watched trees are walked once to watch
+     * their subdirectories and to notify the creation of their entries, which
+     * may have been created before the directories were watched.
+     */
+    std::vector<created_directory> created_directories;
+    /*
+     * The root paths are not polled.  The descriptors of the watched roots are
+     * tracked to find out when a root is removed, and the roots that do not
+     * exist are retried when their anchor, the nearest existing ancestor, is
+     * changed.  Anchors that are not watched directories are watched by
+     * descriptors that only report the creation of their children.
+     */
+    std::unordered_multimap<int, std::string> root_descriptors;
+    // The descriptors watching only anchors, and whether they were removed.
+    std::unordered_map<int, bool> anchor_descriptors;
+    missing_root_set<int> missing_roots;
+    std::vector<std::string> roots_to_retry;
     time_t curr_time;
+    size_t scan_threads = 1;
+    uint32_t event_mask = IN_ALL_EVENTS;
+    /*
+     * In overflow recovery mode, a snapshot of each watched root is kept to
+     * find the changes whose events are lost when the queue overflows.
+     */
+    std::unordered_map<std::string, tree_snapshot> snapshots;
+    std::chrono::milliseconds recovery_budget{0};
+    bool overflowed = false;
+    // Whether IN_MASK_CREATE is supported.
+    bool mask_create = false;
+    /*
+     * The limits read from /proc/sys/fs/inotify, or 0 if they are not
+     * available.  The limit of watches is per user, so that it may be reached
+     * before the monitor holds max_user_watches watches.
+     */
+    size_t max_user_watches = 0;
+    size_t max_queued_events = 0;
+    std::atomic<size_t> watch_count{0};
+    watch_limit_policy watch_limit = watch_limit_policy::warn;
+    bool watch_limit_reported = false;
+    /*
+     * In poll mode, the subtrees that cannot be watched because the limit of
+     * watches is reached are polled comparing snapshots of their files.
+     */
+    std::map<std::string, tree_snapshot> polled_trees;
+    std::vector<std::string> trees_to_poll;
+    std::chrono::steady_clock::time_point next_poll;
   };
 
-  static const unsigned int BUFFER_SIZE = (10 * ((sizeof(struct inotify_event)) + NAME_MAX + 1));
+  static const size_t MAX_EVENT_SIZE = sizeof(struct inotify_event) + NAME_MAX + 1;
+  static const size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
   static const int EPOLL_EVENT_COUNT = 2;
+  static const double MIN_POLL_INTERVAL = 1.0;
+  static const uint32_t ANCHOR_EVENT_MASK = IN_CREATE | IN_MOVED_TO | IN_ONLYDIR | IN_MASK_ADD;
+  static const uint32_t ACCESS_EVENT_MASK = IN_ACCESS | IN_CLOSE_NOWRITE | IN_OPEN;
+  /*
+   * The events required to keep the watches up to date: the creation of
+   * directories to watch, and the removal of watched objects.
+   */
+  static const uint32_t WATCH_EVENT_MASK = IN_CREATE | IN_DELETE_SELF | IN_MOVE_SELF;
+#ifdef IN_MASK_CREATE
+  static const uint32_t WATCH_CREATE_FLAG = IN_MASK_CREATE;
+#else
+  static const uint32_t WATCH_CREATE_FLAG = 0;
+#endif
+
+  /*
+   * Gets the inotify events that may be reported with an event flag, as
+   * mapped by inotify_monitor::preprocess_dir_event() and
+   * inotify_monitor::preprocess_node_event().
+   */
+  static uint32_t get_flag_event_mask(fsw_event_flag flag)
+  {
+    switch (flag)
+    {
+    case fsw_event_flag::NoOp:
+    case fsw_event_flag::Overflow:
+    case fsw_event_flag::Renamed:
+    case fsw_event_flag::OwnerModified:
+    case fsw_event_flag::IsFile:
+    case fsw_event_flag::IsSymLink:
+    case fsw_event_flag::Link:
+      return 0;
+    case fsw_event_flag::PlatformSpecific:
+      return ACCESS_EVENT_MASK;
+    case fsw_event_flag::Created:
+      return IN_CREATE | IN_MOVED_TO;
+    case fsw_event_flag::Updated:
+      return IN_MODIFY | IN_MOVE_SELF;
+    case fsw_event_flag::Removed:
+      return IN_DELETE | IN_DELETE_SELF | IN_MOVED_FROM;
+    case fsw_event_flag::AttributeModified:
+      return IN_ATTRIB;
+    case fsw_event_flag::MovedFrom:
+      return IN_MOVED_FROM;
+    case fsw_event_flag::MovedTo:
+      return IN_MOVED_TO;
+    case fsw_event_flag::CloseWrite:
+      return IN_CLOSE_WRITE;
+    default:
+      // IsDir is reported with any event of a directory.
+      return IN_ALL_EVENTS;
+    }
+  }
+
+  // Thrown to stop a snapshot walk exceeding its time budget.
+  struct snapshot_timeout
+  {
+  };
 
   struct scoped_fd
   {
@@ -108,14 +229,6 @@ namespace fsw
     }
   };
 
-  static int latency_to_timeout_ms(double latency)
-  {
-    if (latency <= 0) return 0;
-    if (latency >= INT_MAX / 1000.0) return INT_MAX;
-
-    return static_cast<int>(std::ceil(latency * 1000.0));
-  }
-
   static void add_epoll_interest(int epoll_fd, int fd)
   {
     struct epoll_event event {};
@@ -188,12 +301,12 @@ namespace fsw
   inotify_monitor::~inotify_monitor()
   {
     // log removal of inotify watchers (automatically removed by close below)
-    for (auto inotify_desc_pair : impl->watched_descriptors)
-    {
-      std::ostringstream log;
-      log << _("Removing: ") << inotify_desc_pair << "\n";
-      FSW_ELOG(log.str().c_str());
-    }
+    impl->watches.for_each([](int wd)
+                           {
+                             std::ostringstream log;
+                             log << _("Removing: ") << wd << "\n";
+                             FSW_ELOG(log.str().c_str());
+                           });
 
     // close inotify (removes watches)
     if (impl->inotify_monitor_handle >= 0)
@@ -212,28 +325,124 @@ namespace fsw
     }
   }
 
-  bool inotify_monitor::add_watch(const std::string& path)
+  uint32_t inotify_monitor::get_event_mask() const
   {
-    // TODO: Consider optionally adding the IN_EXCL_UNLINK flag.
-    auto event_mask = IN_ALL_EVENTS;
-    if (!watch_access)
+    // Only the events that may pass the event type filters are requested, so
+    // that the other events do not fill the kernel queue.
+    uint32_t event_mask = WATCH_EVENT_MASK;
+
+    for (const fsw_event_flag flag : FSW_ALL_EVENT_FLAGS)
     {
-      event_mask &= ~(IN_ACCESS | IN_CLOSE_NOWRITE | IN_OPEN);
+      if (accept_event_type(flag)) event_mask |= get_flag_event_mask(flag);
     }
 
-    int inotify_desc = inotify_add_watch(impl->inotify_monitor_handle,
-                                         path.c_str(),
-                                         event_mask);
+    if (!watch_access) event_mask &= ~ACCESS_EVENT_MASK;
+
+    // The events of the children unlinked from a watched directory, such as
+    // the writes to an open temporary file, are not reported.
+    return event_mask | IN_EXCL_UNLINK;
+  }
 
-    if (inotify_desc == -1)
+  static size_t read_limit(const char *path)
+  {
+    std::ifstream limit_file(path);
+    size_t limit = 0;
+
+    if (!(limit_file >> limit)) return 0;
+
+    return limit;
+  }
+
+  void inotify_monitor::read_inotify_limits()
+  {
+    impl->max_user_watches = read_limit("/proc/sys/fs/inotify/max_user_watches");
+    impl->max_queued_events = read_limit("/proc/sys/fs/inotify/max_queued_events");
+
+    FSW_ELOGF(_("inotify limits: %zu watches per user, %zu queued events.\n"),
+              impl->max_user_watches,
+              impl->max_queued_events);
+  }
+
+  size_t inotify_monitor::get_watch_count() const
+  {
+    return impl->watch_count;
+  }
+
+  void inotify_monitor::on_watch_limit(const std::string& path, const bool is_dir)
+  {
+    std::ostringstream report;
+    report << _("Cannot watch ") << path
+           << _(": the limit of inotify watches per user");
+    if (impl->max_user_watches > 0) report << " (" << impl->max_user_watches << ")";
+    report << _(" is reached, and this monitor holds ") << impl->watches.size()
+           << _(" watches.  Raise fs.inotify.max_user_watches or set the ")
+           << WATCH_LIMIT_PROPERTY << _(" property to poll the directories that cannot be watched.");
+
+    switch (impl->watch_limit)
+    {
+    case watch_limit_policy::fail:
+      throw libfsw_exception(report.str());
+
+    case watch_limit_policy::poll:
+      // The polled trees are retried at each poll.
+      if (!is_dir || impl->polled_trees.find(path) != impl->polled_trees.end()) break;
+      impl->trees_to_poll.push_back(path);
+      FSW_ELOGF(_("Polling %s: the limit of inotify watches is reached.\n"), path.c_str());
+      break;
+
+    case watch_limit_policy::warn:
+      // The limit is reported once, rather than for each directory.
+      if (impl->watch_limit_reported) break;
+      impl->watch_limit_reported = true;
+      fprintf(stderr, "%s\n", report.str().c_str());
+      break;
+    }
+  }
+
+  bool inotify_monitor::add_watch(const std::string& path, const bool is_dir)
+  {
+    // Watching only directories avoids watching a file replaced to a
+    // directory after it was listed.
+    uint32_t event_mask = impl->event_mask;
+    if (is_dir || directory_only) event_mask |= IN_ONLYDIR;
+
+    /*
+     * IN_MASK_CREATE fails if the directory is already watched, which avoids
+     * updating its watch when it is scanned again.  A directory watched through
+     * another path, or watched as an anchor, is watched again adding the
+     * events to the mask of its watch.
+     */
+    int inotify_desc = -1;
+
+    if (impl->mask_create)
+    {
+      inotify_desc = inotify_add_watch(impl->inotify_monitor_handle,
+                                       path.c_str(),
+                                       event_mask | WATCH_CREATE_FLAG);
+
+      if (inotify_desc == -1 && errno == EEXIST && is_watched(path)) return true;
+      if (inotify_desc == -1 && errno == EINVAL) impl->mask_create = false;
+    }
+
+    if (inotify_desc == -1 && (!impl->mask_create || errno == EEXIST))
+    {
+      inotify_desc = inotify_add_watch(impl->inotify_monitor_handle,
+                                       path.c_str(),
+                                       event_mask | IN_MASK_ADD);
+    }
+
+    if (inotify_desc == -1 && errno == ENOSPC)
+    {
+      on_watch_limit(path, is_dir);
+    }
+    else if (inotify_desc == -1)
     {
       perror("inotify_add_watch");
     }
     else
     {
-      impl->watched_descriptors.insert(inotify_desc);
-      impl->wd_to_path[inotify_desc] = path;
-      impl->path_to_wd[path] = inotify_desc;
+      impl->watches.insert(inotify_desc, path);
+      impl->watch_count = impl->watches.size();
 
       std::ostringstream log;
       log << _("Added: ") << path << "\n";
@@ -243,27 +452,64 @@ namespace fsw
     return (inotify_desc != -1);
   }
 
-  void inotify_monitor::scan(const std::filesystem::path& path, const bool is_root_path)
+  void inotify_monitor::scan(const std::filesystem::path& path,
+                             const bool is_root_path,
+                             tree_snapshot *snapshot)
   {
-    try 
+    // When a snapshot is taken, the files are visited as well to record them,
+    // and so are the entries of the root of a non-recursive scan.
+    directory_walker walker([this, is_root_path, snapshot](const std::filesystem::path& p,
+                                                           entry_type type,
+                                                           bool is_walk_root)
+                              -> std::optional<std::filesystem::path>
+                            {
+                              const bool is_root = is_root_path && is_walk_root;
+                              if (!snapshot) return visit_path(p, type, is_root);
+
+                              const auto entry = snapshot_path(p, is_walk_root, *snapshot);
+                              if (!entry) return std::nullopt;
+                              if (!recursive && !is_walk_root) return std::nullopt;
+
+                              std::optional<std::filesystem::path> next = visit_path(p, type, is_root);
+                              if (!recursive && entry->second) return entry->first;
+
+                              return next;
+                            },
+                            impl->scan_threads,
+                            snapshot != nullptr);
+
+    const walk_statistics statistics = walker.walk(path);
+
+    if (is_root_path)
     {
-      auto status = std::filesystem::symlink_status(path);
+      FSW_ELOGF(_("Scanned %s: %zu directories in %.3f s using %zu threads.\n"),
+                path.c_str(),
+                statistics.directories,
+                std::chrono::duration<double>(statistics.elapsed).count(),
+                statistics.threads);
+    }
+  }
 
-      if (!std::filesystem::exists(status))
-      {
-        return;
-      }
+  std::optional<std::filesystem::path> inotify_monitor::visit_path(const std::filesystem::path& path,
+                                                                   entry_type type,
+                                                                   const bool is_root_path)
+  {
+    try 
+    {
+      // The type of listed entries is known, so that only root paths and
+      // followed symbolic links are stat'ed.
+      if (type == entry_type::unknown) type = get_entry_type(path.string());
+      if (type == entry_type::unknown) return std::nullopt;
 
       // Check if the path is a symbolic link
-      if (follow_symlinks && std::filesystem::is_symlink(status))
+      if (follow_symlinks && type == entry_type::symlink)
       {
         auto link_path = std::filesystem::read_symlink(path);
-        scan(link_path, is_root_path);
-        return;
+        return visit_path(link_path, entry_type::unknown, is_root_path);
       }
 
-      const bool is_dir = std::filesystem::is_directory(status);
-      if (should_prune_path(path.string(), is_dir, is_root_path)) return;
+      const bool is_dir = type == entry_type::directory;
+      if (should_prune_path(path.string(), is_dir, is_root_path)) return std::nullopt;
 
       /*
       * When watching a directory the inotify API will return change events of
@@ -275,114 +521,275 @@ namespace fsw
       * For the same reason, the directory_only flag is ignored and treated as if
       * it were always set to true.
       */
-      if (!is_dir && !is_root_path) return;
-      if (!is_dir && directory_only) return;
-      if (!add_watch(path)) return;
-      if (!recursive || !is_dir) return;
-
-      // TODO: Consider using std::filesystem::recursive_directory_iterator
-      const auto entries = get_subdirectories(path);
+      if (!is_dir && !is_root_path) return std::nullopt;
+      if (!is_dir && directory_only) return std::nullopt;
+      if (!add_watch(path, is_dir)) return std::nullopt;
+      if (!recursive || !is_dir) return std::nullopt;
 
-      for (const auto& entry : entries)
-        // Scan children but only watch directories.
-        scan(entry, false);
+      // Scan children but only watch directories.
+      return path;
     }
     catch (const std::filesystem::filesystem_error& e) 
     {
         // Handle errors, such as permission issues or non-existent paths
         FSW_ELOGF(_("Filesystem error: %s"), e.what());
     }
+
+    return std::nullopt;
   }
 
   bool inotify_monitor::is_watched(const std::string& path) const
   {
-    return (impl->path_to_wd.find(path) != impl->path_to_wd.end());
+    return impl->watches.get_descriptor(path) != -1;
+  }
+
+  bool inotify_monitor::is_excluded_directory(int wd)
+  {
+    const watch_exclusion verdict = impl->watches.get_exclusion(wd);
+    if (verdict != watch_exclusion::unknown) return verdict == watch_exclusion::excluded;
+    if (!impl->watches.contains(wd)) return false;
+
+    const bool excluded = is_subtree_excluded(impl->watches.get_path(wd));
+    impl->watches.set_exclusion(wd, excluded ? watch_exclusion::excluded : watch_exclusion::included);
+
+    return excluded;
   }
 
   void inotify_monitor::scan_root_paths()
   {
-    for (const std::string& path : paths)
-    {
-      if (!is_watched(path)) scan(path, true);
-    }
+    for (const std::string& path : paths) watch_root(path);
   }
 
-  void inotify_monitor::preprocess_dir_event(const struct inotify_event *event)
+  void inotify_monitor::watch_root(const std::string& root)
   {
-    std::vector<fsw_event_flag> flags;
+    // The anchor is watched before checking again whether the root exists, so
+    // that a root created in the meantime is not missed.
+    if (get_entry_type(root) == entry_type::unknown)
+    {
+      anchor_root(root);
+      if (get_entry_type(root) == entry_type::unknown) return;
+    }
 
-    if (event->mask & IN_ISDIR) flags.push_back(fsw_event_flag::IsDir);
-    if (event->mask & IN_MOVE_SELF) flags.push_back(fsw_event_flag::Updated);
-    if (event->mask & IN_MOVED_FROM)
+    impl->missing_roots.erase(root);
+
+    if (!is_watched(root) && impl->recovery_budget.count() > 0)
     {
-      flags.push_back(fsw_event_flag::Removed);
-      flags.push_back(fsw_event_flag::MovedFrom);
+      // The snapshot is taken by the scan adding the watches.
+      tree_snapshot& snapshot = impl->snapshots[root];
+      snapshot = tree_snapshot();
+      scan(root, true, &snapshot);
     }
-    if (event->mask & IN_MOVED_TO)
+    else if (!is_watched(root))
     {
-      flags.push_back(fsw_event_flag::Created);
-      flags.push_back(fsw_event_flag::MovedTo);
+      scan(root, true);
     }
-    if (event->mask & IN_UNMOUNT) flags.push_back(fsw_event_flag::PlatformSpecific);
 
-    if (!flags.empty())
+    int wd = impl->watches.get_descriptor(root);
+    if (wd == -1 && follow_symlinks && get_entry_type(root) == entry_type::symlink)
+    {
+      std::error_code error;
+      const auto link_path = std::filesystem::read_symlink(root, error);
+      if (!error) wd = impl->watches.get_descriptor(link_path.string());
+    }
+
+    if (wd == -1) return;
+
+    const auto range = impl->root_descriptors.equal_range(wd);
+    for (auto it = range.first; it != range.second; ++it)
     {
-      impl->events.emplace_back(impl->wd_to_path[event->wd], impl->curr_time, flags, event->cookie);
+      if (it->second == root) return;
     }
 
+    impl->root_descriptors.emplace(wd, root);
   }
 
-  void inotify_monitor::preprocess_node_event(const struct inotify_event *event)
+  void inotify_monitor::anchor_root(const std::string& root)
   {
-    std::vector<fsw_event_flag> flags;
+    const std::string anchor = find_anchor_path(root);
+    int wd = -1;
 
-    if (event->mask & IN_ACCESS) flags.push_back(fsw_event_flag::PlatformSpecific);
-    if (event->mask & IN_ATTRIB) flags.push_back(fsw_event_flag::AttributeModified);
-    if (event->mask & IN_CLOSE_NOWRITE) flags.push_back(fsw_event_flag::PlatformSpecific);
-    if (event->mask & IN_CLOSE_WRITE) flags.push_back(fsw_event_flag::CloseWrite);
-    if (event->mask & IN_CREATE) flags.push_back(fsw_event_flag::Created);
-    if (event->mask & IN_DELETE) flags.push_back(fsw_event_flag::Removed);
-    if (event->mask & IN_DELETE_SELF) flags.push_back(fsw_event_flag::Removed);
-    if (event->mask & IN_MODIFY) flags.push_back(fsw_event_flag::Updated);
-    if (event->mask & IN_OPEN) flags.push_back(fsw_event_flag::PlatformSpecific);
+    if (!anchor.empty())
+    {
+      // IN_MASK_ADD preserves the mask of a watch of the same directory, which
+      // may not include all the events of an anchor.
+      wd = inotify_add_watch(impl->inotify_monitor_handle, anchor.c_str(), ANCHOR_EVENT_MASK);
 
-    // Build the file name.
-    std::ostringstream filename_stream;
-    filename_stream << impl->wd_to_path[event->wd];
+      if (wd == -1) fsw_logf_perror(_("Cannot watch %s"), anchor.c_str());
+      else if (!impl->watches.contains(wd)) impl->anchor_descriptors.emplace(wd, false);
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+
+    if (wd == -1)
+    {
+      FSW_ELOGF(_("Missing root %s: retrying with a backoff.\n"), root.c_str());
+      impl->missing_roots.insert(root, std::nullopt, now);
+      return;
+    }
+
+    FSW_ELOGF(_("Missing root %s: watching %s.\n"), root.c_str(), anchor.c_str());
+    impl->missing_roots.insert(root, wd, now);
+  }
+
+  void inotify_monitor::process_anchor_event(const struct inotify_event *event)
+  {
+    if (!(event->mask & (IN_CREATE | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)))
+      return;
+
+    if (!impl->missing_roots.is_anchor(event->wd)) return;
+
+    for (std::string& root : impl->missing_roots.get_anchored(event->wd))
+      impl->roots_to_retry.push_back(std::move(root));
+  }
+
+  void inotify_monitor::retry_missing_roots()
+  {
+    if (impl->missing_roots.empty() && impl->roots_to_retry.empty()) return;
+
+    std::vector<std::string> roots = std::move(impl->roots_to_retry);
+    impl->roots_to_retry.clear();
+
+    for (std::string& root : impl->missing_roots.get_due(std::chrono::steady_clock::now()))
+      roots.push_back(std::move(root));
+
+    std::sort(roots.begin(), roots.end());
+    roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+
+    for (const std::string& root : roots) watch_root(root);
+
+    release_anchors();
+  }
+
+  void inotify_monitor::release_anchors()
+  {
+    auto it = impl->anchor_descriptors.begin();
+
+    while (it != impl->anchor_descriptors.end())
+    {
+      if (it->second || impl->missing_roots.is_anchor(it->first))
+      {
+        ++it;
+        continue;
+      }
+
+      // The descriptor may have been reused to watch the directory as part of
+      // a watched tree.  Otherwise, it is forgotten when its IN_IGNORED event
+      // is received.
+      if (impl->watches.contains(it->first))
+      {
+        it = impl->anchor_descriptors.erase(it);
+        continue;
+      }
+
+      if (inotify_rm_watch(impl->inotify_monitor_handle, it->first) != 0)
+      {
+        fsw_log_perror("inotify_rm_watch");
+        it = impl->anchor_descriptors.erase(it);
+        continue;
+      }
+
+      it->second = true;
+      ++it;
+    }
+  }
+
+  std::string inotify_monitor::get_child_path(const struct inotify_event *event) const
+  {
+    // Build the file name with a single allocation.
+    std::string filename;
 
     if (event->len > 1)
     {
-      filename_stream << "/";
-      filename_stream << event->name;
+      const size_t name_length = strlen(event->name);
+      impl->watches.append_path(event->wd, filename, 1 + name_length);
+      if (filename.empty() || filename.back() != '/') filename.append(1, '/');
+      filename.append(event->name, name_length);
+    }
+    else
+    {
+      impl->watches.append_path(event->wd, filename);
     }
 
-    if ((event->mask & IN_ISDIR) && (event->mask & IN_CREATE))
+    return filename;
+  }
+
+  void inotify_monitor::preprocess_dir_event(const struct inotify_event *event)
+  {
+    event_flag_set flags;
+
+    if (event->mask & IN_ISDIR) flags.insert(fsw_event_flag::IsDir);
+    if (event->mask & IN_MOVE_SELF) flags.insert(fsw_event_flag::Updated);
+    if (event->mask & IN_MOVED_FROM)
+    {
+      flags.insert(fsw_event_flag::Removed);
+      flags.insert(fsw_event_flag::MovedFrom);
+    }
+    if (event->mask & IN_MOVED_TO)
     {
-      const std::string created_dir_path = filename_stream.str();
-      impl->paths_to_rescan.push_back(created_dir_path);
-      impl->paths_to_fire_create.push_back(created_dir_path);
+      flags.insert(fsw_event_flag::Created);
+      flags.insert(fsw_event_flag::MovedTo);
     }
+    if (event->mask & IN_UNMOUNT) flags.insert(fsw_event_flag::PlatformSpecific);
 
     if (!flags.empty())
     {
-      impl->events.emplace_back(filename_stream.str(), impl->curr_time, flags, event->cookie);
+      impl->events.emplace_back(impl->watches.get_path(event->wd),
+                                impl->curr_time,
+                                flags,
+                                event->cookie);
     }
 
+  }
+
+  void inotify_monitor::preprocess_node_event(const struct inotify_event *event)
+  {
+    /*
+     * The events of the children of a directory whose descendants are all
+     * rejected by the path filters are discarded before their path is built.
+     * Watch bookkeeping only concerns events of the watched object itself,
+     * which carry no name, and the rescan of created directories, which is
+     * still performed.  Their synthetic events would be rejected as well.
+     */
+    if (event->len > 1 && is_excluded_directory(event->wd))
     {
-      std::ostringstream log;
-      log << _("Generic event: ") << event->wd << "::" << filename_stream.str() << "\n";
-      FSW_ELOG(log.str().c_str());
+      FSW_ELOGF(_("Excluded event: %d::%s\n"), event->wd, event->name);
+
+      if ((event->mask & IN_ISDIR) && (event->mask & IN_CREATE))
+      {
+        impl->created_directories.push_back({get_child_path(event), false});
+      }
+
+      return;
     }
 
+    event_flag_set flags;
+
+    if (event->mask & IN_ACCESS) flags.insert(fsw_event_flag::PlatformSpecific);
+    if (event->mask & IN_ATTRIB) flags.insert(fsw_event_flag::AttributeModified);
+    if (event->mask & IN_CLOSE_NOWRITE) flags.insert(fsw_event_flag::PlatformSpecific);
+    if (event->mask & IN_CLOSE_WRITE) flags.insert(fsw_event_flag::CloseWrite);
+    if (event->mask & IN_CREATE) flags.insert(fsw_event_flag::Created);
+    if (event->mask & IN_DELETE) flags.insert(fsw_event_flag::Removed);
+    if (event->mask & IN_DELETE_SELF) flags.insert(fsw_event_flag::Removed);
+    if (event->mask & IN_MODIFY) flags.insert(fsw_event_flag::Updated);
+    if (event->mask & IN_OPEN) flags.insert(fsw_event_flag::PlatformSpecific);
+
+    std::string filename = get_child_path(event);
+
+    if ((event->mask & IN_ISDIR) && (event->mask & IN_CREATE))
+    {
+      impl->created_directories.push_back({filename, true});
+    }
+
+    FSW_ELOGF(_("Generic event: %d::%s\n"), event->wd, filename.c_str());
+
     /*
      * inotify automatically removes the watch of a watched item that has been
      * removed and posts an IN_IGNORED event after an IN_DELETE_SELF.
      */
     if (event->mask & IN_IGNORED)
     {
-      std::ostringstream log;
-      log << "IN_IGNORED: " << event->wd << "::" << filename_stream.str() << "\n";
-      FSW_ELOG(log.str().c_str());
+      FSW_ELOGF("IN_IGNORED: %d::%s\n", event->wd, filename.c_str());
 
       impl->descriptors_to_remove.insert(event->wd);
     }
@@ -401,9 +808,7 @@ namespace fsw
      */
     if (event->mask & IN_MOVE_SELF)
     {
-      std::ostringstream log;
-      log << "IN_MOVE_SELF: " << event->wd << "::" << filename_stream.str() << "\n";
-      FSW_ELOG(log.str().c_str());
+      FSW_ELOGF("IN_MOVE_SELF: %d::%s\n", event->wd, filename.c_str());
 
       impl->watches_to_remove.insert(event->wd);
       impl->descriptors_to_remove.insert(event->wd);
@@ -420,19 +825,43 @@ namespace fsw
      */
     if (event->mask & IN_DELETE_SELF)
     {
-      std::ostringstream log;
-      log << "IN_DELETE_SELF: " << event->wd << "::" << filename_stream.str() << "\n";
-      FSW_ELOG(log.str().c_str());
+      FSW_ELOGF("IN_DELETE_SELF: %d::%s\n", event->wd, filename.c_str());
 
       impl->descriptors_to_remove.insert(event->wd);
     }
+
+    if (!flags.empty())
+    {
+      impl->events.emplace_back(std::move(filename), impl->curr_time, flags, event->cookie);
+    }
   }
 
   void inotify_monitor::preprocess_event(const struct inotify_event *event)
   {
     if (event->mask & IN_Q_OVERFLOW)
     {
-      notify_overflow(impl->wd_to_path[event->wd]);
+      FSW_ELOGF(_("Queue overflow: more than %zu events were queued.\n"), impl->max_queued_events);
+
+      // In recovery mode the overflow is only reported if overflows are
+      // allowed, since the changes whose events were lost are recovered.
+      if (impl->recovery_budget.count() == 0 || allow_overflow)
+        notify_overflow(impl->watches.get_path(event->wd));
+
+      if (impl->recovery_budget.count() > 0) impl->overflowed = true;
+    }
+
+    if (!impl->missing_roots.empty()) process_anchor_event(event);
+
+    // The events of the descriptors watching only anchors are not notified.
+    if (!impl->anchor_descriptors.empty() && !impl->watches.contains(event->wd))
+    {
+      const auto anchor = impl->anchor_descriptors.find(event->wd);
+
+      if (anchor != impl->anchor_descriptors.end())
+      {
+        if (event->mask & IN_IGNORED) impl->anchor_descriptors.erase(anchor);
+        return;
+      }
     }
 
     preprocess_dir_event(event);
@@ -445,7 +874,8 @@ namespace fsw
      * No need to remove the inotify watch because it is removed automatically
      * when a watched element is deleted.
      */
-    impl->wd_to_path.erase(wd);
+    impl->watches.erase(wd);
+    impl->watch_count = impl->watches.size();
   }
 
   void inotify_monitor::process_pending_events()
@@ -474,52 +904,290 @@ namespace fsw
 
     while (fd != impl->descriptors_to_remove.end())
     {
-      const std::string& curr_path = impl->wd_to_path[*fd];
-      impl->path_to_wd.erase(curr_path);
-      impl->wd_to_path.erase(*fd);
-      impl->watched_descriptors.erase(*fd);
+      impl->watches.erase(*fd);
+      impl->watch_count = impl->watches.size();
+
+      // A removed root is watched again as soon as it exists.
+      const auto roots = impl->root_descriptors.equal_range(*fd);
+      for (auto root = roots.first; root != roots.second; ++root)
+        impl->roots_to_retry.push_back(root->second);
+      impl->root_descriptors.erase(roots.first, roots.second);
 
       impl->descriptors_to_remove.erase(fd++);
     }
 
-    // Process paths to be rescanned
-    std::for_each(impl->paths_to_rescan.begin(),
-		  impl->paths_to_rescan.end(),
-		  [this] (const std::string& p)
-		  {
-		    this->scan(p);
-		  }
-		  );
+    scan_created_directories();
 
-    impl->paths_to_rescan.clear();
+    retry_missing_roots();
+
+    if (impl->overflowed) recover_from_overflow();
+
+    poll_unwatched_trees();
   }
 
-  void inotify_monitor::process_synthetic_events()
+  void inotify_monitor::scan_created_directories()
   {
-    for (const std::string& path : impl->paths_to_fire_create)
+    if (impl->created_directories.empty()) return;
+
+    std::vector<created_directory> directories = std::move(impl->created_directories);
+    impl->created_directories.clear();
+
+    // Sorting the paths with the separator before any other character puts
+    // the descendants of a directory right after it, so that the directories
+    // created below a directory that is walked anyway are skipped.
+    std::sort(directories.begin(),
+              directories.end(),
+              [](const created_directory& lhs, const created_directory& rhs)
+              {
+                return std::lexicographical_compare(lhs.path.begin(), lhs.path.end(),
+                                                    rhs.path.begin(), rhs.path.end(),
+                                                    [](char l, char r)
+                                                    {
+                                                      if (l == r) return false;
+                                                      if (l == '/') return true;
+                                                      if (r == '/') return false;
+                                                      return l < r;
+                                                    });
+              });
+
+    size_t walked = 0;
+
+    for (size_t i = 1; i < directories.size(); ++i)
     {
-      FSW_ELOGF(_("Synthetic event: processing directory: %s\n"), path.c_str());
+      created_directory& ancestor = directories[walked];
+      const std::string& path = directories[i].path;
 
-      const auto entries = get_directory_entries(path);
+      const bool is_descendant =
+        path.compare(0, ancestor.path.size(), ancestor.path) == 0 &&
+        (path.size() == ancestor.path.size() || path[ancestor.path.size()] == '/');
 
-      for (const auto& entry : entries)
+      if (is_descendant)
       {
-        std::vector<fsw_event_flag> flags{fsw_event_flag::Created};
+        ancestor.notify = ancestor.notify || directories[i].notify;
+        continue;
+      }
 
-        try
-        {
-          if (entry.is_directory()) flags.push_back(fsw_event_flag::IsDir);
-        }
-        catch (const std::filesystem::filesystem_error& e)
-        {
-          FSW_ELOGF(_("Filesystem error: %s"), e.what());
-        }
+      if (++walked != i) directories[walked] = std::move(directories[i]);
+    }
+
+    directories.resize(walked + 1);
+
+    for (const created_directory& directory : directories)
+      scan_created_directory(directory.path, directory.notify);
+  }
+
+  void inotify_monitor::scan_created_directory(const std::string& path, const bool notify)
+  {
+    FSW_ELOGF(_("Scanning created directory: %s\n"), path.c_str());
+
+    directory_walker walker([this, notify](const std::filesystem::path& p,
+                                           entry_type type,
+                                           bool is_walk_root) -> std::optional<std::filesystem::path>
+                            {
+                              if (is_walk_root)
+                              {
+                                auto directory = visit_path(p, type, false);
+                                if (directory || !notify || recursive) return directory;
+
+                                // The entries of a directory created in a
+                                // non-recursively watched tree are notified,
+                                // but not watched.
+                                if (get_entry_type(p.string()) != entry_type::directory) return std::nullopt;
+                                return p;
+                              }
+
+                              if (notify) notify_created(p, type);
+                              if (!recursive || type == entry_type::other) return std::nullopt;
+
+                              return visit_path(p, type, false);
+                            },
+                            impl->scan_threads,
+                            notify);
+
+    walker.walk(path);
+  }
+
+  void inotify_monitor::notify_created(const std::filesystem::path& path, const entry_type type)
+  {
+    event_flag_set flags{fsw_event_flag::Created};
+
+    // Symbolic links to directories are reported as directories.
+    bool is_dir = type == entry_type::directory;
+    if (type == entry_type::symlink)
+    {
+      std::error_code error;
+      is_dir = std::filesystem::is_directory(path, error);
+    }
+
+    if (is_dir) flags.insert(fsw_event_flag::IsDir);
+
+    impl->events.emplace_back(path.string(), impl->curr_time, flags);
+  }
+
+  std::optional<std::pair<std::filesystem::path, bool>>
+  inotify_monitor::snapshot_path(const std::filesystem::path& p,
+                                 const bool is_root_path,
+                                 tree_snapshot& snapshot)
+  {
+    std::filesystem::path path = p;
+    struct stat fd_stat;
+    if (lstat(path.c_str(), &fd_stat) != 0) return std::nullopt;
+
+    if (follow_symlinks && S_ISLNK(fd_stat.st_mode))
+    {
+      std::error_code error;
+      path = std::filesystem::read_symlink(p, error);
+      if (error || stat(path.c_str(), &fd_stat) != 0) return std::nullopt;
+    }
+
+    const bool is_dir = S_ISDIR(fd_stat.st_mode);
+    if (should_prune_path(path.string(), is_dir, is_root_path)) return std::nullopt;
+
+    snapshot.insert(path.string(), fd_stat);
+
+    return std::make_pair(std::move(path), is_dir);
+  }
 
-        impl->events.emplace_back(entry.path().string(), impl->curr_time, flags);
+  bool inotify_monitor::take_snapshot(const std::string& root,
+                                      tree_snapshot& snapshot,
+                                      const std::chrono::steady_clock::time_point deadline,
+                                      const bool watch_directories)
+  {
+    directory_walker walker([this, &snapshot, deadline, watch_directories](const std::filesystem::path& p,
+                                                       entry_type,
+                                                       bool is_root) -> std::optional<std::filesystem::path>
+                            {
+                              if (std::chrono::steady_clock::now() > deadline) throw snapshot_timeout();
+
+                              const auto entry = snapshot_path(p, is_root, snapshot);
+                              if (!entry) return std::nullopt;
+
+                              const auto& [path, is_dir] = *entry;
+                              if (!is_dir || !(recursive || is_root)) return std::nullopt;
+
+                              // The directories created while the events were
+                              // lost are not watched yet.
+                              if (watch_directories && !is_watched(path.string()) &&
+                                  !add_watch(path.string(), true))
+                                return std::nullopt;
+
+                              return path;
+                            },
+                            impl->scan_threads,
+                            true);
+
+    try
+    {
+      walker.walk(root);
+    }
+    catch (const snapshot_timeout&)
+    {
+      return false;
+    }
+
+    return true;
+  }
+
+  void inotify_monitor::recover_from_overflow()
+  {
+    impl->overflowed = false;
+
+    // The budget is shared by all the roots, and the roots that cannot be
+    // walked within it are reported as overflown.
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + impl->recovery_budget;
+
+    for (auto& [root, snapshot] : impl->snapshots)
+    {
+      tree_snapshot current;
+
+      if (!take_snapshot(root, current, deadline))
+      {
+        FSW_ELOGF(_("Overflow recovery of %s exceeded the time budget.\n"), root.c_str());
+        notify_overflow(root);
+        continue;
       }
+
+      std::vector<event> events = snapshot.diff(current, impl->curr_time);
+      snapshot = std::move(current);
+      FSW_ELOGF(_("Overflow recovery of %s: %zu changes.\n"), root.c_str(), events.size());
+
+      for (auto& evt : events) impl->events.push_back(std::move(evt));
     }
 
-    impl->paths_to_fire_create.clear();
+    FSW_ELOGF(_("Overflow recovery took %.3f s.\n"),
+              std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+
+  void inotify_monitor::poll_unwatched_trees()
+  {
+    const auto now = std::chrono::steady_clock::now();
+
+    // As in the poll monitor, the trees are polled at most once per second.
+    const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(std::max(latency, MIN_POLL_INTERVAL)));
+
+    // The first snapshot of a tree is taken as soon as it cannot be watched.
+    for (std::string& path : impl->trees_to_poll)
+    {
+      const auto [tree, inserted] = impl->polled_trees.try_emplace(std::move(path));
+      if (inserted)
+        take_snapshot(tree->first, tree->second, std::chrono::steady_clock::time_point::max(), false);
+    }
+
+    if (!impl->trees_to_poll.empty()) impl->next_poll = now + interval;
+    impl->trees_to_poll.clear();
+
+    if (impl->polled_trees.empty() || now < impl->next_poll) return;
+
+    impl->next_poll = now + interval;
+    time(&impl->curr_time);
+
+    std::vector<std::string> watched_trees;
+
+    for (auto& [path, snapshot] : impl->polled_trees)
+    {
+      tree_snapshot current;
+      take_snapshot(path, current, std::chrono::steady_clock::time_point::max(), false);
+
+      // The changes of a polled directory other than a root path are reported
+      // by the watch of its parent.
+      const bool is_root_path = std::find(paths.begin(), paths.end(), path) != paths.end();
+
+      for (auto& evt : snapshot.diff(current, impl->curr_time))
+      {
+        if (is_root_path || evt.get_path() != path) impl->events.push_back(std::move(evt));
+      }
+      snapshot = std::move(current);
+
+      // The tree is watched again if watches were released in the meantime,
+      // and no longer polled if it was removed.
+      if (snapshot.empty() || add_watch(path, true)) watched_trees.push_back(path);
+    }
+
+    for (const std::string& path : watched_trees)
+    {
+      const bool exists = !impl->polled_trees[path].empty();
+      impl->polled_trees.erase(path);
+
+      if (exists && recursive) scan(path);
+
+      // A root path is tracked again, or anchored if it was removed.
+      if (std::find(paths.begin(), paths.end(), path) != paths.end())
+        impl->roots_to_retry.push_back(path);
+    }
+  }
+
+  int inotify_monitor::get_poll_timeout_ms(const std::chrono::steady_clock::time_point now) const
+  {
+    const int retry_timeout_ms = impl->missing_roots.get_timeout_ms(now);
+
+    if (impl->polled_trees.empty()) return retry_timeout_ms;
+
+    const auto poll_timeout = std::chrono::ceil<std::chrono::milliseconds>(impl->next_poll - now);
+    const int poll_timeout_ms = static_cast<int>(std::max<long long>(poll_timeout.count(), 0));
+
+    return retry_timeout_ms == -1 ? poll_timeout_ms : std::min(retry_timeout_ms, poll_timeout_ms);
   }
 
   void inotify_monitor::on_stop()
@@ -540,11 +1208,47 @@ namespace fsw
     }
   }
 
+  size_t inotify_monitor::get_buffer_size()
+  {
+    // read() fails with EINVAL if the next event does not fit the buffer.
+    return get_unsigned_property(BUFFER_SIZE_PROPERTY, DEFAULT_BUFFER_SIZE, MAX_EVENT_SIZE);
+  }
+
+  size_t inotify_monitor::get_scan_threads()
+  {
+    return get_unsigned_property(SCAN_THREADS_PROPERTY, directory_walker::default_thread_count(), 1);
+  }
+
+  std::chrono::milliseconds inotify_monitor::get_overflow_recovery_budget()
+  {
+    return std::chrono::milliseconds(get_unsigned_property(OVERFLOW_RECOVERY_PROPERTY, 0));
+  }
+
+  static watch_limit_policy get_watch_limit_policy(const std::string& policy_value)
+  {
+    if (policy_value.empty() || policy_value == "warn") return watch_limit_policy::warn;
+    if (policy_value == "fail") return watch_limit_policy::fail;
+    if (policy_value == "poll") return watch_limit_policy::poll;
+
+    throw libfsw_exception(std::string(_("Invalid value: ")) + policy_value);
+  }
+
   void inotify_monitor::run()
   {
-    std::array<char, BUFFER_SIZE> buffer{};
+    std::vector<char> buffer(get_buffer_size());
+    impl->scan_threads = get_scan_threads();
+    impl->event_mask = get_event_mask();
+    impl->mask_create = WATCH_CREATE_FLAG != 0;
+    impl->recovery_budget = get_overflow_recovery_budget();
+    impl->watch_limit = get_watch_limit_policy(get_property(WATCH_LIMIT_PROPERTY));
+    read_inotify_limits();
     std::array<struct epoll_event, EPOLL_EVENT_COUNT> epoll_events{};
-    const int timeout_ms = latency_to_timeout_ms(this->latency);
+
+    scan_root_paths();
+
+    FSW_ELOGF(_("Watching %zu directories out of %zu watches per user.\n"),
+              impl->watches.size(),
+              impl->max_user_watches);
 
     for(;;)
     {
@@ -554,11 +1258,18 @@ namespace fsw
 
       process_pending_events();
 
-      scan_root_paths();
+      if (!impl->events.empty())
+      {
+        notify_events(std::move(impl->events));
+        impl->events.clear();
+      }
+
+      // The watches only change in response to events, so that the monitor
+      // sleeps until an event is received, the monitor is stopped, a missing
+      // root whose anchor could not be watched has to be retried, or the trees
+      // that cannot be watched have to be polled.
+      const int timeout_ms = get_poll_timeout_ms(std::chrono::steady_clock::now());
 
-      // Use epoll to timeout on file descriptor read the amount specified by
-      // the monitor latency.  This way, the monitor has a chance to update its
-      // watches with at least the periodicity expected by the user.
       int rv = epoll_wait(impl->epoll_handle,
                           epoll_events.data(),
                           epoll_events.size(),
@@ -596,11 +1307,7 @@ namespace fsw
                                     buffer.data(),
                                     buffer.size());
 
-          {
-            std::ostringstream log;
-            log << _("Number of records: ") << record_num << "\n";
-            FSW_ELOG(log.str().c_str());
-          }
+          FSW_ELOGF(_("Number of records: %zd\n"), record_num);
 
           if (!record_num)
           {
@@ -625,21 +1332,27 @@ namespace fsw
 
             p += (sizeof(struct inotify_event)) + event->len;
           }
+
+          // The kernel fills the buffer with as many events as fit: if there
+          // is room left for the largest event, the queue has been drained and
+          // another read() would only fail with EAGAIN.  The descriptor is
+          // level-triggered, so events queued in the meantime wake up the next
+          // epoll_wait() call.
+          if (buffer.size() - static_cast<size_t>(record_num) >= MAX_EVENT_SIZE) break;
         }
       }
 
       if (!impl->events.empty())
       {
-        notify_events(impl->events);
+        notify_events(std::move(impl->events));
         impl->events.clear();
       }
 
       process_pending_events();
-      process_synthetic_events();
 
       if (!impl->events.empty())
       {
-        notify_events(impl->events);
+        notify_events(std::move(impl->events));
         impl->events.clear();
       }
       if (wake_requested) break;
@@ -27,11 +27,14 @@
 #  define FSW_INOTIFY_MONITOR_H
 
 #  include "monitor.hpp"
+#  include "directory_reader.hpp"
 #  include <sys/inotify.h>
+#  include <chrono>
 #  include <string>
 #  include <vector>
 #  include <filesystem>
 #  include <functional>
+#  include <optional>
 
 namespace fsw
 {
@@ -40,6 +43,7 @@ namespace fsw
    * FSEvents monitor.
    */
   struct inotify_monitor_impl;
+  class tree_snapshot;
 
   /**
    * @brief Solaris/Illumos monitor.
@@ -50,6 +54,55 @@ namespace fsw
   class inotify_monitor : public monitor
   {
   public:
+    /**
+     * @brief Name of the property setting the size, in bytes, of the buffer
+     * used to read events from the inotify descriptor.
+     *
+     * The default size is 64 KiB, large enough to drain a burst of events in
+     * a few read() calls.  The size cannot be smaller than the size of the
+     * largest inotify event.
+     */
+    static constexpr const char *BUFFER_SIZE_PROPERTY = "inotify.buffer-size";
+
+    /**
+     * @brief Name of the property setting the maximum number of threads
+     * listing directories while scanning the watched trees.
+     *
+     * The default is 4.  Watches are added by one thread at a time.  Setting
+     * the property to 1 scans the trees serially.
+     */
+    static constexpr const char *SCAN_THREADS_PROPERTY = "inotify.scan-threads";
+
+    /**
+     * @brief Name of the property enabling the recovery from queue overflows
+     * and setting its time budget, in milliseconds.
+     *
+     * In recovery mode, the monitor keeps a snapshot of the status of the
+     * files of the watched trees.  When the queue overflows, the trees are
+     * walked again and compared with their snapshots to notify the changes
+     * whose events were lost, and the overflow is notified only if overflows
+     * are allowed.  The trees that cannot be walked within the budget are
+     * notified as overflown.  Recovery is disabled by default, or if the
+     * budget is 0.
+     */
+    static constexpr const char *OVERFLOW_RECOVERY_PROPERTY = "inotify.overflow-recovery";
+
+    /**
+     * @brief Name of the property setting what the monitor does when a
+     * directory cannot be watched because the limit of inotify watches per
+     * user, @c fs.inotify.max_user_watches, is reached.
+     *
+     * The supported values are:
+     *
+     *   - @c warn: the directory and its subtree are not watched and the limit
+     *     is reported once on the standard error.  This is the default.
+     *   - @c fail: the monitor fails with an exception reporting the limit.
+     *   - @c poll: the subtrees that cannot be watched are polled every
+     *     _latency_ seconds, at least one, comparing snapshots of the status of
+     *     their files.  The monitor tries to watch them again at each poll.
+     */
+    static constexpr const char *WATCH_LIMIT_PROPERTY = "inotify.watch-limit";
+
     /**
      * @brief Constructs an instance of this class.
      */
@@ -62,6 +115,17 @@ namespace fsw
      */
     ~inotify_monitor() override;
 
+    /**
+     * @brief Gets the number of inotify watches held by the monitor.
+     *
+     * The watches count against the limit of inotify watches per user,
+     * @c fs.inotify.max_user_watches.  This function can be called while the
+     * monitor is running.
+     *
+     * @return The number of inotify watches held by the monitor.
+     */
+    size_t get_watch_count() const;
+
   protected:
     /**
      * @brief Executes the monitor loop.
@@ -77,15 +141,45 @@ namespace fsw
     inotify_monitor(const inotify_monitor& orig) = delete;
     inotify_monitor& operator=(const inotify_monitor& that) = delete;
 
+    size_t get_buffer_size();
+    size_t get_scan_threads();
+    std::chrono::milliseconds get_overflow_recovery_budget();
+    void read_inotify_limits();
     void scan_root_paths();
+    void watch_root(const std::string& root);
+    void anchor_root(const std::string& root);
+    void process_anchor_event(const struct inotify_event *event);
+    void retry_missing_roots();
+    void release_anchors();
     bool is_watched(const std::string& path) const;
+    bool is_excluded_directory(int wd);
+    std::string get_child_path(const struct inotify_event *event) const;
     void preprocess_dir_event(const struct inotify_event *event);
     void preprocess_event(const struct inotify_event *event);
     void preprocess_node_event(const struct inotify_event *event);
-    void scan(const std::filesystem::path& path, bool is_root_path = false);
-    bool add_watch(const std::string& path);
+    void scan(const std::filesystem::path& path,
+              bool is_root_path = false,
+              tree_snapshot *snapshot = nullptr);
+    std::optional<std::filesystem::path> visit_path(const std::filesystem::path& path,
+                                                    entry_type type,
+                                                    bool is_root_path);
+    uint32_t get_event_mask() const;
+    bool add_watch(const std::string& path, bool is_dir);
+    void on_watch_limit(const std::string& path, bool is_dir);
     void process_pending_events();
-    void process_synthetic_events();
+    std::optional<std::pair<std::filesystem::path, bool>> snapshot_path(const std::filesystem::path& path,
+                                                                        bool is_root_path,
+                                                                        tree_snapshot& snapshot);
+    bool take_snapshot(const std::string& root,
+                       tree_snapshot& snapshot,
+                       std::chrono::steady_clock::time_point deadline,
+                       bool watch_directories = true);
+    void recover_from_overflow();
+    void poll_unwatched_trees();
+    int get_poll_timeout_ms(std::chrono::steady_clock::time_point now) const;
+    void scan_created_directories();
+    void scan_created_directory(const std::string& path, bool notify);
+    void notify_created(const std::filesystem::path& path, entry_type type);
     void remove_watch(int fd);
 
     std::unique_ptr<fsw::inotify_monitor_impl> impl;
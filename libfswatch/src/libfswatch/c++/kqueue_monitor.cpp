@@ -109,15 +109,15 @@ namespace fsw
     terminate_kqueue();
   }
 
-  static std::vector<fsw_event_flag> decode_flags(uint32_t flag)
+  static event_flag_set decode_flags(uint32_t flag)
   {
-    std::vector<fsw_event_flag> evt_flags;
+    event_flag_set evt_flags;
 
     for (const KqueueFlagType& type : event_flag_type)
     {
       if (flag & type.flag)
       {
-        evt_flags.push_back(type.type);
+        evt_flags.insert(type.type);
       }
     }
 
@@ -370,7 +370,7 @@ namespace fsw
 
     if (!events.empty())
     {
-      notify_events(events);
+      notify_events(std::move(events));
     }
   }
 
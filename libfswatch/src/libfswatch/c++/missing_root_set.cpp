@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "missing_root_set.hpp"
+#include <filesystem>
+#include <system_error>
+
+namespace fsw
+{
+  std::string find_anchor_path(const std::string& root)
+  {
+    std::filesystem::path path(root);
+
+    // Strip the trailing separators, which make parent_path() return the path
+    // itself.
+    while (!path.has_filename() && path.has_relative_path()) path = path.parent_path();
+
+    for (;;)
+    {
+      const std::filesystem::path parent = path.parent_path();
+      path = parent.empty() ? std::filesystem::path(".") : parent;
+
+      std::error_code error;
+      if (std::filesystem::is_directory(path, error)) return path.string();
+      if (parent.empty() || path == path.root_path()) return "";
+    }
+  }
+}
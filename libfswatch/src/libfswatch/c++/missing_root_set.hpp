@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file
+ * @brief Header of the fsw::missing_root_set class.
+ *
+ * This header file defines the fsw::missing_root_set class template, the set
+ * of the monitored paths that do not exist, used by the monitors to watch for
+ * their creation.
+ *
+ * @copyright Copyright (c) 2026 Enrico M. Crisostomo
+ * @license GNU General Public License v. 3.0
+ * @author Enrico M. Crisostomo
+ * @version 1.22.0
+ */
+#ifndef FSW_MISSING_ROOT_SET_H
+#  define FSW_MISSING_ROOT_SET_H
+
+#  include <algorithm>
+#  include <chrono>
+#  include <climits>
+#  include <cstddef>
+#  include <functional>
+#  include <optional>
+#  include <string>
+#  include <unordered_map>
+#  include <unordered_set>
+#  include <vector>
+
+namespace fsw
+{
+  /**
+   * @brief Finds the anchor directory of a missing path.
+   *
+   * @param root The missing path.
+   * @return The nearest ancestor of @p root that is a directory, or an empty
+   * string if none exists.  The ancestor of a relative path without parent is
+   * the current directory.
+   */
+  std::string find_anchor_path(const std::string& root);
+
+  /**
+   * @brief Set of missing root paths.
+   *
+   * A monitor does not poll the monitored paths that do not exist: it watches
+   * the nearest existing ancestor of each of them, its @e anchor, and retries
+   * a path when an entry is created in or moved to its anchor, or when the
+   * anchor itself is removed.  The paths whose anchor cannot be watched are
+   * retried with an exponential backoff instead, starting from
+   * MIN_RETRY_INTERVAL and doubling up to MAX_RETRY_INTERVAL.
+   *
+   * This class only keeps the bookkeeping: the monitor watches the anchors and
+   * retries the paths.  Anchors are identified by a key of type @p Anchor
+   * chosen by the monitor, such as the watch descriptor or the file handle of
+   * the directory, so that events can be matched to anchors without building
+   * their path.
+   *
+   * @tparam Anchor The type of the keys of the anchors.
+   * @tparam Hash The hash function of @p Anchor.
+   */
+  template<typename Anchor, typename Hash = std::hash<Anchor>>
+  class missing_root_set
+  {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief The first retry interval of a path without an anchor.
+     */
+    static constexpr clock::duration MIN_RETRY_INTERVAL = std::chrono::seconds(1);
+
+    /**
+     * @brief The maximum retry interval of a path without an anchor.
+     */
+    static constexpr clock::duration MAX_RETRY_INTERVAL = std::chrono::seconds(64);
+
+    /**
+     * @brief Adds a missing path, or updates its anchor.
+     *
+     * If @p anchor is empty, the path is retried with a backoff: its retry
+     * interval is doubled if the path was already waiting for a retry.
+     *
+     * @param root The missing path.
+     * @param anchor The key of the watched ancestor of @p root, if any.
+     * @param now The current time.
+     */
+    void insert(const std::string& root,
+                const std::optional<Anchor>& anchor,
+                clock::time_point now)
+    {
+      auto found = roots.find(root);
+      clock::duration interval = MIN_RETRY_INTERVAL;
+
+      if (found != roots.end())
+      {
+        if (!found->second.anchor)
+          interval = std::min(found->second.interval * 2, MAX_RETRY_INTERVAL);
+
+        detach(root, found->second);
+      }
+      else
+      {
+        found = roots.emplace(root, root_state{}).first;
+      }
+
+      root_state& state = found->second;
+      state.anchor = anchor;
+
+      if (!anchor)
+      {
+        state.interval = interval;
+        state.retry = now + interval;
+        ++waiting;
+      }
+      else
+      {
+        state.interval = clock::duration::zero();
+        anchors[*anchor].insert(root);
+      }
+    }
+
+    /**
+     * @brief Removes a path.
+     *
+     * @param root The path to remove.
+     */
+    void erase(const std::string& root)
+    {
+      auto found = roots.find(root);
+      if (found == roots.end()) return;
+
+      detach(root, found->second);
+      roots.erase(found);
+    }
+
+    /**
+     * @brief Checks whether a path is missing.
+     *
+     * @param root The path to check.
+     * @return @c true if @p root is in the set, @c false otherwise.
+     */
+    bool contains(const std::string& root) const
+    {
+      return roots.find(root) != roots.end();
+    }
+
+    /**
+     * @brief Checks whether any path is anchored to a directory.
+     *
+     * @param anchor The key of the directory.
+     * @return @c true if a path is anchored to @p anchor.
+     */
+    bool is_anchor(const Anchor& anchor) const
+    {
+      return anchors.find(anchor) != anchors.end();
+    }
+
+    /**
+     * @brief Gets the paths anchored to a directory.
+     *
+     * @param anchor The key of the directory.
+     * @return The paths anchored to @p anchor.
+     */
+    std::vector<std::string> get_anchored(const Anchor& anchor) const
+    {
+      auto anchored = anchors.find(anchor);
+      if (anchored == anchors.end()) return {};
+
+      return {anchored->second.begin(), anchored->second.end()};
+    }
+
+    /**
+     * @brief Gets the paths without an anchor whose retry time has come.
+     *
+     * @param now The current time.
+     * @return The paths to retry.
+     */
+    std::vector<std::string> get_due(clock::time_point now) const
+    {
+      std::vector<std::string> due;
+      if (waiting == 0) return due;
+
+      for (const auto& [root, state] : roots)
+      {
+        if (!state.anchor && state.retry <= now) due.push_back(root);
+      }
+
+      return due;
+    }
+
+    /**
+     * @brief Gets the time to wait for the next retry.
+     *
+     * @param now The current time.
+     * @return The number of milliseconds until the next retry of a path
+     * without an anchor, or @c -1 if no path is waiting for a retry.
+     */
+    int get_timeout_ms(clock::time_point now) const
+    {
+      if (waiting == 0) return -1;
+
+      clock::time_point next = clock::time_point::max();
+
+      for (const auto& [root, state] : roots)
+      {
+        if (!state.anchor) next = std::min(next, state.retry);
+      }
+
+      if (next <= now) return 0;
+
+      const auto wait = std::chrono::ceil<std::chrono::milliseconds>(next - now).count();
+
+      return wait >= INT_MAX ? INT_MAX : static_cast<int>(wait);
+    }
+
+    /**
+     * @brief Checks whether the set is empty.
+     *
+     * @return @c true if no path is missing, @c false otherwise.
+     */
+    bool empty() const
+    {
+      return roots.empty();
+    }
+
+    /**
+     * @brief Gets the number of missing paths.
+     *
+     * @return The number of missing paths.
+     */
+    size_t size() const
+    {
+      return roots.size();
+    }
+
+  private:
+    struct root_state
+    {
+      std::optional<Anchor> anchor;
+      clock::duration interval{};
+      clock::time_point retry{};
+    };
+
+    void detach(const std::string& root, const root_state& state)
+    {
+      if (!state.anchor)
+      {
+        --waiting;
+        return;
+      }
+
+      auto anchored = anchors.find(*state.anchor);
+      anchored->second.erase(root);
+      if (anchored->second.empty()) anchors.erase(anchored);
+    }
+
+    std::unordered_map<std::string, root_state> roots;
+    std::unordered_map<Anchor, std::unordered_set<std::string>, Hash> anchors;
+    size_t waiting = 0;
+  };
+}
+
+#endif  /* FSW_MISSING_ROOT_SET_H */
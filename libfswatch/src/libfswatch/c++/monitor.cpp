@@ -19,34 +19,589 @@
 #include "monitor_factory.hpp"
 #include "libfswatch_exception.hpp"
 #include "libfswatch/c/libfswatch_log.h"
-#include "string/string_utils.hpp"
+#include "spmc_ring.hpp"
+#include <cerrno>
+#include <cstdint>
 #include <cstdlib>
 #include <algorithm>
+#include <condition_variable>
+#include <exception>
 #include <memory>
 #include <thread>
-#include <regex>
 #include <sstream>
 #include <utility>
 #include <ctime>
+#include <functional>
 #include <map>
-#include <set>
-#include <tuple>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace std::chrono;
 
 namespace fsw
 {
-  struct compiled_monitor_filter
+  namespace
   {
-    std::regex regex;
-    fsw_filter_type type;
-  };
+    /*
+     * Identity of an event for bubbling purposes: events with the same time,
+     * path, correlation id and process metadata are bubbled together.
+     */
+    struct bubble_key_hash
+    {
+      size_t operator()(const event *evt) const
+      {
+        size_t seed = std::hash<std::string_view>()(evt->get_path());
+
+        const auto combine = [&seed](size_t value)
+        {
+          seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+        };
+
+        combine(std::hash<time_t>()(evt->get_time()));
+        combine(std::hash<unsigned long>()(evt->get_correlation_id()));
+        combine(std::hash<long long>()(evt->get_process_id()));
+
+        return seed;
+      }
+    };
+
+    struct bubble_key_equal
+    {
+      bool operator()(const event *lhs, const event *rhs) const
+      {
+        return lhs->get_time() == rhs->get_time() &&
+               lhs->get_correlation_id() == rhs->get_correlation_id() &&
+               lhs->get_process_id_kind() == rhs->get_process_id_kind() &&
+               lhs->get_process_id() == rhs->get_process_id() &&
+               lhs->get_process_pidfd() == rhs->get_process_pidfd() &&
+               lhs->has_process_pidfd() == rhs->has_process_pidfd() &&
+               lhs->get_path() == rhs->get_path() &&
+               lhs->get_secondary_path() == rhs->get_secondary_path();
+      }
+    };
+  }
 
   #define FSW_MONITOR_RUN_GUARD std::unique_lock<std::mutex> run_guard(run_mutex)
   #define FSW_MONITOR_RUN_GUARD_LOCK run_guard.lock()
   #define FSW_MONITOR_RUN_GUARD_UNLOCK run_guard.unlock()
   #define FSW_MONITOR_NOTIFY_GUARD std::unique_lock<std::mutex> notify_guard(notify_mutex)
 
+  /*
+   * State of the asynchronous delivery.  The monitor thread, serialized by
+   * notify_mutex, is the only producer of the ring and the delivery thread is
+   * its only consumer.  The mutexes are only used to put either thread to
+   * sleep and wake it up, never to exchange events: a thread announces it is
+   * going to sleep through an atomic flag and the other thread only takes the
+   * mutex to notify it if the flag is set.
+   */
+  struct monitor::async_delivery
+  {
+    async_delivery(size_t capacity, async_overflow_policy policy) :
+      ring(capacity), policy(policy)
+    {
+    }
+
+    void push(std::vector<event>& events);
+    void push_coalesced(event& evt);
+    void wait_for_room();
+    void wake_consumer();
+    void reset();
+    void finish();
+    bool has_events() const;
+    void run(monitor *mon);
+
+    spmc_ring<event> ring;
+    const async_overflow_policy policy;
+
+    // Events held aside by the coalesce policy, in the order in which their
+    // paths were first seen.  While the backlog is not empty, new events are
+    // appended to it rather than to the ring, so that the delivery order is
+    // preserved.  The backlog holds at most as many paths as the ring: events
+    // of further paths are dropped and an overflow is reported.
+    std::mutex backlog_mutex;
+    std::vector<event> backlog;
+    std::unordered_map<std::string, size_t> backlog_index;
+    bool backlog_overflowed = false;
+    std::atomic<bool> backlog_pending{false};
+
+    std::mutex sleep_mutex;
+    std::condition_variable consumer_wakeup;
+    std::condition_variable producer_wakeup;
+    std::atomic<bool> consumer_sleeping{false};
+    std::atomic<bool> producer_sleeping{false};
+    std::atomic<bool> finished{false};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+
+    std::atomic<unsigned long long> delivered{0};
+    std::atomic<unsigned long long> blocked{0};
+    std::atomic<unsigned long long> dropped{0};
+    std::atomic<unsigned long long> coalesced{0};
+  };
+
+  void monitor::async_delivery::push(std::vector<event>& events)
+  {
+    for (event& evt : events)
+    {
+      // The monitor is stopping because the callback failed.
+      if (failed.load(std::memory_order_acquire)) return;
+
+      if (policy == async_overflow_policy::coalesce)
+      {
+        if (backlog_pending.load(std::memory_order_acquire) || !ring.try_push(std::move(evt)))
+          push_coalesced(evt);
+
+        continue;
+      }
+
+      if (ring.try_push(std::move(evt))) continue;
+
+      if (policy == async_overflow_policy::drop_oldest)
+      {
+        do
+        {
+          if (ring.try_pop()) ++dropped;
+        }
+        while (!ring.try_push(std::move(evt)));
+
+        continue;
+      }
+
+      ++blocked;
+
+      // The delivery thread may be sleeping on the events pushed so far.
+      wake_consumer();
+
+      do
+      {
+        wait_for_room();
+        if (failed.load(std::memory_order_acquire)) return;
+      }
+      while (!ring.try_push(std::move(evt)));
+    }
+
+    wake_consumer();
+  }
+
+  void monitor::async_delivery::wake_consumer()
+  {
+    // Wake up the delivery thread if it is sleeping.  The fence pairs with the
+    // one in run(): either this thread sees the flag, or the delivery thread
+    // sees the new events before going to sleep.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (consumer_sleeping.load(std::memory_order_relaxed))
+    {
+      std::lock_guard<std::mutex> sleep_guard(sleep_mutex);
+      consumer_wakeup.notify_one();
+    }
+  }
+
+  void monitor::async_delivery::push_coalesced(event& evt)
+  {
+    std::lock_guard<std::mutex> backlog_guard(backlog_mutex);
+
+    // The delivery thread may have drained the backlog in the meantime.
+    if (!backlog_pending.load(std::memory_order_relaxed) && ring.try_push(std::move(evt)))
+      return;
+
+    const auto [it, inserted] = backlog_index.try_emplace(evt.get_path(), backlog.size());
+
+    if (!inserted)
+    {
+      event_flag_set flags = backlog[it->second].get_flag_set();
+      flags |= evt.get_flag_set();
+      backlog[it->second].set_flag_set(flags);
+      ++coalesced;
+    }
+    else if (backlog.size() < ring.capacity())
+    {
+      backlog.push_back(std::move(evt));
+    }
+    else
+    {
+      backlog_index.erase(it);
+      backlog_overflowed = true;
+      ++dropped;
+    }
+
+    backlog_pending.store(true, std::memory_order_release);
+  }
+
+  void monitor::async_delivery::wait_for_room()
+  {
+    std::unique_lock<std::mutex> sleep_guard(sleep_mutex);
+
+    producer_sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    producer_wakeup.wait(sleep_guard,
+                         [this]
+                         {
+                           return ring.size() < ring.capacity() ||
+                                  failed.load(std::memory_order_acquire);
+                         });
+
+    producer_sleeping.store(false, std::memory_order_relaxed);
+  }
+
+  void monitor::async_delivery::reset()
+  {
+    // Discard the events left over by a failed callback.
+    while (ring.try_pop()) {}
+
+    backlog.clear();
+    backlog_index.clear();
+    backlog_overflowed = false;
+    backlog_pending.store(false);
+    finished.store(false);
+    failed.store(false);
+    error = nullptr;
+  }
+
+  void monitor::async_delivery::finish()
+  {
+    std::lock_guard<std::mutex> sleep_guard(sleep_mutex);
+    finished.store(true, std::memory_order_release);
+    consumer_wakeup.notify_one();
+  }
+
+  bool monitor::async_delivery::has_events() const
+  {
+    return !ring.empty() || backlog_pending.load(std::memory_order_acquire);
+  }
+
+  void monitor::async_delivery::run(monitor *mon)
+  {
+    FSW_ELOG(_("Delivery thread: starting\n"));
+
+    std::vector<event> batch;
+    batch.reserve(ring.capacity());
+
+    for (;;)
+    {
+      while (batch.size() < ring.capacity())
+      {
+        std::optional<event> evt = ring.try_pop();
+        if (!evt) break;
+
+        batch.push_back(std::move(*evt));
+      }
+
+      // The backlog only holds events newer than those in the ring.
+      if (batch.empty() && backlog_pending.load(std::memory_order_acquire))
+      {
+        std::lock_guard<std::mutex> backlog_guard(backlog_mutex);
+        batch.swap(backlog);
+        backlog_index.clear();
+        backlog_pending.store(false, std::memory_order_release);
+
+        if (backlog_overflowed && mon->allow_overflow)
+        {
+          time_t curr_time;
+          time(&curr_time);
+
+          batch.push_back({"", curr_time, {fsw_event_flag::Overflow}});
+        }
+
+        backlog_overflowed = false;
+      }
+
+      if (!batch.empty())
+      {
+        // Wake up the monitor thread if it is waiting for room.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (producer_sleeping.load(std::memory_order_relaxed))
+        {
+          std::lock_guard<std::mutex> sleep_guard(sleep_mutex);
+          producer_wakeup.notify_one();
+        }
+
+        FSW_ELOGF(_("Notifying events #: %zu.\n"), batch.size());
+
+        try
+        {
+          mon->callback(batch, mon->context);
+        }
+        catch (...)
+        {
+          // Stop the monitor and let start() rethrow the error.
+          error = std::current_exception();
+
+          {
+            std::lock_guard<std::mutex> sleep_guard(sleep_mutex);
+            failed.store(true, std::memory_order_release);
+            producer_wakeup.notify_one();
+          }
+
+          mon->stop();
+          break;
+        }
+
+        delivered += batch.size();
+        batch.clear();
+        continue;
+      }
+
+      std::unique_lock<std::mutex> sleep_guard(sleep_mutex);
+
+      consumer_sleeping.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      // Events pushed before the monitor stopped are delivered before exiting.
+      if (!has_events() && finished.load(std::memory_order_acquire)) break;
+
+      consumer_wakeup.wait(sleep_guard,
+                           [this]
+                           {
+                             return has_events() ||
+                                    finished.load(std::memory_order_acquire);
+                           });
+
+      consumer_sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    FSW_ELOG(_("Delivery thread: exiting\n"));
+  }
+
+  /*
+   * State of the debounce stage.  Pending events are indexed by path, and
+   * each pending path is scheduled in exactly one slot of a timer wheel whose
+   * tick is a fraction of the window, so that a deadline is never more than
+   * half a revolution away.  Paths receiving new events are not rescheduled:
+   * when their slot expires, they are either emitted, if they have been quiet
+   * for the whole window, or moved to the slot of their new deadline.  Idle
+   * events do not refer to a path and are emitted as soon as they are added.
+   */
+  struct monitor::debouncer
+  {
+    using clock = steady_clock;
+
+    static constexpr size_t wheel_size = 64;
+
+    explicit debouncer(milliseconds window) :
+      window(window),
+      tick(std::max(milliseconds(1),
+                    window / static_cast<milliseconds::rep>(wheel_size / 2))),
+      wheel(wheel_size)
+    {
+    }
+
+    struct pending_event
+    {
+      event evt;
+      clock::time_point last_seen;
+    };
+
+    void add(std::vector<event>& events);
+    void schedule(const std::string& path, clock::time_point deadline);
+    void expire(clock::time_point now, std::vector<event>& expired);
+    void flush(std::vector<event>& expired);
+    void reset();
+    void finish();
+    void run(monitor *mon);
+
+    const milliseconds window;
+    const milliseconds tick;
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::unordered_map<std::string, pending_event> pending;
+    std::vector<event> idle_events;
+    std::vector<std::vector<const std::string *>> wheel;
+    size_t current_slot = 0;
+    clock::time_point slot_deadline;
+    bool finished = false;
+    bool failed = false;
+    std::exception_ptr error;
+  };
+
+  void monitor::debouncer::add(std::vector<event>& events)
+  {
+    const clock::time_point now = clock::now();
+    std::lock_guard<std::mutex> guard(mutex);
+
+    if (failed) return;
+
+    // The wheel does not turn while there are no pending events.
+    const bool was_idle = pending.empty();
+    if (was_idle) slot_deadline = now + tick;
+
+    const bool had_idle_events = !idle_events.empty();
+
+    for (event& evt : events)
+    {
+      if (evt.get_flag_set().contains(NoOp))
+      {
+        idle_events.push_back(std::move(evt));
+        continue;
+      }
+
+      auto it = pending.find(evt.get_path());
+
+      if (it != pending.end())
+      {
+        event_flag_set flags = it->second.evt.get_flag_set();
+        flags |= evt.get_flag_set();
+        it->second.evt.set_flag_set(flags);
+        it->second.last_seen = now;
+        continue;
+      }
+
+      std::string path = evt.get_path();
+      it = pending.emplace(std::move(path), pending_event{std::move(evt), now}).first;
+      schedule(it->first, now + window);
+    }
+
+    if ((was_idle && !pending.empty()) || (!had_idle_events && !idle_events.empty()))
+      wakeup.notify_one();
+  }
+
+  void monitor::debouncer::schedule(const std::string& path,
+                                    clock::time_point deadline)
+  {
+    size_t ticks = 0;
+
+    if (deadline > slot_deadline)
+    {
+      ticks = static_cast<size_t>((deadline - slot_deadline + tick - clock::duration(1)) / tick);
+      ticks = std::min(ticks, wheel_size - 1);
+    }
+
+    wheel[(current_slot + ticks) % wheel_size].push_back(&path);
+  }
+
+  void monitor::debouncer::expire(clock::time_point now,
+                                  std::vector<event>& expired)
+  {
+    while (!pending.empty() && slot_deadline <= now)
+    {
+      std::vector<const std::string *> slot;
+      slot.swap(wheel[current_slot]);
+
+      current_slot = (current_slot + 1) % wheel_size;
+      slot_deadline += tick;
+
+      for (const std::string *path : slot)
+      {
+        auto it = pending.find(*path);
+        const clock::time_point deadline = it->second.last_seen + window;
+
+        if (deadline > now)
+        {
+          schedule(it->first, deadline);
+          continue;
+        }
+
+        expired.push_back(std::move(it->second.evt));
+        pending.erase(it);
+      }
+    }
+  }
+
+  void monitor::debouncer::flush(std::vector<event>& expired)
+  {
+    // Emit the pending events in the order in which they were scheduled.
+    for (size_t i = 0; i < wheel_size; ++i)
+    {
+      auto& slot = wheel[(current_slot + i) % wheel_size];
+
+      for (const std::string *path : slot)
+        expired.push_back(std::move(pending.find(*path)->second.evt));
+
+      slot.clear();
+    }
+
+    pending.clear();
+  }
+
+  void monitor::debouncer::reset()
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+
+    for (auto& slot : wheel) slot.clear();
+    pending.clear();
+    idle_events.clear();
+    current_slot = 0;
+    finished = false;
+    failed = false;
+    error = nullptr;
+  }
+
+  void monitor::debouncer::finish()
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    finished = true;
+    wakeup.notify_one();
+  }
+
+  void monitor::debouncer::run(monitor *mon)
+  {
+    FSW_ELOG(_("Debounce thread: starting\n"));
+
+    std::vector<event> expired;
+
+    for (;;)
+    {
+      bool exiting;
+
+      {
+        std::unique_lock<std::mutex> guard(mutex);
+
+        if (!finished)
+        {
+          if (pending.empty())
+            wakeup.wait(guard,
+                        [this]
+                        {
+                          return finished || !pending.empty() || !idle_events.empty();
+                        });
+          else
+            wakeup.wait_until(guard,
+                              slot_deadline,
+                              [this] { return finished || !idle_events.empty(); });
+        }
+
+        // Pending events are emitted when the monitor stops.
+        exiting = finished;
+
+        if (exiting) flush(expired);
+        else expire(clock::now(), expired);
+
+        for (event& evt : idle_events) expired.push_back(std::move(evt));
+        idle_events.clear();
+      }
+
+      if (!expired.empty())
+      {
+        try
+        {
+          mon->dispatch_events(expired);
+        }
+        catch (...)
+        {
+          // Stop the monitor and let start() rethrow the error.
+          {
+            std::lock_guard<std::mutex> guard(mutex);
+            error = std::current_exception();
+            failed = true;
+          }
+
+          mon->stop();
+          break;
+        }
+
+        expired.clear();
+      }
+
+      if (exiting) break;
+    }
+
+    FSW_ELOG(_("Debounce thread: exiting\n"));
+  }
+
   monitor::monitor(std::vector<std::string> paths,
                    FSW_EVENT_CALLBACK *callback,
                    void *context) :
@@ -114,45 +669,14 @@ namespace fsw
 
   void monitor::add_filter(const monitor_filter& filter)
   {
-    std::regex::flag_type regex_flags = std::regex::basic;
-
-    if (filter.extended) regex_flags = std::regex::extended;
-    if (!filter.case_sensitive) regex_flags |= std::regex::icase;
-
-    try
-    {
-      this->filters.push_back({std::regex(filter.text, regex_flags),
-                               filter.type});
-    }
-    catch (const std::regex_error& error)
-    {
-      throw libfsw_exception(
-        string_utils::string_from_format(
-          _("An error occurred during the compilation of %s"),
-          filter.text.c_str()),
-        FSW_ERR_INVALID_REGEX);
-    }
+    filters.add(filter);
+    filters.compile();
   }
 
   void monitor::add_prune_filter(const monitor_filter& filter)
   {
-    std::regex::flag_type regex_flags = std::regex::basic;
-
-    if (filter.extended) regex_flags = std::regex::extended;
-    if (!filter.case_sensitive) regex_flags |= std::regex::icase;
-
-    try
-    {
-      prune_filters.emplace_back(filter.text, regex_flags);
-    }
-    catch (const std::regex_error& error)
-    {
-      throw libfsw_exception(
-        string_utils::string_from_format(
-          _("An error occurred during the compilation of %s"),
-          filter.text.c_str()),
-        FSW_ERR_INVALID_REGEX);
-    }
+    prune_filters.add(filter);
+    prune_filters.compile();
   }
 
   void monitor::set_property(const std::string& name, const std::string& value)
@@ -170,14 +694,45 @@ namespace fsw
     return properties[name];
   }
 
+  size_t monitor::get_unsigned_property(const std::string& name,
+                                        size_t default_value,
+                                        size_t min_value)
+  {
+    const std::string value = get_property(name);
+
+    if (value.empty()) return default_value;
+
+    // strtoull() skips leading spaces and negates a leading -: the value must
+    // start with a digit.
+    char *end;
+    errno = 0;
+    const unsigned long long parsed_value = strtoull(value.c_str(), &end, 10);
+
+    if (value[0] < '0' || value[0] > '9' || *end != '\0' || errno == ERANGE ||
+        parsed_value > SIZE_MAX)
+    {
+      throw libfsw_exception(std::string(_("Invalid value of ")) + name + ": " + value);
+    }
+
+    if (parsed_value < min_value)
+    {
+      throw libfsw_exception(name + _(" must be at least ") +
+                             std::to_string(min_value) + ".");
+    }
+
+    return static_cast<size_t>(parsed_value);
+  }
+
   void monitor::set_filters(const std::vector<monitor_filter>& filters)
   {
     this->filters.clear();
 
     for (const monitor_filter& filter : filters)
     {
-      add_filter(filter);
+      this->filters.add(filter);
     }
+
+    this->filters.compile();
   }
 
   void monitor::set_prune_filters(const std::vector<monitor_filter>& filters)
@@ -186,8 +741,10 @@ namespace fsw
 
     for (const monitor_filter& filter : filters)
     {
-      add_prune_filter(filter);
+      prune_filters.add(filter);
     }
+
+    prune_filters.compile();
   }
 
   void monitor::set_filter_mode(fsw_filter_mode mode)
@@ -225,42 +782,16 @@ namespace fsw
 
   bool monitor::accept_path(const std::string& path) const
   {
-    if (filter_mode == fsw_filter_mode::filter_mode_conjunctive)
-    {
-      bool has_includes = false;
-      bool included = false;
-
-      for (const auto& filter : filters)
-      {
-        const bool matches = std::regex_search(path, filter.regex);
-
-        if (filter.type == fsw_filter_type::filter_include)
-        {
-          has_includes = true;
-          included = included || matches;
-        }
-        else if (matches)
-        {
-          return false;
-        }
-      }
-
-      return !has_includes || included;
-    }
-
-    bool is_excluded = false;
-
-    for (const auto& filter : filters)
-    {
-      if (std::regex_search(path, filter.regex))
-      {
-        if (filter.type == fsw_filter_type::filter_include) return true;
+    return filters.accept(path, filter_mode);
+  }
 
-        is_excluded = (filter.type == fsw_filter_type::filter_exclude);
-      }
-    }
+  bool monitor::accept_event_paths(const event& evt) const
+  {
+    // A rename reported as a single event is accepted if either of its paths
+    // is accepted.
+    if (accept_path(evt.get_path())) return true;
 
-    return !is_excluded;
+    return evt.has_secondary_path() && accept_path(evt.get_secondary_path());
   }
 
   bool monitor::should_prune_path(const std::string& path,
@@ -269,10 +800,15 @@ namespace fsw
   {
     if (!is_dir || is_root_path) return false;
 
-    return std::any_of(prune_filters.begin(),
-                       prune_filters.end(),
-                       [&path](const std::regex& filter)
-                       { return std::regex_search(path, filter); });
+    return prune_filters.matches_any(path);
+  }
+
+  bool monitor::is_subtree_excluded(const std::string& directory) const
+  {
+    if (filters.empty() || directory.empty()) return false;
+    if (directory.back() == '/') return filters.rejects_prefix(directory, filter_mode);
+
+    return filters.rejects_prefix(directory + "/", filter_mode);
   }
 
   void *monitor::get_context() const
@@ -290,6 +826,53 @@ namespace fsw
     this->bubble_events = bubble_events;
   }
 
+  void monitor::set_debounce(milliseconds window)
+  {
+    FSW_MONITOR_RUN_GUARD;
+
+    if (running)
+    {
+      throw libfsw_exception(_("The debounce window of a running monitor cannot be changed."),
+                             FSW_ERR_INVALID_MODE);
+    }
+
+    if (window < milliseconds(0))
+    {
+      throw libfsw_exception(_("The debounce window cannot be negative."),
+                             FSW_ERR_UNKNOWN_VALUE);
+    }
+
+    if (window == milliseconds(0)) debounce.reset();
+    else debounce = std::make_unique<debouncer>(window);
+  }
+
+  void monitor::set_async_delivery(size_t capacity, async_overflow_policy policy)
+  {
+    FSW_MONITOR_RUN_GUARD;
+
+    if (running)
+    {
+      throw libfsw_exception(_("The delivery mode of a running monitor cannot be changed."),
+                             FSW_ERR_INVALID_MODE);
+    }
+
+    if (capacity == 0) delivery.reset();
+    else delivery = std::make_unique<async_delivery>(capacity, policy);
+  }
+
+  async_delivery_counters monitor::get_async_delivery_counters() const
+  {
+    async_delivery_counters counters;
+    if (!delivery) return counters;
+
+    counters.delivered = delivery->delivered.load();
+    counters.blocked = delivery->blocked.load();
+    counters.dropped = delivery->dropped.load();
+    counters.coalesced = delivery->coalesced.load();
+
+    return counters;
+  }
+
 monitor::~monitor()
   {
     stop();
@@ -331,13 +914,18 @@ monitor::~monitor()
       std::vector<event> events;
       events.push_back({"", curr_time, {NoOp}});
 
-      mon->notify_events(events);
+      mon->notify_events(std::move(events));
     }
 
     FSW_ELOG(_("Inactivity notification thread: exiting\n"));
   }
 
   void monitor::start()
+  {
+    start(nullptr);
+  }
+
+  void monitor::start(const std::function<void()>& on_running)
   {
     FSW_MONITOR_RUN_GUARD;
     if (this->running) return;
@@ -345,6 +933,8 @@ monitor::~monitor()
     this->running = true;
     FSW_MONITOR_RUN_GUARD_UNLOCK;
 
+    if (on_running) on_running();
+
     // Fire the inactivity thread
     std::unique_ptr<std::thread> inactivity_thread;
 
@@ -352,17 +942,82 @@ monitor::~monitor()
       inactivity_thread.reset(
         new std::thread(monitor::inactivity_callback, this));
 
+    // Fire the delivery thread
+    std::unique_ptr<std::thread> delivery_thread;
+
+    if (delivery)
+    {
+      delivery->reset();
+      delivery_thread.reset(
+        new std::thread(&async_delivery::run, delivery.get(), this));
+    }
+
+    // Fire the debounce thread
+    std::unique_ptr<std::thread> debounce_thread;
+
+    if (debounce)
+    {
+      debounce->reset();
+      debounce_thread.reset(
+        new std::thread(&debouncer::run, debounce.get(), this));
+    }
+
+    // Join the threads feeding the callback, in pipeline order, once they
+    // have notified the pending events.
+    const auto join_pipeline = [&]()
+    {
+      if (debounce_thread)
+      {
+        FSW_ELOG(_("Debounce thread: joining\n"));
+        debounce->finish();
+        debounce_thread->join();
+      }
+
+      if (delivery_thread)
+      {
+        FSW_ELOG(_("Delivery thread: joining\n"));
+        delivery->finish();
+        delivery_thread->join();
+      }
+    };
+
     // Fire the monitor run loop.
-    this->run();
+    try
+    {
+      this->run();
+    }
+    catch (...)
+    {
+      // Mark the monitor as stopped, so that it can be started again or
+      // destroyed once the error has been handled.
+      FSW_MONITOR_RUN_GUARD_LOCK;
+      this->should_stop = true;
+      FSW_MONITOR_RUN_GUARD_UNLOCK;
+
+      if (inactivity_thread) inactivity_thread->join();
+      join_pipeline();
+
+      FSW_MONITOR_RUN_GUARD_LOCK;
+      this->running = false;
+      this->should_stop = false;
+      FSW_MONITOR_RUN_GUARD_UNLOCK;
+
+      throw;
+    }
 
     // Join the inactivity thread and wait until it stops.
     FSW_ELOG(_("Inactivity notification thread: joining\n"));
     if (inactivity_thread) inactivity_thread->join();
 
+    join_pipeline();
+
     FSW_MONITOR_RUN_GUARD_LOCK;
     this->running = false;
     this->should_stop = false;
     FSW_MONITOR_RUN_GUARD_UNLOCK;
+
+    if (debounce && debounce->error) std::rethrow_exception(debounce->error);
+    if (delivery && delivery->error) std::rethrow_exception(delivery->error);
   }
 
   void monitor::stop()
@@ -384,16 +1039,16 @@ monitor::~monitor()
     return this->running;
   }
 
-  std::vector<fsw_event_flag> monitor::filter_flags(const event& evt) const
+  event_flag_set monitor::filter_flags(const event& evt) const
   {
-    // If there is nothing to filter, just return the original vector.
-    if (event_type_filters.empty()) return evt.get_flags();
+    // If there is nothing to filter, just return the original set.
+    if (event_type_filters.empty()) return evt.get_flag_set();
 
-    std::vector<fsw_event_flag> filtered_flags;
+    event_flag_set filtered_flags;
 
-    for (auto const& flag : evt.get_flags())
+    for (auto const& flag : evt.get_flag_set())
     {
-      if (accept_event_type(flag)) filtered_flags.push_back(flag);
+      if (accept_event_type(flag)) filtered_flags.insert(flag);
     }
 
     return filtered_flags;
@@ -413,79 +1068,116 @@ monitor::~monitor()
   {
     FSW_MONITOR_NOTIFY_GUARD;
 
-    // Update the last notification timestamp
-    milliseconds now =
-      duration_cast<milliseconds>(
-        system_clock::now().time_since_epoch());
-    last_notification.store(now);
+    update_last_notification();
 
     std::vector<event> filtered_events;
 
     for (auto const& event : events)
     {
       // Filter flags
-      std::vector<fsw_event_flag> filtered_flags = filter_flags(event);
+      const event_flag_set filtered_flags = filter_flags(event);
 
       if (filtered_flags.empty()) continue;
-      if (!accept_path(event.get_path())) continue;
+      if (!accept_event_paths(event)) continue;
 
-      filtered_events.emplace_back(event.get_path(),
-                                   event.get_time(),
-                                   filtered_flags,
-                                   event.get_correlation_id(),
-                                   process_metadata{event.get_process_id_kind(),
-                                                    event.get_process_id(),
-                                                    event.get_process_pidfd(),
-                                                    event.has_process_pidfd()});
+      filtered_events.push_back(event);
+      filtered_events.back().set_flag_set(filtered_flags);
     }
 
-    if (bubble_events)
+    deliver_events(filtered_events);
+  }
+
+  void monitor::notify_events(std::vector<event>&& events) const
+  {
+    FSW_MONITOR_NOTIFY_GUARD;
+
+    update_last_notification();
+
+    // Filter the events in place, moving the accepted ones to the front.
+    auto accepted = events.begin();
+
+    for (auto it = events.begin(); it != events.end(); ++it)
     {
-      // Bubble events by stable event identity.
-      using bubble_key =
-        std::tuple<time_t, std::string, unsigned long, process_id_kind, long long, int, bool>;
+      const event_flag_set filtered_flags = filter_flags(*it);
 
-      std::map<bubble_key, std::set<fsw_event_flag>> bubbled_events;
+      if (filtered_flags.empty()) continue;
+      if (!accept_event_paths(*it)) continue;
+
+      it->set_flag_set(filtered_flags);
+      if (accepted != it) *accepted = std::move(*it);
+      ++accepted;
+    }
 
-      for (auto const& event : filtered_events)
+    events.erase(accepted, events.end());
+
+    deliver_events(events);
+  }
+
+  void monitor::update_last_notification() const
+  {
+    milliseconds now =
+      duration_cast<milliseconds>(
+        system_clock::now().time_since_epoch());
+    last_notification.store(now);
+  }
+
+  void monitor::deliver_events(std::vector<event>& events) const
+  {
+    if (bubble_events && events.size() > 1)
+    {
+      // Bubble events by stable event identity in a single pass: the flags
+      // of each group are merged into its first event, and the flags of the
+      // other events of the group are cleared.  Since accepted events always
+      // have flags, events without flags are then removed, preserving the
+      // order in which the groups were first seen.
+      std::unordered_set<event *, bubble_key_hash, bubble_key_equal> bubbled_events;
+      bubbled_events.reserve(events.size());
+
+      for (event& evt : events)
       {
-        const auto& flags = event.get_flags();
-        bubbled_events[{event.get_time(),
-                        event.get_path(),
-                        event.get_correlation_id(),
-                        event.get_process_id_kind(),
-                        event.get_process_id(),
-                        event.get_process_pidfd(),
-                        event.has_process_pidfd()}].insert(flags.begin(), flags.end());
+        const auto [it, inserted] = bubbled_events.insert(&evt);
+        if (inserted) continue;
+
+        event_flag_set flags = (*it)->get_flag_set();
+        flags |= evt.get_flag_set();
+        (*it)->set_flag_set(flags);
+        evt.set_flag_set({});
       }
 
-      filtered_events.clear();
-      for (const auto& [bubble_key, flags] : bubbled_events)
+      if (bubbled_events.size() != events.size())
       {
-        std::vector<fsw_event_flag> bubbled_flags(flags.size());
-        std::move(flags.begin(), flags.end(), bubbled_flags.begin());
-
-        process_metadata process;
-        process.kind = std::get<3>(bubble_key);
-        process.id = std::get<4>(bubble_key);
-        process.pidfd = std::get<5>(bubble_key);
-        process.has_pidfd = std::get<6>(bubble_key);
-
-        filtered_events.emplace_back(std::get<1>(bubble_key),
-                                     std::get<0>(bubble_key),
-                                     bubbled_flags,
-                                     std::get<2>(bubble_key),
-                                     process);
+        events.erase(std::remove_if(events.begin(),
+                                    events.end(),
+                                    [](const event& evt)
+                                    {
+                                      return evt.get_flag_set().empty();
+                                    }),
+                     events.end());
       }
     }
 
-    if (!filtered_events.empty())
+    if (events.empty()) return;
+
+    if (debounce)
     {
-      FSW_ELOG(string_utils::string_from_format(_("Notifying events #: %d.\n"),
-                                                filtered_events.size()).c_str());
+      debounce->add(events);
+      return;
+    }
+
+    dispatch_events(events);
+  }
 
-      callback(filtered_events, context);
+  void monitor::dispatch_events(std::vector<event>& events) const
+  {
+    if (delivery)
+    {
+      delivery->push(events);
+      return;
     }
+
+    FSW_ELOGF(_("Notifying events #: %zu.\n"), events.size());
+
+    callback(events, context);
   }
 
   void monitor::on_stop()
@@ -30,12 +30,16 @@
 #  define FSW__MONITOR_H
 
 #  include "filter.hpp"
+#  include "path_filter_set.hpp"
 #  include <vector>
 #  include <string>
 #  include <mutex>
 #  include <atomic>
 #  include <chrono>
+#  include <cstddef>
+#  include <functional>
 #  include <map>
+#  include <memory>
 #  include <regex>
 #  include "event.hpp"
 #  include "libfswatch/c/cmonitor.h"
@@ -57,7 +61,56 @@ namespace fsw
    */
   typedef void FSW_EVENT_CALLBACK(const std::vector<event>&, void *);
 
-  struct compiled_monitor_filter;
+  /**
+   * @brief Policy applied by the asynchronous delivery when its queue is full.
+   *
+   * @see monitor::set_async_delivery()
+   */
+  enum class async_overflow_policy
+  {
+    /**
+     * @brief The monitor thread waits until the delivery thread makes room.
+     */
+    block,
+    /**
+     * @brief The oldest queued event is discarded to make room.
+     */
+    drop_oldest,
+    /**
+     * @brief Events are held aside until the queue is drained, and the flags
+     * of events with the same path are merged.  At most as many paths as the
+     * capacity of the queue are held aside: the events of further paths are
+     * discarded, and an event with the Overflow flag is delivered if the
+     * monitor allows overflows.
+     */
+    coalesce
+  };
+
+  /**
+   * @brief Counters of the asynchronous delivery.
+   *
+   * @see monitor::get_async_delivery_counters()
+   */
+  struct async_delivery_counters
+  {
+    /**
+     * @brief Number of events passed to the callback.
+     */
+    unsigned long long delivered = 0;
+    /**
+     * @brief Number of times the monitor thread waited for a full queue.
+     */
+    unsigned long long blocked = 0;
+    /**
+     * @brief Number of events discarded from a full queue or from a full
+     * coalescing backlog.
+     */
+    unsigned long long dropped = 0;
+    /**
+     * @brief Number of events merged into an event with the same path.
+     */
+    unsigned long long coalesced = 0;
+  };
 
   /**
    * @brief Base class of all monitors.
@@ -390,12 +443,66 @@ namespace fsw
      *
      * This function sets the bubble events flags, instructing the monitor to
      * consolidate the event flags for all events with the same time and path
-     * received in the same batch.
+     * received in the same batch.  Bubbled events are notified in the order
+     * in which they were first received.
      *
      * @param bubble_events The bubble events flag.
      */
     void set_bubble_events(bool bubble_events);
 
+    /**
+     * @brief Set the debounce window.
+     *
+     * When a debounce window is set, events are not notified as soon as they
+     * are received.  The events of each path are instead merged, across
+     * batches, into a single event whose flags are the union of the flags of
+     * the merged events, and the event is notified once no events have been
+     * received for its path for the duration of the window.  The merged event
+     * keeps the time and the metadata of the first event received for the
+     * path.  Pending events are notified when the monitor stops.
+     *
+     * Debounced events are notified by a separate thread, started and joined
+     * by start().
+     *
+     * This function must be called before the monitor is started.
+     *
+     * @param window The debounce window.  A value of @c 0 disables debouncing.
+     * @throws libfsw_exception if the monitor is running or if @p window is
+     * negative.
+     */
+    void set_debounce(std::chrono::milliseconds window);
+
+    /**
+     * @brief Set the asynchronous delivery mode.
+     *
+     * By default, the callback is invoked by the thread that detects the
+     * events, which can be stalled by a slow callback.  When the asynchronous
+     * delivery is enabled, detected events are pushed into a bounded
+     * lock-free queue and the callback is invoked by a separate delivery
+     * thread, started and joined by start().  @p policy determines what
+     * happens when the queue is full.  The number of times each policy is
+     * applied can be retrieved with get_async_delivery_counters().
+     *
+     * This function must be called before the monitor is started.
+     *
+     * @param capacity The capacity of the queue, in events.  A value of @c 0
+     * disables the asynchronous delivery.
+     * @param policy The policy applied when the queue is full.
+     * @throws libfsw_exception if the monitor is running.
+     */
+    void set_async_delivery(size_t capacity,
+                            async_overflow_policy policy = async_overflow_policy::block);
+
+    /**
+     * @brief Get the counters of the asynchronous delivery.
+     *
+     * The counters are reset when the asynchronous delivery is set and are
+     * all @c 0 if it is disabled.
+     *
+     * @return The counters of the asynchronous delivery.
+     */
+    async_delivery_counters get_async_delivery_counters() const;
+
     /**
      * @brief Start the monitor.
      *
@@ -419,6 +526,18 @@ namespace fsw
      */
     void start();
 
+    /**
+     * @brief Start the monitor and notify when it is running.
+     *
+     * Behaves like start(), and invokes @p on_running once the monitor is
+     * marked as _running_, before run() is called.  From that moment on, the
+     * monitor can be stopped with stop().
+     *
+     * @param on_running The function to invoke once the monitor is running.
+     * @see start()
+     */
+    void start(const std::function<void()>& on_running);
+
     /**
      * @brief Stop the monitor.
      *
@@ -512,15 +631,47 @@ namespace fsw
                            bool is_dir,
                            bool is_root_path) const;
 
+    /**
+     * @brief Check whether all the descendants of a directory are rejected.
+     *
+     * This function checks whether the path filters of the monitor reject
+     * every path below @p directory, regardless of the rest of the path.
+     * Backends can use it to discard the events of the children of a watched
+     * directory before building their path and the corresponding fsw::event
+     * object.  Since its cost is comparable to that of accept_path(), its
+     * result should be cached per watched directory.
+     *
+     * The check is conservative: @c false may be returned even if every
+     * descendant of @p directory is rejected.
+     *
+     * @param directory The directory to check.
+     * @return @c true if every descendant of @p directory is rejected, @c false
+     * otherwise.
+     */
+    bool is_subtree_excluded(const std::string& directory) const;
+
     /**
      * @brief Notify change events.
      *
      * This function notifies change events using the provided callback.
+     * The accepted events are copied: monitors owning their event batch
+     * should use the rvalue overload instead.
      *
      * @see monitor()
      */
     void notify_events(const std::vector<event>& events) const;
 
+    /**
+     * @brief Notify change events.
+     *
+     * This function notifies change events using the provided callback.
+     * Events are filtered in place and passed to the callback without being
+     * copied.  The content of @p events is unspecified after the call.
+     *
+     * @see monitor()
+     */
+    void notify_events(std::vector<event>&& events) const;
+
     /**
      * @brief Notify an overflow event.
      *
@@ -540,9 +691,26 @@ namespace fsw
      * allowed by the configured filters.
      *
      * @param evt The event whose types must be filtered.
-     * @return A vector containing the acceptable events.
+     * @return A set containing the acceptable event types.
      */
-    std::vector<fsw_event_flag> filter_flags(const event& evt) const;
+    event_flag_set filter_flags(const event& evt) const;
+
+    /**
+     * @brief Gets the value of a property as an unsigned number.
+     *
+     * The value is parsed as a decimal number: a leading `0` does not make it
+     * octal.
+     *
+     * @param name The name of the property.
+     * @param default_value The value returned if the property is not set.
+     * @param min_value The minimum value of the property.
+     * @return The value of the property.
+     * @throw libfsw_exception if the value is not an unsigned number or is
+     * less than @p min_value.
+     */
+    size_t get_unsigned_property(const std::string& name,
+                                 size_t default_value,
+                                 size_t min_value = 0);
 
     /**
      * @brief Execute monitor loop.
@@ -666,13 +834,22 @@ namespace fsw
     mutable std::mutex notify_mutex;
 
   private:
+    struct async_delivery;
+    struct debouncer;
+
     std::chrono::milliseconds get_latency_ms() const;
-    std::vector<compiled_monitor_filter> filters;
-    std::vector<std::regex> prune_filters;
+    path_filter_set filters;
+    path_filter_set prune_filters;
     std::vector<fsw_event_type_filter> event_type_filters;
     fsw_filter_mode filter_mode = fsw_filter_mode::filter_mode_legacy;
 
     static void inactivity_callback(monitor *mon);
+    void update_last_notification() const;
+    bool accept_event_paths(const event& evt) const;
+    void deliver_events(std::vector<event>& events) const;
+    void dispatch_events(std::vector<event>& events) const;
+    std::unique_ptr<async_delivery> delivery;
+    std::unique_ptr<debouncer> debounce;
     mutable std::atomic<std::chrono::milliseconds> last_notification;
   };
 }
@@ -0,0 +1,808 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libfswatch/gettext_defs.h"
+#include "path_filter_set.hpp"
+#include "libfswatch_exception.hpp"
+#include "string/string_utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace fsw
+{
+  namespace
+  {
+    unsigned char fold(unsigned char c)
+    {
+      return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+    }
+
+    bool is_ascii_alnum(char c)
+    {
+      return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    /*
+     * Returns the index following the bracket expression starting at i, or
+     * std::string::npos if the expression is not terminated.
+     */
+    size_t skip_bracket_expression(const std::string& text, size_t i)
+    {
+      const size_t n = text.size();
+      size_t j = i + 1;
+
+      if (j < n && text[j] == '^') ++j;
+      if (j < n && text[j] == ']') ++j;
+
+      while (j < n)
+      {
+        if (text[j] == '[' && j + 1 < n &&
+            (text[j + 1] == ':' || text[j + 1] == '.' || text[j + 1] == '='))
+        {
+          const size_t close = text.find(std::string{text[j + 1], ']'}, j + 2);
+          if (close == std::string::npos) return std::string::npos;
+
+          j = close + 2;
+          continue;
+        }
+
+        if (text[j] == ']') return j + 1;
+        ++j;
+      }
+
+      return std::string::npos;
+    }
+
+    /*
+     * Returns the index following the group whose content starts at i, or
+     * std::string::npos if the group is not terminated.
+     */
+    size_t skip_group(const std::string& text, size_t i, bool extended)
+    {
+      const size_t n = text.size();
+      unsigned int depth = 1;
+
+      while (i < n)
+      {
+        const char c = text[i];
+
+        if (c == '[')
+        {
+          i = skip_bracket_expression(text, i);
+          if (i == std::string::npos) return i;
+          continue;
+        }
+
+        if (c == '\\')
+        {
+          if (i + 1 >= n) return std::string::npos;
+
+          if (!extended && text[i + 1] == '(') ++depth;
+          if (!extended && text[i + 1] == ')' && --depth == 0) return i + 2;
+
+          i += 2;
+          continue;
+        }
+
+        if (extended && c == '(') ++depth;
+        if (extended && c == ')' && --depth == 0) return i + 1;
+
+        ++i;
+      }
+
+      return std::string::npos;
+    }
+
+    /*
+     * Extracts the longest string that any match of the regular expression
+     * must contain.  The analysis is conservative: every construct that is
+     * not known to match a fixed character terminates the current literal
+     * run, and quantifiers remove the character they apply to.  The returned
+     * literal is case folded, and an empty string is returned when no
+     * literal could be determined.
+     */
+    std::string extract_required_literal(const std::string& text,
+                                         bool extended,
+                                         bool case_sensitive)
+    {
+      const size_t n = text.size();
+      std::string best;
+      std::string run;
+
+      auto close_run = [&best, &run]()
+      {
+        if (run.size() > best.size()) best = run;
+        run.clear();
+      };
+
+      auto drop_last = [&run, &close_run]()
+      {
+        if (!run.empty()) run.pop_back();
+        close_run();
+      };
+
+      auto append = [&run, &close_run, case_sensitive](char c)
+      {
+        // Case folding of non-ASCII characters depends on the locale.
+        if (!case_sensitive && static_cast<unsigned char>(c) >= 0x80)
+        {
+          close_run();
+          return;
+        }
+
+        run.push_back(static_cast<char>(fold(static_cast<unsigned char>(c))));
+      };
+
+      size_t i = (n > 0 && text[0] == '^') ? 1 : 0;
+
+      while (i < n)
+      {
+        const char c = text[i];
+
+        switch (c)
+        {
+        case '\\':
+        {
+          if (i + 1 >= n) return "";
+
+          const char d = text[i + 1];
+
+          if (d == '|') return "";
+
+          if (!extended && d == '(')
+          {
+            close_run();
+            i = skip_group(text, i + 2, false);
+            if (i == std::string::npos) return "";
+            continue;
+          }
+
+          if (!extended && d == '{')
+          {
+            drop_last();
+            const size_t close = text.find("\\}", i + 2);
+            if (close == std::string::npos) return "";
+            i = close + 2;
+            continue;
+          }
+
+          if (!extended && (d == '+' || d == '?')) drop_last();
+          else if (!extended && (d == ')' || d == '}')) close_run();
+          else if (is_ascii_alnum(d)) close_run();
+          else append(d);
+
+          i += 2;
+          continue;
+        }
+
+        case '[':
+          close_run();
+          i = skip_bracket_expression(text, i);
+          if (i == std::string::npos) return "";
+          continue;
+
+        case '(':
+          close_run();
+
+          if (!extended)
+          {
+            ++i;
+            continue;
+          }
+
+          i = skip_group(text, i + 1, true);
+          if (i == std::string::npos) return "";
+          continue;
+
+        case '{':
+          drop_last();
+
+          if (!extended)
+          {
+            ++i;
+            continue;
+          }
+
+          i = text.find('}', i);
+          if (i == std::string::npos) return "";
+          ++i;
+          continue;
+
+        case '+':
+          // One or more repetitions: the character is required.
+          if (extended) close_run();
+          else drop_last();
+          break;
+
+        case '*':
+        case '?':
+          drop_last();
+          break;
+
+        case '|':
+          return "";
+
+        case '.':
+        case '^':
+        case '$':
+        case ')':
+        case '}':
+          close_run();
+          break;
+
+        default:
+          append(c);
+          break;
+        }
+
+        ++i;
+      }
+
+      close_run();
+
+      return best;
+    }
+
+    std::string fold(const std::string& text)
+    {
+      std::string folded(text);
+
+      for (char& c : folded)
+        c = static_cast<char>(fold(static_cast<unsigned char>(c)));
+
+      return folded;
+    }
+
+    bool is_ascii(const std::string& text)
+    {
+      return std::none_of(text.begin(),
+                          text.end(),
+                          [](char c)
+                          { return static_cast<unsigned char>(c) >= 0x80; });
+    }
+
+    bool is_escaped(const std::string& text, size_t i)
+    {
+      unsigned int backslashes = 0;
+
+      while (i > 0 && text[--i] == '\\') ++backslashes;
+
+      return (backslashes % 2) != 0;
+    }
+
+    struct literal_pattern
+    {
+      std::string text;
+      bool anchored_start = false;
+      bool anchored_end = false;
+    };
+
+    /*
+     * Checks whether a regular expression matches a literal string only,
+     * optionally anchored to the start or to the end of the path.  Leading
+     * and trailing `.*` are ignored.  Escape sequences are only accepted if
+     * std::regex accepts them, so that expressions it would reject, such as
+     * `\]` or an extended `\}`, still get compiled and reported.
+     */
+    bool parse_literal_regex(const std::string& text,
+                             bool extended,
+                             literal_pattern& literal)
+    {
+      size_t begin = 0;
+      size_t end = text.size();
+
+      if (text.compare(0, 1, "^") == 0)
+      {
+        literal.anchored_start = true;
+        begin = 1;
+      }
+
+      if (text.compare(begin, 2, ".*") == 0)
+      {
+        literal.anchored_start = false;
+        begin += 2;
+      }
+
+      if (end > begin && text[end - 1] == '$' && !is_escaped(text, end - 1))
+      {
+        literal.anchored_end = true;
+        --end;
+      }
+
+      if (end >= begin + 2 && text.compare(end - 2, 2, ".*") == 0 &&
+          !is_escaped(text, end - 2))
+      {
+        literal.anchored_end = false;
+        end -= 2;
+      }
+
+      for (size_t i = begin; i < end; ++i)
+      {
+        char c = text[i];
+
+        if (c == '\\')
+        {
+          if (++i >= end) return false;
+
+          c = text[i];
+          const bool special =
+            (c != '\0') &&
+            (std::strchr(".[*^$\\", c) != nullptr ||
+             (extended && std::strchr("+?{()|", c) != nullptr));
+
+          if (!special) return false;
+
+          literal.text.push_back(c);
+          continue;
+        }
+
+        if (std::strchr(".[*^$+?{}()|", c) != nullptr || c == '\0') return false;
+
+        literal.text.push_back(c);
+      }
+
+      return !literal.text.empty();
+    }
+
+    /*
+     * Checks whether a glob pattern matches a literal string only, that is
+     * whether its only wildcards are leading or trailing `*`.
+     */
+    bool parse_literal_glob(const std::string& text, literal_pattern& literal)
+    {
+      size_t begin = 0;
+      size_t end = text.size();
+
+      while (begin < end && text[begin] == '*') ++begin;
+      while (end > begin && text[end - 1] == '*' && !is_escaped(text, end - 1)) --end;
+
+      literal.anchored_start = (begin == 0);
+      literal.anchored_end = (end == text.size());
+
+      for (size_t i = begin; i < end; ++i)
+      {
+        const char c = text[i];
+
+        if (c == '\\')
+        {
+          if (++i >= end) return false;
+
+          literal.text.push_back(text[i]);
+          continue;
+        }
+
+        if (c == '*' || c == '?' || c == '[') return false;
+
+        literal.text.push_back(c);
+      }
+
+      return !literal.text.empty();
+    }
+
+    /*
+     * Outside of a bracket expression `]` and `}` are ordinary characters,
+     * and std::regex rejects them when escaped.
+     */
+    void append_escaped(std::string& regex, char c)
+    {
+      if (c != '\0' && std::strchr(".[{()*+?^$|\\", c) != nullptr) regex.push_back('\\');
+
+      regex.push_back(c);
+    }
+
+    /*
+     * Translates a glob pattern into an equivalent extended regular
+     * expression matching the whole path.
+     */
+    std::string glob_to_regex(const std::string& text)
+    {
+      std::string regex = "^";
+
+      for (size_t i = 0; i < text.size(); ++i)
+      {
+        const char c = text[i];
+
+        switch (c)
+        {
+        case '*':
+          regex += ".*";
+          break;
+
+        case '?':
+          regex += '.';
+          break;
+
+        case '[':
+        {
+          std::string bracket = text.substr(i);
+          if (bracket.size() > 1 && bracket[1] == '!') bracket[1] = '^';
+
+          const size_t length = skip_bracket_expression(bracket, 0);
+
+          if (length == std::string::npos)
+          {
+            append_escaped(regex, c);
+            break;
+          }
+
+          regex.append(bracket, 0, length);
+          i += length - 1;
+          break;
+        }
+
+        case '\\':
+          if (i + 1 < text.size()) ++i;
+          append_escaped(regex, text[i]);
+          break;
+
+        default:
+          append_escaped(regex, c);
+          break;
+        }
+      }
+
+      regex += '$';
+
+      return regex;
+    }
+
+    bool equals_at(const std::string& path,
+                   size_t offset,
+                   const std::string& pattern,
+                   bool case_sensitive)
+    {
+      if (case_sensitive) return path.compare(offset, pattern.size(), pattern) == 0;
+
+      for (size_t i = 0; i < pattern.size(); ++i)
+      {
+        if (fold(static_cast<unsigned char>(path[offset + i])) !=
+            static_cast<unsigned char>(pattern[i]))
+          return false;
+      }
+
+      return true;
+    }
+
+    bool contains(const std::string& path,
+                  const std::string& pattern,
+                  bool case_sensitive)
+    {
+      if (case_sensitive) return path.find(pattern) != std::string::npos;
+
+      // pattern is case folded: look for both cases of its first character.
+      const auto lower = static_cast<unsigned char>(pattern[0]);
+      const auto upper = (lower >= 'a' && lower <= 'z') ? lower - ('a' - 'A') : lower;
+
+      for (size_t i = 0; i + pattern.size() <= path.size(); ++i)
+      {
+        const auto c = static_cast<unsigned char>(path[i]);
+
+        if (c != lower && c != upper) continue;
+        if (equals_at(path, i, pattern, false)) return true;
+      }
+
+      return false;
+    }
+  }
+
+  void path_filter_set::add(const monitor_filter& filter)
+  {
+    compiled_filter compiled{};
+    compiled.type = filter.type;
+    compiled.case_sensitive = filter.case_sensitive;
+
+    literal_pattern literal;
+    bool is_literal = filter.glob
+                      ? parse_literal_glob(filter.text, literal)
+                      : parse_literal_regex(filter.text, filter.extended, literal);
+
+    // Case folding of non-ASCII characters depends on the locale.
+    if (!filter.case_sensitive && !is_ascii(literal.text)) is_literal = false;
+
+    if (is_literal)
+    {
+      if (literal.anchored_start && literal.anchored_end) compiled.kind = match_kind::exact;
+      else if (literal.anchored_start) compiled.kind = match_kind::prefix;
+      else if (literal.anchored_end) compiled.kind = match_kind::suffix;
+      else compiled.kind = match_kind::substring;
+
+      compiled.pattern = filter.case_sensitive ? literal.text : fold(literal.text);
+      compiled.literal = fold(literal.text);
+      compiled.end_anchored = literal.anchored_end;
+    }
+    else
+    {
+      const bool extended = filter.glob || filter.extended;
+      const std::string expression = filter.glob ? glob_to_regex(filter.text) : filter.text;
+
+      std::regex::flag_type regex_flags = std::regex::basic;
+
+      if (extended) regex_flags = std::regex::extended;
+      if (!filter.case_sensitive) regex_flags |= std::regex::icase;
+
+      try
+      {
+        compiled.regex = std::regex(expression, regex_flags);
+      }
+      catch (const std::regex_error& error)
+      {
+        throw libfsw_exception(
+          string_utils::string_from_format(
+            _("An error occurred during the compilation of %s"),
+            filter.text.c_str()),
+          FSW_ERR_INVALID_REGEX);
+      }
+
+      compiled.literal = extract_required_literal(expression,
+                                                  extended,
+                                                  filter.case_sensitive);
+      compiled.end_anchored = (expression.find('$') != std::string::npos);
+    }
+
+    filters.push_back(std::move(compiled));
+
+    if (filter.type == fsw_filter_type::filter_include) ++include_count;
+  }
+
+  void path_filter_set::clear()
+  {
+    filters.clear();
+    states.clear();
+    root_transitions.clear();
+    keyword_filters.clear();
+    unfiltered.clear();
+    compiled_count = 0;
+    include_count = 0;
+  }
+
+  bool path_filter_set::empty() const
+  {
+    return filters.empty();
+  }
+
+  void path_filter_set::compile()
+  {
+    states.assign(1, automaton_state{});
+    root_transitions.assign(256, 0);
+    keyword_filters.clear();
+    unfiltered.clear();
+
+    // Build the trie of the required literals.
+    std::unordered_map<std::string, uint32_t> keyword_ids;
+
+    for (uint32_t i = 0; i < filters.size(); ++i)
+    {
+      const std::string& literal = filters[i].literal;
+
+      if (literal.empty())
+      {
+        unfiltered.push_back(i);
+        continue;
+      }
+
+      auto keyword = keyword_ids.find(literal);
+      if (keyword != keyword_ids.end())
+      {
+        keyword_filters[keyword->second].push_back(i);
+        continue;
+      }
+
+      uint32_t state = 0;
+
+      for (const char ch : literal)
+      {
+        const auto c = static_cast<unsigned char>(ch);
+        auto& transitions = states[state].transitions;
+        auto transition = std::find_if(transitions.begin(),
+                                       transitions.end(),
+                                       [c](const std::pair<unsigned char, uint32_t>& t)
+                                       { return t.first == c; });
+
+        if (transition != transitions.end())
+        {
+          state = transition->second;
+          continue;
+        }
+
+        const auto next = static_cast<uint32_t>(states.size());
+        transitions.emplace_back(c, next);
+        states.emplace_back();
+        state = next;
+      }
+
+      states[state].keyword = static_cast<int32_t>(keyword_filters.size());
+      keyword_ids.emplace(literal, static_cast<uint32_t>(keyword_filters.size()));
+      keyword_filters.push_back({i});
+    }
+
+    // Compute failure and output links breadth first.
+    std::vector<uint32_t> queue;
+    queue.reserve(states.size());
+
+    for (const auto& [c, next] : states[0].transitions)
+    {
+      root_transitions[c] = next;
+      queue.push_back(next);
+    }
+
+    for (size_t head = 0; head < queue.size(); ++head)
+    {
+      const uint32_t state = queue[head];
+
+      for (const auto& [c, next] : states[state].transitions)
+      {
+        const uint32_t failure = next_state(states[state].failure, c);
+
+        states[next].failure = failure;
+        states[next].output = (states[failure].keyword >= 0) ? failure : states[failure].output;
+        queue.push_back(next);
+      }
+    }
+
+    compiled_count = filters.size();
+  }
+
+  uint32_t path_filter_set::next_state(uint32_t state, unsigned char c) const
+  {
+    while (state != 0)
+    {
+      for (const auto& [symbol, next] : states[state].transitions)
+      {
+        if (symbol == c) return next;
+      }
+
+      state = states[state].failure;
+    }
+
+    return root_transitions[c];
+  }
+
+  void path_filter_set::collect_candidates(const std::string& path,
+                                           std::vector<uint32_t>& candidates) const
+  {
+    if (states.size() > 1)
+    {
+      uint32_t state = 0;
+
+      for (const char ch : path)
+      {
+        state = next_state(state, fold(static_cast<unsigned char>(ch)));
+
+        uint32_t match = (states[state].keyword >= 0) ? state : states[state].output;
+
+        while (match != 0)
+        {
+          const auto& ids = keyword_filters[states[match].keyword];
+          candidates.insert(candidates.end(), ids.begin(), ids.end());
+          match = states[match].output;
+        }
+      }
+    }
+
+    candidates.insert(candidates.end(), unfiltered.begin(), unfiltered.end());
+
+    for (size_t i = compiled_count; i < filters.size(); ++i)
+      candidates.push_back(static_cast<uint32_t>(i));
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                     candidates.end());
+  }
+
+  bool path_filter_set::matches(uint32_t index, const std::string& path) const
+  {
+    const compiled_filter& filter = filters[index];
+    const std::string& pattern = filter.pattern;
+
+    if (filter.kind == match_kind::regex) return std::regex_search(path, filter.regex);
+    if (pattern.size() > path.size()) return false;
+
+    switch (filter.kind)
+    {
+    case match_kind::substring:
+      return contains(path, pattern, filter.case_sensitive);
+    case match_kind::prefix:
+      return equals_at(path, 0, pattern, filter.case_sensitive);
+    case match_kind::suffix:
+      return equals_at(path, path.size() - pattern.size(), pattern, filter.case_sensitive);
+    case match_kind::exact:
+      return pattern.size() == path.size() &&
+             equals_at(path, 0, pattern, filter.case_sensitive);
+    default:
+      return false;
+    }
+  }
+
+  bool path_filter_set::accept(const std::string& path,
+                               fsw_filter_mode mode) const
+  {
+    if (filters.empty()) return true;
+
+    thread_local std::vector<uint32_t> candidates;
+    candidates.clear();
+    collect_candidates(path, candidates);
+
+    if (mode == fsw_filter_mode::filter_mode_conjunctive)
+    {
+      for (const uint32_t i : candidates)
+      {
+        if (filters[i].type == fsw_filter_type::filter_exclude && matches(i, path))
+          return false;
+      }
+
+      if (include_count == 0) return true;
+
+      return std::any_of(candidates.begin(),
+                         candidates.end(),
+                         [this, &path](uint32_t i)
+                         {
+                           return filters[i].type == fsw_filter_type::filter_include &&
+                                  matches(i, path);
+                         });
+    }
+
+    // Legacy mode: an inclusion filter overrides any exclusion filter.
+    for (const uint32_t i : candidates)
+    {
+      if (filters[i].type == fsw_filter_type::filter_include && matches(i, path))
+        return true;
+    }
+
+    return std::none_of(candidates.begin(),
+                        candidates.end(),
+                        [this, &path](uint32_t i)
+                        {
+                          return filters[i].type == fsw_filter_type::filter_exclude &&
+                                 matches(i, path);
+                        });
+  }
+
+  bool path_filter_set::matches_any(const std::string& path) const
+  {
+    if (filters.empty()) return false;
+
+    thread_local std::vector<uint32_t> candidates;
+    candidates.clear();
+    collect_candidates(path, candidates);
+
+    return std::any_of(candidates.begin(),
+                       candidates.end(),
+                       [this, &path](uint32_t i)
+                       { return matches(i, path); });
+  }
+
+  bool path_filter_set::rejects_prefix(const std::string& prefix,
+                                       fsw_filter_mode mode) const
+  {
+    if (mode == fsw_filter_mode::filter_mode_legacy && include_count > 0)
+      return false;
+
+    thread_local std::vector<uint32_t> candidates;
+    candidates.clear();
+    collect_candidates(prefix, candidates);
+
+    // A match not anchored to the end of the prefix is preserved by any
+    // suffix appended to it.
+    return std::any_of(candidates.begin(),
+                       candidates.end(),
+                       [this, &prefix](uint32_t i)
+                       {
+                         return filters[i].type == fsw_filter_type::filter_exclude &&
+                                !filters[i].end_anchored &&
+                                matches(i, prefix);
+                       });
+  }
+}
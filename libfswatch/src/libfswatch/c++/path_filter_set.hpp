@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file
+ * @brief Header of the fsw::path_filter_set class.
+ *
+ * This header file defines the fsw::path_filter_set class, the compiled form
+ * of a list of path filters used by fsw::monitor.
+ *
+ * @copyright Copyright (c) 2026 Enrico M. Crisostomo
+ * @license GNU General Public License v. 3.0
+ * @author Enrico M. Crisostomo
+ * @version 1.22.0
+ */
+#ifndef FSW_PATH_FILTER_SET_H
+#  define FSW_PATH_FILTER_SET_H
+
+#  include "filter.hpp"
+#  include <cstdint>
+#  include <regex>
+#  include <string>
+#  include <vector>
+
+namespace fsw
+{
+  /**
+   * @brief Compiled set of path filters.
+   *
+   * Evaluating a list of path filters one by one costs a `std::regex_search()`
+   * call per filter and per path.  This class compiles the whole list instead:
+   *
+   *   - Each regular expression is analysed to extract a _required literal_,
+   *     that is a string every match of the expression must contain.
+   *
+   *   - All the required literals are compiled into a single Aho-Corasick
+   *     automaton, so that a single scan of a path yields the set of filters
+   *     that can possibly match it.
+   *
+   *   - Only these candidates, and the filters whose required literal could
+   *     not be determined, are evaluated with `std::regex_search()`.
+   *
+   * The cost of evaluating a path is thus proportional to its length and to
+   * the number of filters that may actually match it, rather than to the
+   * number of filters in the set.
+   *
+   * Filters that reduce to a literal substring, prefix, suffix or exact match,
+   * such as `\.o$` or the glob `*.swp`, are evaluated with plain string
+   * comparisons and no regular expression is compiled for them.  Glob
+   * patterns that do not reduce to a literal are translated into an
+   * equivalent anchored extended regular expression.
+   *
+   * Filters added after the last call to compile() are evaluated without the
+   * prefilter, so that the set always returns correct results.
+   */
+  class path_filter_set
+  {
+  public:
+    /**
+     * @brief Adds a filter to the set.
+     *
+     * @param filter The filter to add.
+     * @exception libfsw_exception if the regular expression of @p filter
+     * cannot be compiled.
+     */
+    void add(const monitor_filter& filter);
+
+    /**
+     * @brief Removes all the filters from the set.
+     */
+    void clear();
+
+    /**
+     * @brief Builds the literal prefilter of the filters added so far.
+     */
+    void compile();
+
+    /**
+     * @brief Checks whether the set is empty.
+     *
+     * @return @c true if the set contains no filters, @c false otherwise.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Checks whether a path is accepted by the filters in the set.
+     *
+     * The filters are evaluated according to the semantics of @p mode, as
+     * described in @ref path-filtering.
+     *
+     * @param path The path to check.
+     * @param mode The filter evaluation mode.
+     * @return @c true if @p path is accepted, @c false otherwise.
+     */
+    bool accept(const std::string& path, fsw_filter_mode mode) const;
+
+    /**
+     * @brief Checks whether a path matches any filter in the set.
+     *
+     * The filter type is ignored.
+     *
+     * @param path The path to check.
+     * @return @c true if @p path matches at least one filter, @c false
+     * otherwise.
+     */
+    bool matches_any(const std::string& path) const;
+
+    /**
+     * @brief Checks whether all the paths starting with a prefix are rejected.
+     *
+     * A path starting with @p prefix is rejected regardless of its remaining
+     * characters if an exclusion filter not anchored to the end of the path
+     * matches @p prefix, and, in fsw_filter_mode::filter_mode_legacy mode, no
+     * inclusion filter exists.  The check is conservative: @c false may be
+     * returned even if every such path is rejected.
+     *
+     * @param prefix The path prefix to check.
+     * @param mode The filter evaluation mode.
+     * @return @c true if all the paths starting with @p prefix are rejected,
+     * @c false otherwise.
+     */
+    bool rejects_prefix(const std::string& prefix, fsw_filter_mode mode) const;
+
+  private:
+    enum class match_kind
+    {
+      regex,
+      substring,
+      prefix,
+      suffix,
+      exact
+    };
+
+    struct compiled_filter
+    {
+      std::regex regex;
+      fsw_filter_type type;
+      std::string literal;
+      match_kind kind = match_kind::regex;
+      std::string pattern;
+      bool case_sensitive = true;
+      bool end_anchored = false;
+    };
+
+    struct automaton_state
+    {
+      std::vector<std::pair<unsigned char, uint32_t>> transitions;
+      uint32_t failure = 0;
+      uint32_t output = 0;
+      int32_t keyword = -1;
+    };
+
+    uint32_t next_state(uint32_t state, unsigned char c) const;
+    void collect_candidates(const std::string& path,
+                            std::vector<uint32_t>& candidates) const;
+    bool matches(uint32_t index, const std::string& path) const;
+
+    std::vector<compiled_filter> filters;
+    std::vector<automaton_state> states;
+    std::vector<uint32_t> root_transitions;
+    std::vector<std::vector<uint32_t>> keyword_filters;
+    std::vector<uint32_t> unfiltered;
+    size_t compiled_count = 0;
+    size_t include_count = 0;
+  };
+}
+
+#endif  /* FSW_PATH_FILTER_SET_H */
@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "path_tree.hpp"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace fsw
+{
+  namespace
+  {
+    // Marks the parent of the nodes in the free list.
+    constexpr path_tree::node_id FREE_NODE = path_tree::npos - 1;
+    constexpr size_t MIN_BUCKET_COUNT = 16;
+    constexpr size_t MIN_WASTED_NAMES = 64 * 1024;
+  }
+
+  template<typename F>
+  bool path_tree::for_each_component(std::string_view path, F f)
+  {
+    bool found = false;
+    size_t pos = 0;
+
+    // The root directory is a component with an empty name.
+    if (!path.empty() && path[0] == '/')
+    {
+      if (!f(std::string_view())) return false;
+      found = true;
+      pos = 1;
+    }
+
+    while (pos < path.size())
+    {
+      size_t end = path.find('/', pos);
+      if (end == std::string_view::npos) end = path.size();
+
+      if (end > pos)
+      {
+        if (!f(path.substr(pos, end - pos))) return false;
+        found = true;
+      }
+
+      pos = end + 1;
+    }
+
+    return found;
+  }
+
+  path_tree::node_id path_tree::insert(std::string_view path)
+  {
+    node_id current = npos;
+
+    const bool found = for_each_component(path, [this, &current](std::string_view name)
+    {
+      node_id child = find_child(current, name);
+      current = (child != npos) ? child : add_child(current, name);
+      return true;
+    });
+
+    if (!found) return npos;
+
+    if (nodes[current].references++ == 0) ++referenced;
+
+    return current;
+  }
+
+  void path_tree::release(node_id id)
+  {
+    if (id >= nodes.size() || nodes[id].parent == FREE_NODE || nodes[id].references == 0)
+      return;
+
+    if (--nodes[id].references == 0) --referenced;
+
+    while (id != npos && nodes[id].references == 0 && nodes[id].children == 0)
+    {
+      const node_id parent = nodes[id].parent;
+      free_node(id);
+      id = parent;
+    }
+
+    if (node_count() == 0)
+    {
+      nodes.clear();
+      free_nodes.clear();
+      buckets.clear();
+      names.clear();
+      wasted_names = 0;
+    }
+  }
+
+  path_tree::node_id path_tree::find(std::string_view path) const
+  {
+    node_id current = npos;
+
+    const bool found = for_each_component(path, [this, &current](std::string_view name)
+    {
+      current = find_child(current, name);
+      return current != npos;
+    });
+
+    if (!found || nodes[current].references == 0) return npos;
+
+    return current;
+  }
+
+  std::string path_tree::get_path(node_id id) const
+  {
+    std::string path;
+    append_path(id, path);
+
+    return path;
+  }
+
+  void path_tree::append_path(node_id id, std::string& out, size_t extra) const
+  {
+    if (id >= nodes.size() || nodes[id].parent == FREE_NODE) return;
+
+    size_t length = 0;
+    size_t depth = 0;
+
+    for (node_id n = id; n != npos; n = nodes[n].parent)
+    {
+      length += nodes[n].name_length;
+      ++depth;
+    }
+
+    // The components are separated by a slash, and the root directory alone
+    // is a slash.
+    length += (length == 0) ? 1 : depth - 1;
+
+    const size_t start = out.size();
+    out.reserve(start + length + extra);
+    out.resize(start + length);
+
+    if (length == 1 && depth == 1 && nodes[id].name_length == 0)
+    {
+      out[start] = '/';
+      return;
+    }
+
+    size_t pos = start + length;
+
+    for (node_id n = id;; n = nodes[n].parent)
+    {
+      const std::string_view name = name_of(nodes[n]);
+      pos -= name.size();
+      if (!name.empty()) memcpy(&out[pos], name.data(), name.size());
+
+      if (nodes[n].parent == npos) break;
+      out[--pos] = '/';
+    }
+  }
+
+  size_t path_tree::bucket_of(node_id parent, std::string_view name) const
+  {
+    const size_t hash = std::hash<std::string_view>{}(name) ^
+                        (static_cast<size_t>(parent) * 0x9E3779B97F4A7C15ULL);
+
+    return hash & (buckets.size() - 1);
+  }
+
+  path_tree::node_id path_tree::find_child(node_id parent, std::string_view name) const
+  {
+    if (buckets.empty()) return npos;
+
+    const size_t mask = buckets.size() - 1;
+
+    for (size_t i = bucket_of(parent, name);; i = (i + 1) & mask)
+    {
+      const node_id id = buckets[i];
+      if (id == npos) return npos;
+      if (nodes[id].parent == parent && name_of(nodes[id]) == name) return id;
+    }
+  }
+
+  path_tree::node_id path_tree::add_child(node_id parent, std::string_view name)
+  {
+    // Keep the load factor of the table below 3/4.
+    if ((node_count() + 1) * 4 > buckets.size() * 3)
+      rehash(std::max(MIN_BUCKET_COUNT, buckets.size() * 2));
+
+    node_id id;
+
+    if (!free_nodes.empty())
+    {
+      id = free_nodes.back();
+      free_nodes.pop_back();
+    }
+    else
+    {
+      id = static_cast<node_id>(nodes.size());
+      nodes.emplace_back();
+    }
+
+    nodes[id] = {parent,
+                 static_cast<std::uint32_t>(names.size()),
+                 static_cast<std::uint32_t>(name.size()),
+                 0,
+                 0};
+    names.insert(names.end(), name.begin(), name.end());
+
+    if (parent != npos) ++nodes[parent].children;
+
+    const size_t mask = buckets.size() - 1;
+    size_t i = bucket_of(parent, name);
+    while (buckets[i] != npos) i = (i + 1) & mask;
+    buckets[i] = id;
+
+    return id;
+  }
+
+  void path_tree::free_node(node_id id)
+  {
+    const size_t mask = buckets.size() - 1;
+    size_t i = bucket_of(nodes[id].parent, name_of(nodes[id]));
+    while (buckets[i] != id) i = (i + 1) & mask;
+
+    // Shift back the following entries of the cluster which would no longer
+    // be reachable from their home bucket.
+    for (size_t j = (i + 1) & mask; buckets[j] != npos; j = (j + 1) & mask)
+    {
+      const node &n = nodes[buckets[j]];
+      const size_t home = bucket_of(n.parent, name_of(n));
+      const bool reachable = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+
+      if (!reachable)
+      {
+        buckets[i] = buckets[j];
+        i = j;
+      }
+    }
+
+    buckets[i] = npos;
+
+    const node_id parent = nodes[id].parent;
+    if (parent != npos) --nodes[parent].children;
+
+    wasted_names += nodes[id].name_length;
+    nodes[id] = {};
+    nodes[id].parent = FREE_NODE;
+    free_nodes.push_back(id);
+
+    if (wasted_names >= MIN_WASTED_NAMES && wasted_names * 2 > names.size()) compact_names();
+  }
+
+  void path_tree::rehash(size_t bucket_count)
+  {
+    buckets.assign(bucket_count, npos);
+    const size_t mask = bucket_count - 1;
+
+    for (node_id id = 0; id < nodes.size(); ++id)
+    {
+      if (nodes[id].parent == FREE_NODE) continue;
+
+      size_t i = bucket_of(nodes[id].parent, name_of(nodes[id]));
+      while (buckets[i] != npos) i = (i + 1) & mask;
+      buckets[i] = id;
+    }
+  }
+
+  void path_tree::compact_names()
+  {
+    std::vector<char> compacted;
+    compacted.reserve(names.size() - wasted_names);
+
+    for (node& n : nodes)
+    {
+      if (n.parent == FREE_NODE) continue;
+
+      const std::uint32_t offset = static_cast<std::uint32_t>(compacted.size());
+      compacted.insert(compacted.end(),
+                       names.begin() + n.name_offset,
+                       names.begin() + n.name_offset + n.name_length);
+      n.name_offset = offset;
+    }
+
+    names.swap(compacted);
+    wasted_names = 0;
+  }
+}
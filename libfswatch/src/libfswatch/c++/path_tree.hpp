@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file
+ * @brief Header of the fsw::path_tree class.
+ *
+ * This header file defines the fsw::path_tree class, a compact store of the
+ * paths watched by the Linux monitors.
+ *
+ * @copyright Copyright (c) 2026 Enrico M. Crisostomo
+ * @license GNU General Public License v. 3.0
+ * @author Enrico M. Crisostomo
+ * @version 1.22.0
+ */
+#ifndef FSW_PATH_TREE_H
+#  define FSW_PATH_TREE_H
+
+#  include <cstddef>
+#  include <cstdint>
+#  include <string>
+#  include <string_view>
+#  include <vector>
+
+namespace fsw
+{
+  /**
+   * @brief Store of paths sharing their common prefixes.
+   *
+   * The watched paths of a recursive monitor form a tree: storing each full
+   * path repeats the path of its parent directory.  This class stores a node
+   * for each path component instead, holding the component name and the
+   * identifier of its parent node, so that a path costs a node and its last
+   * component.  Full paths are materialized only when requested, walking the
+   * parent pointers.
+   *
+   * Paths are split at each `/` and empty components are skipped: `/a//b/`
+   * and `/a/b` are the same path, and they are materialized as `/a/b`.  `.`
+   * and `..` components are stored as any other name.
+   *
+   * A path is added with insert(), which returns the identifier of its node
+   * and acquires a reference to it, and removed releasing the reference with
+   * release().  A node is kept while it is referenced or it has children, and
+   * its identifier may be reused after it is freed.  Only referenced nodes
+   * can be found with find().
+   *
+   * The children of all the nodes are indexed in a single open addressing
+   * hash table of node identifiers keyed on the parent identifier and the
+   * name of the node.
+   */
+  class path_tree
+  {
+  public:
+    /**
+     * @brief Node identifier.
+     */
+    using node_id = std::uint32_t;
+
+    /**
+     * @brief Invalid node identifier.
+     */
+    static constexpr node_id npos = UINT32_MAX;
+
+    /**
+     * @brief Adds a path and acquires a reference to its node.
+     *
+     * @param path The path to add.
+     * @return The identifier of the node of @p path, or npos if @p path has no
+     * components.
+     */
+    node_id insert(std::string_view path);
+
+    /**
+     * @brief Releases a reference to a node acquired by insert().
+     *
+     * The node and its ancestors are freed when they are no longer referenced
+     * and have no children.
+     *
+     * @param id The node identifier.
+     */
+    void release(node_id id);
+
+    /**
+     * @brief Finds the node of a path.
+     *
+     * @param path The path to look up.
+     * @return The identifier of the node of @p path, or npos if @p path is not
+     * referenced.
+     */
+    node_id find(std::string_view path) const;
+
+    /**
+     * @brief Materializes the path of a node.
+     *
+     * @param id The node identifier.
+     * @return The path of the node.
+     */
+    std::string get_path(node_id id) const;
+
+    /**
+     * @brief Appends the path of a node to a string.
+     *
+     * @param id The node identifier.
+     * @param out The string to append the path to.
+     * @param extra The number of characters the caller is going to append
+     * after the path, which are reserved in @p out.
+     */
+    void append_path(node_id id, std::string& out, size_t extra = 0) const;
+
+    /**
+     * @brief Gets the number of referenced nodes.
+     *
+     * @return The number of paths in the tree.
+     */
+    size_t size() const
+    {
+      return referenced;
+    }
+
+    /**
+     * @brief Checks whether the tree is empty.
+     *
+     * @return @c true if the tree contains no paths.
+     */
+    bool empty() const
+    {
+      return referenced == 0;
+    }
+
+    /**
+     * @brief Gets the number of nodes, including the ancestors of the paths.
+     *
+     * @return The number of nodes.
+     */
+    size_t node_count() const
+    {
+      return nodes.size() - free_nodes.size();
+    }
+
+    /**
+     * @brief Gets an upper bound of the node identifiers.
+     *
+     * @return A value greater than any node identifier.
+     */
+    size_t id_bound() const
+    {
+      return nodes.size();
+    }
+
+  private:
+    struct node
+    {
+      node_id parent = npos;
+      std::uint32_t name_offset = 0;
+      std::uint32_t name_length = 0;
+      std::uint32_t references = 0;
+      std::uint32_t children = 0;
+    };
+
+    std::string_view name_of(const node& n) const
+    {
+      return {names.data() + n.name_offset, n.name_length};
+    }
+
+    node_id find_child(node_id parent, std::string_view name) const;
+    node_id add_child(node_id parent, std::string_view name);
+    void free_node(node_id id);
+    size_t bucket_of(node_id parent, std::string_view name) const;
+    void rehash(size_t bucket_count);
+    void compact_names();
+
+    template<typename F>
+    static bool for_each_component(std::string_view path, F f);
+
+    std::vector<node> nodes;
+    std::vector<node_id> free_nodes;
+    std::vector<node_id> buckets;
+    std::vector<char> names;
+    size_t wasted_names = 0;
+    size_t referenced = 0;
+  };
+}
+
+#endif  /* FSW_PATH_TREE_H */
@@ -28,11 +28,12 @@ namespace fsw
   std::vector<std::filesystem::directory_entry> get_directory_entries(const std::filesystem::path& path)
   {
     std::vector<std::filesystem::directory_entry> entries;
+    // Reserve an initial capacity to reduce the number of reallocations
+    // without listing the directory twice.
+    entries.reserve(64);
 
     try
     {
-      entries.reserve(std::distance(std::filesystem::directory_iterator(path), std::filesystem::directory_iterator{}));
-
       for (const auto& entry : std::filesystem::directory_iterator(path))
         entries.emplace_back(entry);
     }
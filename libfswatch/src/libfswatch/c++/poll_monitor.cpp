@@ -24,6 +24,7 @@
 #include "libfswatch/c/libfswatch_log.h"
 #include "poll_monitor.hpp"
 #include "path_utils.hpp"
+#include "directory_reader.hpp"
 
 #if defined HAVE_STRUCT_STAT_ST_MTIME
 #  define FSW_MTIME(stat) ((stat).st_mtime)
@@ -83,24 +84,24 @@ namespace fsw
 
     if (!previous_data->tracked_files.count(path))
     {
-      vector<fsw_event_flag> flags;
-      flags.push_back(fsw_event_flag::Created);
+      event_flag_set flags;
+      flags.insert(fsw_event_flag::Created);
       events.emplace_back(path, curr_time, flags);
 
       return true;
     }
 
     watched_file_info pwfi = previous_data->tracked_files[path];
-    vector<fsw_event_flag> flags;
+    event_flag_set flags;
 
     if (mtime > pwfi.mtime)
     {
-      flags.push_back(fsw_event_flag::Updated);
+      flags.insert(fsw_event_flag::Updated);
     }
 
     if (ctime > pwfi.ctime)
     {
-      flags.push_back(fsw_event_flag::AttributeModified);
+      flags.insert(fsw_event_flag::AttributeModified);
     }
 
     if (!flags.empty())
@@ -148,20 +149,9 @@ namespace fsw
       // using lstat for now.
       struct stat fd_stat;
       if (!stat_path(path, fd_stat, follow_symlinks)) return;
-      if (should_prune_path(path.string(), S_ISDIR(fd_stat.st_mode), is_root_path)) return;
-      if (!is_root_path && !S_ISDIR(fd_stat.st_mode) && !accept_path(path)) return;
 
-      if (!add_path(path, fd_stat, fn)) return;
-      if (!recursive) return;
-      if (!S_ISDIR(fd_stat.st_mode)) return;
+      scan_entry(path, fd_stat, fn, is_root_path);
 #endif
-
-      const auto entries = get_directory_entries(path);
-
-      for (const auto& entry : entries)
-      {
-        scan(entry.path(), fn, false);
-      }
     }
     catch (const std::filesystem::filesystem_error& e)
     {
@@ -170,10 +160,56 @@ namespace fsw
     }
   }
 
+  void poll_monitor::scan_entry(const path& path,
+                                const struct stat& fd_stat,
+                                const path_visitor& fn,
+                                const bool is_root_path)
+  {
+    if (should_prune_path(path.string(), S_ISDIR(fd_stat.st_mode), is_root_path)) return;
+    if (!is_root_path && !S_ISDIR(fd_stat.st_mode) && !accept_path(path)) return;
+
+    if (!add_path(path, fd_stat, fn)) return;
+    if (!recursive) return;
+    if (!S_ISDIR(fd_stat.st_mode)) return;
+
+    scan_directory(path, fn);
+  }
+
+  void poll_monitor::scan_directory(const path& path, const path_visitor& fn)
+  {
+    // The entries are stat'ed relative to the directory descriptor, instead of
+    // looking up their path twice.
+    directory_reader reader(path.string());
+    directory_entry_info entry;
+
+    while (reader.next(entry))
+    {
+      const std::filesystem::path child = path / entry.name;
+
+      if (follow_symlinks && entry.type == entry_type::symlink)
+      {
+        std::string link_path;
+        if (reader.read_symlink(entry.name, link_path)) scan(link_path, fn, false);
+        continue;
+      }
+
+      // As in scan(), the status of a symbolic link that is not followed is
+      // the status of its target.
+      struct stat fd_stat;
+      if (!reader.stat(entry.name, fd_stat, true))
+      {
+        fsw_logf_perror(_("Cannot stat %s"), child.c_str());
+        continue;
+      }
+
+      scan_entry(child, fd_stat, fn, false);
+    }
+  }
+
   void poll_monitor::find_removed_files()
   {
-    vector<fsw_event_flag> flags;
-    flags.push_back(fsw_event_flag::Removed);
+    event_flag_set flags;
+    flags.insert(fsw_event_flag::Removed);
 
     for (const auto& [key, value] : previous_data->tracked_files)
     {
@@ -237,7 +273,7 @@ namespace fsw
 
       if (!events.empty())
       {
-        notify_events(events);
+        notify_events(std::move(events));
         events.clear();
       }
     }
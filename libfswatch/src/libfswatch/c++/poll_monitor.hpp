@@ -80,6 +80,11 @@ namespace fsw
     void scan(const std::filesystem::path& path,
               const path_visitor& fn,
               bool is_root_path = false);
+    void scan_entry(const std::filesystem::path& path,
+                    const struct stat& fd_stat,
+                    const path_visitor& fn,
+                    bool is_root_path);
+    void scan_directory(const std::filesystem::path& path, const path_visitor& fn);
     void collect_initial_data();
     void collect_data();
     bool add_path(const std::string& path,
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file
+ * @brief Header of the fsw::spmc_ring class.
+ *
+ * This header file defines the fsw::spmc_ring class, a bounded lock-free queue
+ * filled by a single producer thread and emptied by one or more threads.
+ *
+ * @copyright Copyright (c) 2026 Enrico M. Crisostomo
+ * @license GNU General Public License v. 3.0
+ * @author Enrico M. Crisostomo
+ * @version 1.22.0
+ */
+#ifndef FSW_SPMC_RING_H
+#  define FSW_SPMC_RING_H
+
+#  include <atomic>
+#  include <cstddef>
+#  include <memory>
+#  include <optional>
+#  include <utility>
+
+namespace fsw
+{
+  /**
+   * @brief Bounded lock-free single-producer multi-consumer ring buffer.
+   *
+   * The ring can be safely used by one producer thread, calling try_push(),
+   * and any number of threads calling try_pop() concurrently, including the
+   * producer itself, for example to discard the oldest element when the ring
+   * is full.  Each slot carries a sequence number, and popping threads claim
+   * slots with a compare-and-swap on the head: it must not be replaced by a
+   * plain store as long as more than one thread pops.  The capacity of the ring is
+   * rounded up to the nearest power of 2.  No memory is allocated after
+   * construction, except by the copy or move operations of @p T.
+   *
+   * @tparam T The type of the elements.
+   */
+  template<typename T>
+  class spmc_ring
+  {
+  public:
+    /**
+     * @brief Constructs a ring with at least the specified capacity.
+     *
+     * @param capacity The minimum capacity of the ring.
+     */
+    explicit spmc_ring(size_t capacity)
+    {
+      size_t size = 2;
+      while (size < capacity) size <<= 1;
+
+      slots.reset(new slot[size]);
+      mask = size - 1;
+
+      for (size_t i = 0; i < size; ++i)
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    spmc_ring(const spmc_ring&) = delete;
+    spmc_ring& operator=(const spmc_ring&) = delete;
+
+    /**
+     * @brief Appends an element to the ring.
+     *
+     * This function must only be called by the producer thread.  If the ring
+     * is full, @p value is left untouched.
+     *
+     * @param value The element to append.
+     * @return @c true if @p value was appended, @c false if the ring is full.
+     */
+    template<typename U>
+    bool try_push(U&& value)
+    {
+      const size_t current_tail = tail.load(std::memory_order_relaxed);
+      slot& current = slots[current_tail & mask];
+
+      // A slot is free when its sequence number equals the position being
+      // written: until the element it holds is popped, it lags one lap behind.
+      if (current.sequence.load(std::memory_order_acquire) != current_tail)
+        return false;
+
+      current.value.emplace(std::forward<U>(value));
+      current.sequence.store(current_tail + 1, std::memory_order_release);
+      tail.store(current_tail + 1, std::memory_order_release);
+
+      return true;
+    }
+
+    /**
+     * @brief Removes the oldest element from the ring.
+     *
+     * This function may be called concurrently by any thread, including the
+     * producer thread.
+     *
+     * @return The removed element, or an empty optional if the ring is empty.
+     */
+    std::optional<T> try_pop()
+    {
+      size_t current_head = head.load(std::memory_order_relaxed);
+      slot *current;
+
+      for (;;)
+      {
+        current = &slots[current_head & mask];
+        const size_t sequence = current->sequence.load(std::memory_order_acquire);
+
+        if (sequence == current_head + 1)
+        {
+          // The slot is published: claim it.
+          if (head.compare_exchange_weak(current_head,
+                                         current_head + 1,
+                                         std::memory_order_relaxed))
+            break;
+        }
+        else if (sequence == current_head)
+        {
+          // The slot has not been published yet: the ring is empty.
+          return std::nullopt;
+        }
+        else
+        {
+          // Another thread claimed the slot.
+          current_head = head.load(std::memory_order_relaxed);
+        }
+      }
+
+      std::optional<T> value(std::move(current->value));
+      current->value.reset();
+      current->sequence.store(current_head + mask + 1, std::memory_order_release);
+
+      return value;
+    }
+
+    /**
+     * @brief Returns the number of elements in the ring.
+     *
+     * The value is exact only when no other thread is pushing or popping
+     * elements.
+     */
+    size_t size() const
+    {
+      // An element may be claimed before tail is advanced past it.
+      const size_t current_head = head.load(std::memory_order_acquire);
+      const size_t current_tail = tail.load(std::memory_order_acquire);
+
+      return current_tail > current_head ? current_tail - current_head : 0;
+    }
+
+    /**
+     * @brief Checks whether the ring is empty.
+     */
+    bool empty() const
+    {
+      return size() == 0;
+    }
+
+    /**
+     * @brief Returns the capacity of the ring.
+     */
+    size_t capacity() const
+    {
+      return mask + 1;
+    }
+
+  private:
+    struct slot
+    {
+      std::atomic<size_t> sequence{0};
+      std::optional<T> value;
+    };
+
+    std::unique_ptr<slot[]> slots;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+  };
+}
+
+#endif  /* FSW_SPMC_RING_H */
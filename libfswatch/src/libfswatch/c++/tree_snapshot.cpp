@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <libfswatch/libfswatch_config.h>
+#include "tree_snapshot.hpp"
+#include <utility>
+
+#if defined HAVE_STRUCT_STAT_ST_MTIME
+#  define FSW_MTIME(stat) ((stat).st_mtime)
+#  define FSW_CTIME(stat) ((stat).st_ctime)
+#elif defined HAVE_STRUCT_STAT_ST_MTIMESPEC
+#  define FSW_MTIME(stat) (stat.st_mtimespec.tv_sec)
+#  define FSW_CTIME(stat) (stat.st_ctimespec.tv_sec)
+#else
+#  error "Either HAVE_STRUCT_STAT_ST_MTIME or HAVE_STRUCT_STAT_ST_MTIMESPEC must be defined"
+#endif
+
+namespace fsw
+{
+  namespace
+  {
+    event_flag_set with_type(event_flag_set flags, bool is_dir)
+    {
+      if (is_dir) flags.insert(fsw_event_flag::IsDir);
+      return flags;
+    }
+  }
+
+  void tree_snapshot::insert(std::string path, const struct stat& fd_stat)
+  {
+    files.insert_or_assign(std::move(path),
+                           file_state{fd_stat.st_ino,
+                                      fd_stat.st_size,
+                                      FSW_MTIME(fd_stat),
+                                      FSW_CTIME(fd_stat),
+                                      S_ISDIR(fd_stat.st_mode)});
+  }
+
+  bool tree_snapshot::contains(const std::string& path) const
+  {
+    return files.find(path) != files.end();
+  }
+
+  std::vector<event> tree_snapshot::diff(const tree_snapshot& current, time_t evt_time) const
+  {
+    std::vector<event> events;
+
+    for (const auto& [path, state] : files)
+    {
+      if (current.files.find(path) == current.files.end())
+        events.emplace_back(path, evt_time, with_type({fsw_event_flag::Removed}, state.is_dir));
+    }
+
+    for (const auto& [path, state] : current.files)
+    {
+      const auto previous = files.find(path);
+
+      if (previous == files.end())
+      {
+        events.emplace_back(path, evt_time, with_type({fsw_event_flag::Created}, state.is_dir));
+        continue;
+      }
+
+      const file_state& old_state = previous->second;
+
+      if (old_state.inode != state.inode || old_state.is_dir != state.is_dir)
+      {
+        events.emplace_back(path, evt_time, with_type({fsw_event_flag::Removed}, old_state.is_dir));
+        events.emplace_back(path, evt_time, with_type({fsw_event_flag::Created}, state.is_dir));
+        continue;
+      }
+
+      if (state.is_dir) continue;
+
+      if (old_state.size != state.size || old_state.mtime != state.mtime)
+        events.emplace_back(path, evt_time, event_flag_set{fsw_event_flag::Updated});
+      else if (old_state.ctime != state.ctime)
+        events.emplace_back(path, evt_time, event_flag_set{fsw_event_flag::AttributeModified});
+    }
+
+    return events;
+  }
+
+  bool tree_snapshot::empty() const
+  {
+    return files.empty();
+  }
+
+  size_t tree_snapshot::size() const
+  {
+    return files.size();
+  }
+}
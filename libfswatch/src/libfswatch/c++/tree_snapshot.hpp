@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file
+ * @brief Header of the fsw::tree_snapshot class.
+ *
+ * This header file defines the fsw::tree_snapshot class, the status of the
+ * files of a watched tree at a point in time, used by the monitors to find the
+ * changes they failed to observe.
+ *
+ * @copyright Copyright (c) 2026 Enrico M. Crisostomo
+ * @license GNU General Public License v. 3.0
+ * @author Enrico M. Crisostomo
+ * @version 1.22.0
+ */
+#ifndef FSW_TREE_SNAPSHOT_H
+#  define FSW_TREE_SNAPSHOT_H
+
+#  include "event.hpp"
+#  include <cstddef>
+#  include <ctime>
+#  include <string>
+#  include <sys/stat.h>
+#  include <unordered_map>
+#  include <vector>
+
+namespace fsw
+{
+  /**
+   * @brief Snapshot of the files of a tree.
+   *
+   * A snapshot records the inode, the size, and the modification and status
+   * change times of each file of a tree.  Comparing two snapshots of a tree
+   * yields the events describing the changes that occurred in between, such
+   * as the changes whose events were lost when the event queue of a monitor
+   * overflowed.  As in the poll monitor, times are compared with a resolution
+   * of one second, so that a file rewritten with the same size within the
+   * second the snapshot is taken is not reported as updated.
+   */
+  class tree_snapshot
+  {
+  public:
+    /**
+     * @brief Records the status of a file.
+     *
+     * @param path The path of the file.
+     * @param fd_stat The status of the file.
+     */
+    void insert(std::string path, const struct stat& fd_stat);
+
+    /**
+     * @brief Checks whether a file is recorded.
+     *
+     * @param path The path of the file.
+     * @return @c true if @p path is recorded, @c false otherwise.
+     */
+    bool contains(const std::string& path) const;
+
+    /**
+     * @brief Gets the events describing the changes to another snapshot.
+     *
+     * The files only found in @p current are reported as created, and those
+     * only found in this snapshot as removed.  A file whose inode changed is
+     * reported as removed and created again.  A file whose size or
+     * modification time changed is reported as updated, and a file whose
+     * status change time only changed is reported as having its attributes
+     * modified.  The modifications of directories are not reported, since
+     * their times change with their entries.
+     *
+     * @param current The newer snapshot of the tree.
+     * @param evt_time The time of the events.
+     * @return The events describing the changes.
+     */
+    std::vector<event> diff(const tree_snapshot& current, time_t evt_time) const;
+
+    /**
+     * @brief Checks whether the snapshot is empty.
+     *
+     * @return @c true if no file is recorded, @c false otherwise.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Gets the number of files recorded.
+     *
+     * @return The number of files recorded.
+     */
+    size_t size() const;
+
+  private:
+    struct file_state
+    {
+      ino_t inode;
+      off_t size;
+      time_t mtime;
+      time_t ctime;
+      bool is_dir;
+    };
+
+    std::unordered_map<std::string, file_state> files;
+  };
+}
+
+#endif  /* FSW_TREE_SNAPSHOT_H */
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "watch_table.hpp"
+
+namespace fsw
+{
+  void watch_table::insert(int wd, std::string_view path)
+  {
+    if (wd < 0) return;
+
+    erase(wd);
+
+    const path_tree::node_id node = paths.insert(path);
+    if (node == path_tree::npos) return;
+
+    if (static_cast<size_t>(wd) >= slots.size()) slots.resize(static_cast<size_t>(wd) + 1);
+    if (paths.id_bound() > node_descriptors.size()) node_descriptors.resize(paths.id_bound(), -1);
+
+    // A path watched by an older descriptor now refers to the new one, which
+    // is chained to it.
+    slots[wd] = {node, watch_exclusion::unknown, node_descriptors[node]};
+    node_descriptors[node] = wd;
+    ++count;
+  }
+
+  bool watch_table::erase(int wd)
+  {
+    if (!contains(wd)) return false;
+
+    // Unlink the descriptor from the chain of its node, so that the path
+    // refers to the newest remaining descriptor.
+    const path_tree::node_id node = slots[wd].node;
+    int *link = &node_descriptors[node];
+
+    while (*link != wd) link = &slots[*link].older;
+    *link = slots[wd].older;
+
+    paths.release(node);
+    slots[wd] = {};
+    --count;
+
+    if (count == 0)
+    {
+      slots.clear();
+      node_descriptors.clear();
+    }
+
+    return true;
+  }
+
+  int watch_table::get_descriptor(std::string_view path) const
+  {
+    const path_tree::node_id node = paths.find(path);
+
+    return node != path_tree::npos ? node_descriptors[node] : -1;
+  }
+}
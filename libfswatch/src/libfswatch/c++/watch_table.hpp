@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file
+ * @brief Header of the fsw::watch_table class.
+ *
+ * This header file defines the fsw::watch_table class, the table of the watch
+ * descriptors used by the inotify monitor.
+ *
+ * @copyright Copyright (c) 2026 Enrico M. Crisostomo
+ * @license GNU General Public License v. 3.0
+ * @author Enrico M. Crisostomo
+ * @version 1.22.0
+ */
+#ifndef FSW_WATCH_TABLE_H
+#  define FSW_WATCH_TABLE_H
+
+#  include "path_tree.hpp"
+#  include <cstddef>
+#  include <cstdint>
+#  include <string>
+#  include <string_view>
+#  include <vector>
+
+namespace fsw
+{
+  /**
+   * @brief Cached verdict of the path filters on a watched directory.
+   */
+  enum class watch_exclusion : std::uint8_t
+  {
+    unknown,  /**< The verdict has not been computed yet. */
+    excluded, /**< All the descendants of the directory are excluded. */
+    included  /**< Some descendants of the directory may be included. */
+  };
+
+  /**
+   * @brief Table of watch descriptors and of the paths they refer to.
+   *
+   * Watch descriptors are small integers assigned by the kernel, so the table
+   * stores its entries in a vector indexed by descriptor: looking up the
+   * entry of an event is a bounds-checked array access.
+   *
+   * Paths are stored in a fsw::path_tree and materialized when requested, so
+   * that the directories of a recursive watch do not repeat the path of their
+   * parent.  The descriptor watching a path is looked up finding the node of
+   * the path in the tree.  If the same path is inserted with different
+   * descriptors, as happens when a directory is replaced before the watch of
+   * the old one is removed, the path refers to the newest one, and to the
+   * newest remaining one when it is removed.
+   */
+  class watch_table
+  {
+  public:
+    watch_table() = default;
+    watch_table(const watch_table&) = delete;
+    watch_table& operator=(const watch_table&) = delete;
+
+    /**
+     * @brief Inserts a descriptor, replacing its path if already present.
+     *
+     * The exclusion verdict of the descriptor is reset.
+     *
+     * @param wd The watch descriptor.  It must not be negative.
+     * @param path The path watched by @p wd.
+     */
+    void insert(int wd, std::string_view path);
+
+    /**
+     * @brief Removes a descriptor.
+     *
+     * @param wd The watch descriptor.
+     * @return @c true if @p wd was present, @c false otherwise.
+     */
+    bool erase(int wd);
+
+    /**
+     * @brief Checks whether a descriptor is present.
+     *
+     * @param wd The watch descriptor.
+     * @return @c true if @p wd is present, @c false otherwise.
+     */
+    bool contains(int wd) const
+    {
+      return wd >= 0 && static_cast<size_t>(wd) < slots.size() &&
+             slots[wd].node != path_tree::npos;
+    }
+
+    /**
+     * @brief Gets the path watched by a descriptor.
+     *
+     * @param wd The watch descriptor.
+     * @return The path watched by @p wd, or an empty string if @p wd is not
+     * present.
+     */
+    std::string get_path(int wd) const
+    {
+      std::string path;
+      append_path(wd, path);
+
+      return path;
+    }
+
+    /**
+     * @brief Appends the path watched by a descriptor to a string.
+     *
+     * Nothing is appended if @p wd is not present.
+     *
+     * @param wd The watch descriptor.
+     * @param out The string to append the path to.
+     * @param extra The number of characters the caller is going to append
+     * after the path, which are reserved in @p out.
+     */
+    void append_path(int wd, std::string& out, size_t extra = 0) const
+    {
+      if (contains(wd)) paths.append_path(slots[wd].node, out, extra);
+    }
+
+    /**
+     * @brief Gets the descriptor watching a path.
+     *
+     * @param path The path.
+     * @return The newest present descriptor watching @p path, or -1 if the
+     * path is not watched.
+     */
+    int get_descriptor(std::string_view path) const;
+
+    /**
+     * @brief Gets the cached exclusion verdict of a descriptor.
+     *
+     * @param wd The watch descriptor.
+     * @return The verdict, or watch_exclusion::unknown if @p wd is not
+     * present.
+     */
+    watch_exclusion get_exclusion(int wd) const
+    {
+      return contains(wd) ? slots[wd].exclusion : watch_exclusion::unknown;
+    }
+
+    /**
+     * @brief Caches the exclusion verdict of a descriptor.
+     *
+     * @param wd The watch descriptor.  Missing descriptors are ignored.
+     * @param exclusion The verdict.
+     */
+    void set_exclusion(int wd, watch_exclusion exclusion)
+    {
+      if (contains(wd)) slots[wd].exclusion = exclusion;
+    }
+
+    /**
+     * @brief Gets the number of descriptors in the table.
+     *
+     * @return The number of descriptors.
+     */
+    size_t size() const
+    {
+      return count;
+    }
+
+    /**
+     * @brief Checks whether the table is empty.
+     *
+     * @return @c true if the table contains no descriptors.
+     */
+    bool empty() const
+    {
+      return size() == 0;
+    }
+
+    /**
+     * @brief Invokes a function on each descriptor.
+     *
+     * @param f A function invocable with an `int`.
+     */
+    template<typename F>
+    void for_each(F f) const
+    {
+      for (size_t wd = 0; wd < slots.size(); ++wd)
+      {
+        if (slots[wd].node != path_tree::npos) f(static_cast<int>(wd));
+      }
+    }
+
+  private:
+    struct slot
+    {
+      path_tree::node_id node = path_tree::npos;
+      watch_exclusion exclusion = watch_exclusion::unknown;
+      // The next older descriptor of the same node, or -1.
+      int older = -1;
+    };
+
+    std::vector<slot> slots;
+    path_tree paths;
+    // The newest descriptor of each node, indexed by node identifier.
+    std::vector<int> node_descriptors;
+    size_t count = 0;
+  };
+}
+
+#endif  /* FSW_WATCH_TABLE_H */
@@ -22,7 +22,6 @@
 #include "libfswatch/gettext_defs.h"
 #include <string>
 #include <cstdlib>
-#include <set>
 
 namespace fsw
 {
@@ -48,19 +47,19 @@ namespace fsw
 
   static const vector<win_flag_type> event_flag_type = create_flag_type_vector();
 
-  static vector<fsw_event_flag> decode_flags(DWORD flag)
+  static event_flag_set decode_flags(DWORD flag)
   {
-    set<fsw_event_flag> evt_flags_set;
+    event_flag_set evt_flags;
 
     for (const win_flag_type & event_type : event_flag_type)
     {
       if (flag == event_type.action)
       {
-        for (const auto & type : event_type.types) evt_flags_set.insert(type);
+        for (const auto & type : event_type.types) evt_flags.insert(type);
       }
     }
 
-    return vector<fsw_event_flag>(evt_flags_set.begin(), evt_flags_set.end());
+    return evt_flags;
   }
 
   directory_change_event::directory_change_event(size_t buffer_length)
@@ -185,7 +185,7 @@ namespace fsw
     {
       vector<event> events = dce.get_events();
 
-      if (events.size()) notify_events(events);
+      if (events.size()) notify_events(std::move(events));
     }
 
     if (!dce.read_changes_async())
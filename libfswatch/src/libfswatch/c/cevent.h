@@ -30,6 +30,7 @@
 
 #  include <time.h>
 #  include <limits.h>
+#  include <stddef.h>
 #  include <stdbool.h>
 #  include "libfswatch_types.h"
 
@@ -154,6 +155,37 @@ extern "C"
     bool has_process_pidfd;
   } fsw_cevent_v2;
 
+  /**
+   * A file change event with extended metadata and a compact flag
+   * representation.
+   *
+   * Events of this type are delivered by FSW_CEVENT_CALLBACK_V3 callbacks.
+   * The flags of an event are represented as a bit mask of fsw_event_flag
+   * values, whose value is 0 for a NoOp event.  The path is a null-terminated
+   * string of path_length bytes.  The secondary path, such as the destination
+   * of a rename reported as a single event, is a null-terminated string of
+   * secondary_path_length bytes, or @c NULL if the event has none.
+   *
+   * Event batches are laid out in memory owned by the session and reused
+   * across batches: the events and their paths are valid only while the
+   * callback is executing or, in pull mode, until the next call to
+   * fsw_read_events().
+   */
+  typedef struct fsw_cevent_v3
+  {
+    const char * path;
+    size_t path_length;
+    time_t evt_time;
+    unsigned int flags;
+    unsigned long correlation_id;
+    enum fsw_process_id_kind process_id_kind;
+    long long process_id;
+    int process_pidfd;
+    bool has_process_pidfd;
+    const char * secondary_path;
+    size_t secondary_path_length;
+  } fsw_cevent_v3;
+
   /**
    * A function pointer of type FSW_CEVENT_CALLBACK is used by the API as a
    * callback to provide information about received events.  The callback is
@@ -177,6 +209,15 @@ extern "C"
                                          const unsigned int event_num,
                                          void *data);
 
+  /**
+   * A callback receiving events with a compact flag representation.  Once
+   * the session has processed its largest batch, event delivery performs no
+   * memory allocation.
+   */
+  typedef void (*FSW_CEVENT_CALLBACK_V3)(fsw_cevent_v3 const *const events,
+                                         const unsigned int event_num,
+                                         void *data);
+
 #  ifdef __cplusplus
 }
 #  endif
@@ -49,6 +49,7 @@ extern "C"
 #  define FSW_ERR_MONITOR_ALREADY_RUNNING   (1 << 12) /**< A monitor is already running in the specified session. */
 #  define FSW_ERR_UNKNOWN_VALUE             (1 << 13) /**< The value is unknown. */
 #  define FSW_ERR_INVALID_PROPERTY          (1 << 14) /**< The property is invalid. */
+#  define FSW_ERR_INVALID_MODE              (1 << 15) /**< The operation is not supported by the mode of the session. */
 
 #  ifdef __cplusplus
 }
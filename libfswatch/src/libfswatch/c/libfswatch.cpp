@@ -474,16 +474,112 @@
 #include <vector>
 #include <map>
 #include <unordered_map>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+#include <future>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
 #include <libfswatch/libfswatch_config.h>
+#ifdef HAVE_SYS_EVENTFD_H
+#  include <sys/eventfd.h>
+#endif
 #include "libfswatch.h"
 #include "libfswatch/c++/filter.hpp"
 #include "libfswatch/c++/monitor.hpp"
 #include "libfswatch/c++/monitor_factory.hpp"
 #include "libfswatch/c++/libfswatch_exception.hpp"
+#include "libfswatch/c++/spmc_ring.hpp"
 
 using namespace std;
 using namespace fsw;
 
+/*
+ * Event queue of a session in pull mode.  The monitor runs in a thread owned
+ * by the queue, and the callback proxy pushes events into a bounded ring from
+ * which fsw_read_events() pops them.  The notification descriptor is readable
+ * while the ring is not empty.
+ */
+struct fsw_event_queue
+{
+  explicit fsw_event_queue(size_t capacity);
+  ~fsw_event_queue();
+
+  fsw_event_queue(const fsw_event_queue&) = delete;
+  fsw_event_queue& operator=(const fsw_event_queue&) = delete;
+
+  void signal() const;
+  void drain() const;
+
+  spmc_ring<event> ring;
+  int read_fd = -1;
+  int write_fd = -1;
+  std::atomic<bool> overflowed{false};
+  std::atomic<bool> finished{true};
+  std::atomic<int> status{FSW_OK};
+  std::thread runner;
+  // Events returned by the last call to fsw_read_events().
+  vector<event> delivered;
+};
+
+fsw_event_queue::fsw_event_queue(size_t capacity) : ring(capacity)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+  read_fd = write_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (read_fd == -1) throw int(FSW_ERR_UNKNOWN_ERROR);
+#else
+  int fds[2];
+  if (pipe(fds) == -1) throw int(FSW_ERR_UNKNOWN_ERROR);
+
+  for (int fd : fds)
+  {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+
+  read_fd = fds[0];
+  write_fd = fds[1];
+#endif
+}
+
+fsw_event_queue::~fsw_event_queue()
+{
+  if (runner.joinable()) runner.join();
+
+  close(read_fd);
+  if (write_fd != read_fd) close(write_fd);
+}
+
+void fsw_event_queue::signal() const
+{
+#ifdef HAVE_SYS_EVENTFD_H
+  const uint64_t value = 1;
+#else
+  const char value = 1;
+#endif
+
+  while (write(write_fd, &value, sizeof(value)) == -1 && errno == EINTR)
+  {
+  }
+}
+
+void fsw_event_queue::drain() const
+{
+  char buffer[64];
+
+  for (;;)
+  {
+    const ssize_t count = read(read_fd, buffer, sizeof(buffer));
+
+    if (count > 0 && read_fd == write_fd) break;
+    if (count > 0) continue;
+    if (count == -1 && errno == EINTR) continue;
+    break;
+  }
+}
+
 using FSW_SESSION = struct FSW_SESSION
 {
   vector<string> paths;
@@ -491,6 +587,7 @@ using FSW_SESSION = struct FSW_SESSION
   fsw::monitor *monitor;
   FSW_CEVENT_CALLBACK callback;
   FSW_CEVENT_CALLBACK_V2 callback_v2;
+  FSW_CEVENT_CALLBACK_V3 callback_v3;
   double latency;
   bool allow_overflow;
   bool recursive;
@@ -502,6 +599,7 @@ using FSW_SESSION = struct FSW_SESSION
   vector<fsw_event_type_filter> event_type_filters;
   map<string, string> properties;
   void *data;
+  unique_ptr<fsw_event_queue> queue;
 };
 
 #define FSW_THREAD_LOCAL thread_local
@@ -534,9 +632,109 @@ using fsw_callback_context = struct fsw_callback_context
   FSW_HANDLE handle;
   FSW_CEVENT_CALLBACK callback;
   FSW_CEVENT_CALLBACK_V2 callback_v2;
+  FSW_CEVENT_CALLBACK_V3 callback_v3;
+  fsw_event_queue *queue;
   void *data;
+  // Event batch passed to callback_v3, reused across batches.
+  vector<fsw_cevent_v3> cevents_v3;
 };
 
+/*
+ * Copies the flags of the events into a single buffer, so that a batch of
+ * events requires a single allocation for all its flags.  The buffer must be
+ * released with free().
+ */
+static fsw_event_flag *copy_event_flags(const std::vector<event>& events)
+{
+  size_t flags_num = 0;
+
+  for (const event& evt : events) flags_num += evt.get_flag_set().size();
+
+  if (flags_num == 0) return nullptr;
+
+  auto *const flags = static_cast<fsw_event_flag *> (
+    malloc(sizeof(fsw_event_flag) * flags_num));
+  if (!flags) throw int(FSW_ERR_MEMORY);
+
+  fsw_event_flag *next = flags;
+
+  for (const event& evt : events)
+  {
+    for (const fsw_event_flag flag : evt.get_flag_set()) *next++ = flag;
+  }
+
+  return flags;
+}
+
+static enum fsw_process_id_kind to_cprocess_id_kind(const process_id_kind kind)
+{
+  switch (kind)
+  {
+  case process_id_kind::pid:
+    return FSW_PROCESS_ID_PID;
+  case process_id_kind::tid:
+    return FSW_PROCESS_ID_TID;
+  case process_id_kind::none:
+  default:
+    return FSW_PROCESS_ID_NONE;
+  }
+}
+
+// Converts an event to a C event pointing to its paths.
+static void to_cevent_v3(const event& evt, fsw_cevent_v3& cevt)
+{
+  cevt.path = evt.get_path().c_str();
+  cevt.path_length = evt.get_path().size();
+  cevt.evt_time = evt.get_time();
+  cevt.flags = evt.get_flag_set().get_mask() & ~event_flag_set::NOOP_BIT;
+  cevt.correlation_id = evt.get_correlation_id();
+  cevt.process_id_kind = to_cprocess_id_kind(evt.get_process_id_kind());
+  cevt.process_id = evt.get_process_id();
+  cevt.process_pidfd = evt.get_process_pidfd();
+  cevt.has_process_pidfd = evt.has_process_pidfd();
+  cevt.secondary_path = evt.has_secondary_path() ? evt.get_secondary_path().c_str() : nullptr;
+  cevt.secondary_path_length = evt.get_secondary_path().size();
+}
+
+/*
+ * Notifies a batch to a FSW_CEVENT_CALLBACK_V3 callback.  The C events point
+ * to the paths of the C++ events and are stored in a buffer owned by the
+ * context: once the buffer has grown to the size of the largest batch, no
+ * memory is allocated.
+ */
+static void notify_cevents_v3(const std::vector<event>& events,
+                              fsw_callback_context *context)
+{
+  vector<fsw_cevent_v3>& cevents = context->cevents_v3;
+  cevents.resize(events.size());
+
+  for (size_t i = 0; i < events.size(); ++i)
+  {
+    to_cevent_v3(events[i], cevents[i]);
+  }
+
+  (*(context->callback_v3))(cevents.data(), cevents.size(), context->data);
+}
+
+/*
+ * Pushes a batch into the queue of a session in pull mode.  Events that do
+ * not fit are dropped, and an overflow is reported to the reader.
+ */
+static void enqueue_events(const std::vector<event>& events,
+                           fsw_event_queue *queue)
+{
+  bool dropped = false;
+
+  for (const event& evt : events)
+  {
+    if (!queue->ring.try_push(evt)) dropped = true;
+  }
+
+  if (dropped) queue->overflowed.store(true, std::memory_order_release);
+
+  queue->signal();
+}
+
 void libfsw_cpp_callback_proxy(const std::vector<event>& events,
                                void *context_ptr)
 {
@@ -544,7 +742,24 @@ void libfsw_cpp_callback_proxy(const std::vector<event>& events,
   if (!context_ptr)
     throw int(FSW_ERR_MISSING_CONTEXT);
 
-  const fsw_callback_context *context = static_cast<fsw_callback_context *> (context_ptr);
+  auto *context = static_cast<fsw_callback_context *> (context_ptr);
+
+  if (context->queue)
+  {
+    enqueue_events(events, context->queue);
+    return;
+  }
+
+  if (context->callback_v3)
+  {
+    notify_cevents_v3(events, context);
+    return;
+  }
+
+  // The C events point to the paths of the C++ events and to a shared flag
+  // buffer: both are valid for the whole duration of the callback.
+  fsw_event_flag *const flags = copy_event_flags(events);
+  fsw_event_flag *next_flags = flags;
 
   if (context->callback_v2)
   {
@@ -552,68 +767,34 @@ void libfsw_cpp_callback_proxy(const std::vector<event>& events,
       sizeof(fsw_cevent_v2) * events.size()));
 
     if (cevents == nullptr)
+    {
+      free(static_cast<void *> (flags));
       throw int(FSW_ERR_MEMORY);
+    }
 
     for (unsigned int i = 0; i < events.size(); ++i)
     {
       fsw_cevent_v2 *cevt = &cevents[i];
       const event& evt = events[i];
 
-      const string path = evt.get_path();
-      cevt->path = static_cast<char *> (malloc(path.length() + 1));
-      if (!cevt->path) throw int(FSW_ERR_MEMORY);
-
-      strncpy(cevt->path, path.c_str(), path.length());
-      cevt->path[path.length()] = '\0';
+      cevt->path = const_cast<char *> (evt.get_path().c_str());
       cevt->evt_time = evt.get_time();
       cevt->correlation_id = evt.get_correlation_id();
 
-      switch (evt.get_process_id_kind())
-      {
-      case process_id_kind::pid:
-        cevt->process_id_kind = FSW_PROCESS_ID_PID;
-        break;
-      case process_id_kind::tid:
-        cevt->process_id_kind = FSW_PROCESS_ID_TID;
-        break;
-      case process_id_kind::none:
-        cevt->process_id_kind = FSW_PROCESS_ID_NONE;
-        break;
-      }
-
+      cevt->process_id_kind = to_cprocess_id_kind(evt.get_process_id_kind());
       cevt->process_id = evt.get_process_id();
       cevt->process_pidfd = evt.get_process_pidfd();
       cevt->has_process_pidfd = evt.has_process_pidfd();
 
-      const vector<fsw_event_flag> flags = evt.get_flags();
-      cevt->flags_num = flags.size();
-
-      if (!cevt->flags_num) cevt->flags = nullptr;
-      else
-      {
-        cevt->flags =
-          static_cast<fsw_event_flag *> (
-            malloc(sizeof(fsw_event_flag) * cevt->flags_num));
-        if (!cevt->flags) throw int(FSW_ERR_MEMORY);
-      }
-
-      for (unsigned int e = 0; e < cevt->flags_num; ++e)
-      {
-        cevt->flags[e] = flags[e];
-      }
+      cevt->flags_num = evt.get_flag_set().size();
+      cevt->flags = cevt->flags_num ? next_flags : nullptr;
+      next_flags += cevt->flags_num;
     }
 
     (*(context->callback_v2))(cevents, events.size(), context->data);
 
-    for (unsigned int i = 0; i < events.size(); ++i)
-    {
-      fsw_cevent_v2 *cevt = &cevents[i];
-
-      if (cevt->flags) free(static_cast<void *> (cevt->flags));
-      free(static_cast<void *> (cevt->path));
-    }
-
     free(static_cast<void *> (cevents));
+    free(static_cast<void *> (flags));
     return;
   }
 
@@ -621,7 +802,10 @@ void libfsw_cpp_callback_proxy(const std::vector<event>& events,
     sizeof(fsw_cevent) * events.size()));
 
   if (cevents == nullptr)
+  {
+    free(static_cast<void *> (flags));
     throw int(FSW_ERR_MEMORY);
+  }
 
   for (unsigned int i = 0; i < events.size(); ++i)
   {
@@ -629,47 +813,18 @@ void libfsw_cpp_callback_proxy(const std::vector<event>& events,
     const event& evt = events[i];
 
     // Copy event into C event wrapper.
-    const string path = evt.get_path();
-
-    // Copy std::string into char * buffer and null-terminate it.
-    cevt->path = static_cast<char *> (malloc(path.length() + 1));
-    if (!cevt->path) throw int(FSW_ERR_MEMORY);
-
-    strncpy(cevt->path, path.c_str(), path.length());
-    cevt->path[path.length()] = '\0';
+    cevt->path = const_cast<char *> (evt.get_path().c_str());
     cevt->evt_time = evt.get_time();
-
-    const vector<fsw_event_flag> flags = evt.get_flags();
-    cevt->flags_num = flags.size();
-
-    if (!cevt->flags_num) cevt->flags = nullptr;
-    else
-    {
-      cevt->flags =
-        static_cast<fsw_event_flag *> (
-          malloc(sizeof(fsw_event_flag) * cevt->flags_num));
-      if (!cevt->flags) throw int(FSW_ERR_MEMORY);
-    }
-
-    for (unsigned int e = 0; e < cevt->flags_num; ++e)
-    {
-      cevt->flags[e] = flags[e];
-    }
+    cevt->flags_num = evt.get_flag_set().size();
+    cevt->flags = cevt->flags_num ? next_flags : nullptr;
+    next_flags += cevt->flags_num;
   }
 
   // TODO manage C++ exceptions from C code
   (*(context->callback))(cevents, events.size(), context->data);
 
-  // Deallocate memory allocated by events.
-  for (unsigned int i = 0; i < events.size(); ++i)
-  {
-    fsw_cevent *cevt = &cevents[i];
-
-    if (cevt->flags) free(static_cast<void *> (cevt->flags));
-    free(static_cast<void *> (cevt->path));
-  }
-
   free(static_cast<void *> (cevents));
+  free(static_cast<void *> (flags));
 }
 
 FSW_HANDLE fsw_init_session(const fsw_monitor_type type)
@@ -687,7 +842,8 @@ int create_monitor(const FSW_HANDLE handle, const fsw_monitor_type type)
     FSW_SESSION *session = get_session(handle);
 
     // Check sufficient data is present to build a monitor.
-    if (!session->callback && !session->callback_v2)
+    if (!session->callback && !session->callback_v2 && !session->callback_v3 &&
+        !session->queue)
       return fsw_set_last_error(int(FSW_ERR_CALLBACK_NOT_SET));
 
     if (session->monitor)
@@ -700,6 +856,8 @@ int create_monitor(const FSW_HANDLE handle, const fsw_monitor_type type)
     context_ptr->handle = session;
     context_ptr->callback = session->callback;
     context_ptr->callback_v2 = session->callback_v2;
+    context_ptr->callback_v3 = session->callback_v3;
+    context_ptr->queue = session->queue.get();
     context_ptr->data = session->data;
 
     monitor *current_monitor = monitor_factory::create_monitor(type,
@@ -754,6 +912,7 @@ FSW_STATUS fsw_set_callback(const FSW_HANDLE handle,
   FSW_SESSION *session = get_session(handle);
   session->callback = callback;
   session->callback_v2 = nullptr;
+  session->callback_v3 = nullptr;
   session->data = data;
 
   return fsw_set_last_error(FSW_OK);
@@ -769,11 +928,135 @@ FSW_STATUS fsw_set_callback_v2(const FSW_HANDLE handle,
   FSW_SESSION *session = get_session(handle);
   session->callback = nullptr;
   session->callback_v2 = callback;
+  session->callback_v3 = nullptr;
+  session->data = data;
+
+  return fsw_set_last_error(FSW_OK);
+}
+
+FSW_STATUS fsw_set_callback_v3(const FSW_HANDLE handle,
+                               const FSW_CEVENT_CALLBACK_V3 callback,
+                               void *data)
+{
+  if (!callback)
+    return fsw_set_last_error(int(FSW_ERR_INVALID_CALLBACK));
+
+  FSW_SESSION *session = get_session(handle);
+  session->callback = nullptr;
+  session->callback_v2 = nullptr;
+  session->callback_v3 = callback;
   session->data = data;
 
   return fsw_set_last_error(FSW_OK);
 }
 
+FSW_STATUS fsw_set_pull_mode(const FSW_HANDLE handle, const unsigned int capacity)
+{
+  try
+  {
+    FSW_SESSION *session = get_session(handle);
+
+    if (capacity == 0)
+      return fsw_set_last_error(int(FSW_ERR_UNKNOWN_VALUE));
+
+    if (session->monitor)
+      return fsw_set_last_error(int(FSW_ERR_MONITOR_ALREADY_EXISTS));
+
+    session->queue.reset(new fsw_event_queue(capacity));
+  }
+  catch (int error)
+  {
+    return fsw_set_last_error(error);
+  }
+
+  return fsw_set_last_error(FSW_OK);
+}
+
+int fsw_get_event_fd(const FSW_HANDLE handle)
+{
+  FSW_SESSION *session = get_session(handle);
+
+  if (!session->queue)
+  {
+    fsw_set_last_error(int(FSW_ERR_INVALID_MODE));
+    return -1;
+  }
+
+  fsw_set_last_error(FSW_OK);
+  return session->queue->read_fd;
+}
+
+int fsw_read_events(const FSW_HANDLE handle,
+                    fsw_cevent_v3 *events,
+                    const unsigned int max)
+{
+  FSW_SESSION *session = get_session(handle);
+  fsw_event_queue *queue = session->queue.get();
+
+  if (!queue)
+  {
+    fsw_set_last_error(int(FSW_ERR_INVALID_MODE));
+    return -1;
+  }
+
+  if (!events && max)
+  {
+    fsw_set_last_error(int(FSW_ERR_UNKNOWN_VALUE));
+    return -1;
+  }
+
+  // Release the events returned by the previous call.
+  queue->delivered.clear();
+
+  if (max && queue->overflowed.exchange(false, std::memory_order_acq_rel))
+  {
+    time_t curr_time;
+    time(&curr_time);
+
+    queue->delivered.emplace_back("", curr_time, event_flag_set{fsw_event_flag::Overflow});
+  }
+
+  while (queue->delivered.size() < max)
+  {
+    std::optional<event> evt = queue->ring.try_pop();
+    if (!evt) break;
+
+    queue->delivered.push_back(std::move(*evt));
+  }
+
+  // Reset the descriptor once the queue is empty.  Events pushed while the
+  // descriptor is being drained would be missed, hence the queue is checked
+  // again afterwards.
+  if (queue->ring.empty())
+  {
+    queue->drain();
+
+    if (!queue->ring.empty() || queue->overflowed.load(std::memory_order_acquire))
+      queue->signal();
+  }
+
+  // Once the monitor has ended because of an error and its events have been
+  // read, the error is reported.
+  if (queue->delivered.empty() && queue->finished && queue->ring.empty())
+  {
+    const int status = queue->status.load();
+
+    if (status != FSW_OK)
+    {
+      fsw_set_last_error(status);
+      return -1;
+    }
+  }
+
+  for (size_t i = 0; i < queue->delivered.size(); ++i)
+  {
+    to_cevent_v3(queue->delivered[i], events[i]);
+  }
+
+  fsw_set_last_error(FSW_OK);
+  return static_cast<int>(queue->delivered.size());
+}
+
 FSW_STATUS fsw_set_allow_overflow(const FSW_HANDLE handle,
                                   const bool allow_overflow)
 {
@@ -874,6 +1157,65 @@ bool fsw_is_running(const FSW_HANDLE handle)
   return session->monitor->is_running();
 }
 
+/*
+ * Runs the monitor of a session in pull mode in the thread of its queue, and
+ * waits until the monitor is running, so that it can be stopped as soon as
+ * this function returns.  When the monitor ends, the notification descriptor
+ * is signalled so that the reader learns its status from fsw_read_events().
+ */
+static FSW_STATUS start_pull_monitor(FSW_SESSION *session)
+{
+  fsw_event_queue *queue = session->queue.get();
+  monitor *mon = session->monitor;
+
+  if (queue->runner.joinable()) queue->runner.join();
+
+  queue->status = FSW_OK;
+  queue->finished = false;
+
+  std::promise<bool> started;
+  std::future<bool> running = started.get_future();
+
+  queue->runner = std::thread([queue, mon, started = std::move(started)]() mutable
+                              {
+                                bool notified = false;
+
+                                try
+                                {
+                                  mon->start([&started, &notified]
+                                             {
+                                               notified = true;
+                                               started.set_value(true);
+                                             });
+                                }
+                                catch (const libfsw_exception& ex)
+                                {
+                                  queue->status = int(ex);
+                                }
+                                catch (int error)
+                                {
+                                  queue->status = error;
+                                }
+                                catch (...)
+                                {
+                                  queue->status = FSW_ERR_UNKNOWN_ERROR;
+                                }
+
+                                queue->finished = true;
+                                queue->signal();
+
+                                if (!notified) started.set_value(false);
+                              });
+
+  // Once the monitor is running, its errors are reported by fsw_read_events()
+  // and fsw_stop_monitor(), whether or not it has already ended.
+  if (running.get()) return FSW_OK;
+
+  queue->runner.join();
+
+  return queue->status.exchange(FSW_OK);
+}
+
 FSW_STATUS fsw_start_monitor(const FSW_HANDLE handle)
 {
   try
@@ -894,6 +1236,7 @@ FSW_STATUS fsw_start_monitor(const FSW_HANDLE handle)
     if (session->monitor->is_running())
       return fsw_set_last_error(int(FSW_ERR_MONITOR_ALREADY_RUNNING));
 
+    session->monitor->set_properties(session->properties);
     session->monitor->set_allow_overflow(session->allow_overflow);
     session->monitor->set_filter_mode(session->filter_mode);
     session->monitor->set_filters(session->filters);
@@ -904,6 +1247,9 @@ FSW_STATUS fsw_start_monitor(const FSW_HANDLE handle)
     session->monitor->set_recursive(session->recursive);
     session->monitor->set_directory_only(session->directory_only);
 
+    if (session->queue)
+      return fsw_set_last_error(start_pull_monitor(session));
+
     session->monitor->start();
   }
   catch (const libfsw_exception& ex)
@@ -927,6 +1273,15 @@ FSW_STATUS fsw_stop_monitor(const FSW_HANDLE handle)
     if (session->monitor == nullptr)
       return fsw_set_last_error(int(FSW_ERR_UNKNOWN_MONITOR_TYPE));
 
+    if (session->queue)
+    {
+      session->monitor->stop();
+
+      if (session->queue->runner.joinable()) session->queue->runner.join();
+
+      return fsw_set_last_error(session->queue->status.exchange(FSW_OK));
+    }
+
     if (!session->monitor->is_running())
       return fsw_set_last_error(int(FSW_OK));
 
@@ -959,6 +1314,11 @@ FSW_STATUS fsw_destroy_session(const FSW_HANDLE handle)
         return fsw_set_last_error(FSW_ERR_MONITOR_ALREADY_RUNNING);
       }
 
+      if (session->queue && session->queue->runner.joinable())
+      {
+        session->queue->runner.join();
+      }
+
       void *context = session->monitor->get_context();
 
       if (context)
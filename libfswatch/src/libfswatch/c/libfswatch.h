@@ -139,6 +139,63 @@ extern "C"
                                  const FSW_CEVENT_CALLBACK_V2 callback,
                                  void * data);
 
+  /**
+   * Sets the callback the monitor invokes when events with a compact flag
+   * representation are received.  The memory of the events is owned by the
+   * session and reused across batches.
+   *
+   * See cevent.h for the definition of FSW_CEVENT_CALLBACK_V3.
+   */
+  FSW_STATUS fsw_set_callback_v3(const FSW_HANDLE handle,
+                                 const FSW_CEVENT_CALLBACK_V3 callback,
+                                 void * data);
+
+  /**
+   * Enables the pull mode of the session.  In pull mode, fsw_start_monitor()
+   * creates a thread owned by the session, runs the monitor in it and returns
+   * as soon as the monitor is running.  The thread is joined by
+   * fsw_stop_monitor(), by the next fsw_start_monitor() once the monitor has
+   * ended, or by fsw_destroy_session().
+   *
+   * Events are stored by that thread in a bounded queue of at least
+   * @p capacity events, from which they are read with fsw_read_events(), and
+   * callbacks are not invoked.  When the queue is full, new events are
+   * dropped and the next call to fsw_read_events() returns an event with the
+   * Overflow flag.
+   *
+   * fsw_start_monitor() returns FSW_OK once the monitor is running, even if it
+   * then fails at once, for example because of an invalid property.  The
+   * error the monitor ends with is returned by fsw_read_events() once all the
+   * events have been read, and by fsw_stop_monitor().
+   *
+   * The pull mode must be enabled before the monitor is started for the first
+   * time.
+   */
+  FSW_STATUS fsw_set_pull_mode(const FSW_HANDLE handle, const unsigned int capacity);
+
+  /**
+   * Gets a file descriptor which is readable when events are available to
+   * fsw_read_events(), suitable for use with poll(), epoll() and similar
+   * APIs.  The descriptor is owned by the session and must not be read from
+   * or closed.  Returns -1 if the session is not in pull mode.
+   */
+  int fsw_get_event_fd(const FSW_HANDLE handle);
+
+  /**
+   * Reads up to @p max events from the queue of a session in pull mode
+   * without blocking.  The events, and their paths, are valid until the next
+   * call to fsw_read_events() or until the session is destroyed.  Events must
+   * be read by a single thread at a time.
+   *
+   * Returns the number of events read, which is 0 if no event is available,
+   * or -1 in case of error.  If the monitor has ended because of an error,
+   * the descriptor becomes readable and, once all its events have been read,
+   * -1 is returned and the error of the monitor is set as the last error.
+   */
+  int fsw_read_events(const FSW_HANDLE handle,
+                      fsw_cevent_v3 * events,
+                      const unsigned int max);
+
   /**
    * Sets the latency of the monitor.  By default, the latency is set to 1 s.
    */
@@ -206,12 +263,15 @@ extern "C"
 
   /**
    * Starts the monitor if it is properly configured.  Depending on the type of
-   * monitor this call might return when a monitor is stopped or not.
+   * monitor this call might return when a monitor is stopped or not.  In pull
+   * mode, this call returns once the monitor is running in the thread of the
+   * session: see fsw_set_pull_mode().
    */
   FSW_STATUS fsw_start_monitor(const FSW_HANDLE handle);
 
   /**
-   * Stops a running monitor.
+   * Stops a running monitor.  In pull mode, this call waits for the monitor
+   * thread to terminate and returns the error it terminated with, if any.
    */
   FSW_STATUS fsw_stop_monitor(const FSW_HANDLE handle);
 
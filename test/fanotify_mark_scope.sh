@@ -0,0 +1,148 @@
+#!/bin/sh
+#
+# Copyright (c) 2026 Enrico M. Crisostomo
+#
+# This program is free software; you can redistribute it and/or modify it under
+# the terms of the GNU General Public License as published by the Free Software
+# Foundation; either version 3, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+# details.
+#
+# You should have received a copy of the GNU General Public License along with
+# this program.  If not, see <http://www.gnu.org/licenses/>.
+
+set -eu
+
+if [ "$#" -eq 1 ]; then
+  FSWATCH=$1
+elif [ -z "${FSWATCH:-}" ]; then
+  echo "usage: $0 FSWATCH" >&2
+  exit 2
+fi
+
+if ! "${FSWATCH}" -M | grep -q '^  fanotify_monitor$'; then
+  echo "fanotify monitor is not built on this platform" >&2
+  exit 77
+fi
+
+TMPDIR=${TMPDIR:-/tmp}
+WORKDIR=$(mktemp -d "${TMPDIR%/}/fswatch-fanotify-mark-scope.XXXXXX")
+# The events of the whole filesystem are received: the logs are written to
+# another filesystem if possible, since writing them would be reported too.
+LOGDIR=$(mktemp -d /dev/shm/fswatch-fanotify-mark-scope.XXXXXX 2>/dev/null || mktemp -d)
+PID=
+
+cleanup() {
+  if [ -n "${PID}" ]; then
+    kill "${PID}" 2>/dev/null || true
+    wait "${PID}" 2>/dev/null || true
+  fi
+
+  rm -rf "${WORKDIR}" "${LOGDIR}"
+}
+
+trap cleanup EXIT INT TERM
+
+TESTDIR="${WORKDIR}/watched"
+OTHERDIR="${WORKDIR}/other"
+mkdir "${TESTDIR}" "${OTHERDIR}" "${TESTDIR}/pruned"
+
+"${FSWATCH}" -m fanotify_monitor -r --format '%p %f' \
+  --prune '/pruned$' \
+  --monitor-property fanotify.mark-scope=filesystem \
+  "${TESTDIR}" \
+  > "${LOGDIR}/out.log" 2> "${LOGDIR}/err.log" &
+PID=$!
+
+sleep 1
+
+if ! kill -0 "${PID}" 2>/dev/null; then
+  if grep -Eqi 'fanotify|permission|operation not permitted|not supported|CAP_SYS_ADMIN' "${LOGDIR}/err.log"; then
+    echo "fanotify filesystem marks are unavailable in this environment" >&2
+    sed -n '1,120p' "${LOGDIR}/err.log" >&2
+    exit 77
+  fi
+
+  echo "fanotify monitor exited unexpectedly" >&2
+  sed -n '1,120p' "${LOGDIR}/err.log" >&2
+  exit 1
+fi
+
+# The directories created in the watched tree are not marked: the events of
+# their entries are reported by the filesystem mark.
+mkdir -p "${TESTDIR}/nested/deeper"
+echo created > "${TESTDIR}/nested/deeper/mark-scope-child.txt"
+echo outside > "${OTHERDIR}/mark-scope-outside.txt"
+echo pruned > "${TESTDIR}/pruned/mark-scope-pruned.txt"
+
+mkdir "${OTHERDIR}/moved"
+echo moved > "${OTHERDIR}/moved/mark-scope-moved-child.txt"
+mv "${OTHERDIR}/moved" "${TESTDIR}/moved"
+
+rm "${TESTDIR}/nested/deeper/mark-scope-child.txt"
+
+event_seen() {
+  basename=$1
+  flag=$2
+
+  grep -E "${basename} .*${flag}" "${LOGDIR}/out.log" >/dev/null
+}
+
+wait_for_event() {
+  basename=$1
+  flag=$2
+  attempt=0
+
+  while [ "${attempt}" -lt 10 ]; do
+    if event_seen "${basename}" "${flag}"; then
+      return 0
+    fi
+
+    attempt=$((attempt + 1))
+    sleep 1
+  done
+
+  return 1
+}
+
+fail() {
+  echo "$1" >&2
+  echo "--- fswatch output ---" >&2
+  sed -n '1,240p' "${LOGDIR}/out.log" >&2
+  echo "--- fswatch stderr ---" >&2
+  sed -n '1,160p' "${LOGDIR}/err.log" >&2
+  exit 1
+}
+
+assert_event() {
+  wait_for_event "$1" "$2" || fail "missing fanotify event: $3"
+}
+
+assert_event "${TESTDIR}/nested" 'Created' 'subdirectory creation'
+assert_event "${TESTDIR}/nested/deeper" 'Created' 'nested subdirectory creation'
+assert_event 'mark-scope-child\.txt' 'Created' 'nested file creation'
+assert_event 'mark-scope-child\.txt' 'Removed' 'nested file removal'
+assert_event "${TESTDIR}/moved" 'MovedTo' 'directory moved into the tree'
+assert_event "${TESTDIR}/moved/mark-scope-moved-child\.txt" 'Created' 'entry of a moved directory'
+
+# The paths of the directories are cached once resolved: the events in a
+# renamed directory, or in a directory whose parent was renamed, are reported
+# at their new path.
+mkdir -p "${TESTDIR}/outer/inner"
+echo cached > "${TESTDIR}/outer/inner/mark-scope-cached.txt"
+assert_event 'outer/inner/mark-scope-cached\.txt' 'Created' 'file creation before the rename'
+
+mv "${TESTDIR}/outer" "${TESTDIR}/renamed"
+echo renamed > "${TESTDIR}/renamed/inner/mark-scope-renamed.txt"
+assert_event "${TESTDIR}/renamed/inner/mark-scope-renamed\.txt" 'Created' 'file creation after the rename'
+
+if grep -E 'outer/inner/mark-scope-renamed' "${LOGDIR}/out.log" >/dev/null; then
+  fail "fanotify event reported at the path of a renamed directory"
+fi
+
+if grep -E 'mark-scope-outside|mark-scope-pruned' "${LOGDIR}/out.log" >/dev/null; then
+  fail "fanotify event reported outside the watched tree"
+fi
@@ -0,0 +1,114 @@
+#!/bin/sh
+#
+# Copyright (c) 2026 Enrico M. Crisostomo
+#
+# This program is free software; you can redistribute it and/or modify it under
+# the terms of the GNU General Public License as published by the Free Software
+# Foundation; either version 3, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+# details.
+#
+# You should have received a copy of the GNU General Public License along with
+# this program.  If not, see <http://www.gnu.org/licenses/>.
+
+set -eu
+
+if [ "$#" -eq 1 ]; then
+  FSWATCH=$1
+elif [ -z "${FSWATCH:-}" ]; then
+  echo "usage: $0 FSWATCH" >&2
+  exit 2
+fi
+
+if ! "${FSWATCH}" -M | grep -q '^  fanotify_monitor$'; then
+  echo "fanotify monitor is not built on this platform" >&2
+  exit 77
+fi
+
+TMPDIR=${TMPDIR:-/tmp}
+WORKDIR=$(mktemp -d "${TMPDIR%/}/fswatch-fanotify-rename.XXXXXX")
+PID=
+
+cleanup() {
+  if [ -n "${PID}" ]; then
+    kill "${PID}" 2>/dev/null || true
+    wait "${PID}" 2>/dev/null || true
+  fi
+
+  rm -rf "${WORKDIR}"
+}
+
+trap cleanup EXIT INT TERM
+
+TESTDIR="${WORKDIR}/watched"
+OTHERDIR="${WORKDIR}/other"
+mkdir "${TESTDIR}" "${OTHERDIR}" "${TESTDIR}/dir"
+echo source > "${TESTDIR}/rename-source.txt"
+echo outgoing > "${TESTDIR}/rename-outgoing.txt"
+echo incoming > "${OTHERDIR}/rename-incoming.txt"
+
+"${FSWATCH}" -m fanotify_monitor -r --format '%p|%s|%f' \
+  --monitor-property fanotify.report-renames=true \
+  "${TESTDIR}" \
+  > "${WORKDIR}/out.log" 2> "${WORKDIR}/err.log" &
+PID=$!
+
+sleep 1
+
+if ! kill -0 "${PID}" 2>/dev/null; then
+  if grep -Eqi 'fanotify|permission|operation not permitted|not supported|FAN_RENAME' "${WORKDIR}/err.log"; then
+    echo "fanotify rename events are unavailable in this environment" >&2
+    sed -n '1,120p' "${WORKDIR}/err.log" >&2
+    exit 77
+  fi
+
+  echo "fanotify monitor exited unexpectedly" >&2
+  sed -n '1,120p' "${WORKDIR}/err.log" >&2
+  exit 1
+fi
+
+mv "${TESTDIR}/rename-source.txt" "${TESTDIR}/dir/rename-target.txt"
+mv "${TESTDIR}/rename-outgoing.txt" "${OTHERDIR}/rename-outgoing.txt"
+mv "${OTHERDIR}/rename-incoming.txt" "${TESTDIR}/rename-incoming.txt"
+
+wait_for_line() {
+  pattern=$1
+  attempt=0
+
+  while [ "${attempt}" -lt 10 ]; do
+    if grep -E "${pattern}" "${WORKDIR}/out.log" >/dev/null; then
+      return 0
+    fi
+
+    attempt=$((attempt + 1))
+    sleep 1
+  done
+
+  return 1
+}
+
+fail() {
+  echo "$1" >&2
+  echo "--- fswatch output ---" >&2
+  sed -n '1,240p' "${WORKDIR}/out.log" >&2
+  echo "--- fswatch stderr ---" >&2
+  sed -n '1,160p' "${WORKDIR}/err.log" >&2
+  exit 1
+}
+
+# A rename within the watched tree is a single event carrying both paths.
+wait_for_line "^${TESTDIR}/rename-source\.txt\|${TESTDIR}/dir/rename-target\.txt\|.*Renamed" ||
+  fail "missing rename event with both paths"
+
+if grep -E "^${TESTDIR}/dir/rename-target\.txt\|" "${WORKDIR}/out.log" >/dev/null; then
+  fail "rename reported as a separate event at its destination"
+fi
+
+# A rename out of or into the watched tree is reported at its watched path.
+wait_for_line "^${TESTDIR}/rename-outgoing\.txt\|\|.*MovedFrom" ||
+  fail "missing move out of the watched tree"
+wait_for_line "^${TESTDIR}/rename-incoming\.txt\|\|.*MovedTo" ||
+  fail "missing move into the watched tree"
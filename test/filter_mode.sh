@@ -224,3 +224,31 @@ run_case exclude-only --filter-mode=conjunctive -e '/skip\.c$'
 assert_no_event '/skip\.c .*Created' 'conjunctive exclude-only event' "${OUT}" "${ERR}"
 assert_event '/other\.txt .*Created' 'conjunctive exclude-only unmatched event' "${OUT}" "${ERR}"
 stop_fswatch
+
+# Children of a directory excluded as a whole are rejected, unless a legacy
+# inclusion filter overrides the exclusion.
+run_subtree_case() {
+  name=$1
+  shift
+  TESTDIR="${WORKDIR}/${name}"
+  mkdir -p "${TESTDIR}/hot/objects"
+  OUT="${WORKDIR}/${name}.out"
+  ERR="${WORKDIR}/${name}.err"
+
+  start_fswatch "${OUT}" "${ERR}" "$@" "${TESTDIR}"
+
+  echo blob > "${TESTDIR}/hot/objects/blob"
+  echo blob > "${TESTDIR}/hot/objects/blob.c"
+  echo keep > "${TESTDIR}/keep.c"
+
+  assert_event '/keep\.c .*Created' "${name}: included event" "${OUT}" "${ERR}"
+}
+
+run_subtree_case excluded-subtree --filter-mode=conjunctive -e '/hot/'
+assert_no_event '/hot/objects/blob' 'conjunctive excluded subtree event' "${OUT}" "${ERR}"
+stop_fswatch
+
+run_subtree_case legacy-excluded-subtree -e '/hot/' -i '\.c$'
+assert_event '/hot/objects/blob\.c .*Created' 'legacy include in excluded subtree' "${OUT}" "${ERR}"
+assert_no_event '/hot/objects/blob .*Created' 'legacy excluded subtree event' "${OUT}" "${ERR}"
+stop_fswatch
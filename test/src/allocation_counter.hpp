@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Replaces the global operator new and operator delete to count the heap
+ * allocations of a benchmark and, on Linux, the usable size of the heap blocks
+ * they hold.  The replacement functions are defined in this header, which must
+ * be included by a single translation unit of the executable.
+ *
+ * Allocations and deallocations are counted while counting is set, except
+ * those of the threads setting excluded_thread, such as a thread generating
+ * the workload of the benchmark.
+ */
+#ifndef FSW_TEST_ALLOCATION_COUNTER_H
+#  define FSW_TEST_ALLOCATION_COUNTER_H
+
+#  include <atomic>
+#  include <cstdlib>
+#  include <new>
+#  ifdef __linux__
+#    include <malloc.h>
+#  endif
+
+namespace allocation_counter
+{
+  inline std::atomic<bool> counting{false};
+  inline thread_local bool excluded_thread = false;
+  inline std::atomic<unsigned long> allocations{0};
+  inline std::atomic<long long> bytes{0};
+
+  inline bool counted()
+  {
+    return counting.load(std::memory_order_relaxed) && !excluded_thread;
+  }
+
+  inline long long usable_size(void *p)
+  {
+#  ifdef __linux__
+    return static_cast<long long>(malloc_usable_size(p));
+#  else
+    (void) p;
+    return 0;
+#  endif
+  }
+}
+
+void *operator new(std::size_t size)
+{
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) throw std::bad_alloc();
+
+  if (allocation_counter::counted())
+  {
+    allocation_counter::allocations.fetch_add(1, std::memory_order_relaxed);
+    allocation_counter::bytes.fetch_add(allocation_counter::usable_size(p),
+                                        std::memory_order_relaxed);
+  }
+
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  if (p != nullptr && allocation_counter::counted())
+  {
+    allocation_counter::bytes.fetch_sub(allocation_counter::usable_size(p),
+                                        std::memory_order_relaxed);
+  }
+
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+  operator delete(p);
+}
+
+#endif  /* FSW_TEST_ALLOCATION_COUNTER_H */
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libfswatch/c++/libfswatch_exception.hpp>
+#include <libfswatch/c++/monitor.hpp>
+
+using namespace fsw;
+
+namespace
+{
+  constexpr size_t event_count = 64;
+
+  bool expect(bool condition, const std::string& message)
+  {
+    if (condition) return true;
+
+    std::cerr << message << "\n";
+    return false;
+  }
+
+  // Records the delivered events, simulating a slow consumer: if held, the
+  // first invocation waits until the monitor has produced all its events,
+  // otherwise every invocation sleeps for the specified delay.
+  struct delivery_context
+  {
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::chrono::milliseconds delay{0};
+    bool hold = false;
+    bool released = false;
+    std::thread::id producer;
+    bool delivered_by_producer = false;
+    std::vector<event> events;
+  };
+
+  void record_events(const std::vector<event>& events, void *data)
+  {
+    auto *context = static_cast<delivery_context *>(data);
+    std::unique_lock<std::mutex> guard(context->mutex);
+
+    if (std::this_thread::get_id() == context->producer)
+      context->delivered_by_producer = true;
+
+    context->events.insert(context->events.end(), events.begin(), events.end());
+
+    if (context->hold)
+      context->condition.wait(guard, [context] { return context->released; });
+    else
+      std::this_thread::sleep_for(context->delay);
+  }
+
+  void fail(const std::vector<event>&, void *)
+  {
+    throw libfsw_exception("callback failure");
+  }
+
+  // Produces events for path_count paths from its run loop, as a backend
+  // would.
+  class producing_monitor : public monitor
+  {
+  public:
+    producing_monitor(FSW_EVENT_CALLBACK *callback,
+                      delivery_context *context,
+                      size_t path_count) :
+      monitor({"/"}, callback, context), delivery(context), path_count(path_count)
+    {
+    }
+
+  protected:
+    void run() override
+    {
+      const fsw_event_flag flags[] = {fsw_event_flag::Created,
+                                      fsw_event_flag::Updated};
+
+      for (size_t i = 0; i < event_count; ++i)
+      {
+        notify_events({{"/file" + std::to_string(i % path_count),
+                        0,
+                        {flags[(i / path_count) % 2]}}});
+      }
+
+      if (!delivery) return;
+
+      std::lock_guard<std::mutex> guard(delivery->mutex);
+      delivery->released = true;
+      delivery->condition.notify_all();
+    }
+
+  private:
+    delivery_context *delivery;
+    size_t path_count;
+  };
+
+  async_delivery_counters run_monitor(delivery_context& context,
+                                      async_overflow_policy policy,
+                                      size_t capacity,
+                                      size_t path_count)
+  {
+    producing_monitor mon(record_events, &context, path_count);
+    mon.set_allow_overflow(true);
+    mon.set_async_delivery(capacity, policy);
+    context.producer = std::this_thread::get_id();
+    mon.start();
+
+    return mon.get_async_delivery_counters();
+  }
+}
+
+int main()
+{
+  bool ok = true;
+
+  // Without asynchronous delivery, the monitor thread invokes the callback.
+  {
+    delivery_context context;
+    producing_monitor mon(record_events, &context, event_count);
+    context.producer = std::this_thread::get_id();
+    mon.start();
+
+    const async_delivery_counters counters = mon.get_async_delivery_counters();
+    ok = expect(context.delivered_by_producer, "synchronous delivery used another thread") && ok;
+    ok = expect(context.events.size() == event_count, "synchronous events were lost") && ok;
+    ok = expect(counters.delivered == 0 && counters.blocked == 0,
+                "counters of a synchronous monitor are not zero") && ok;
+  }
+
+  // The block policy delivers every event, in order.
+  {
+    delivery_context context;
+    context.delay = std::chrono::milliseconds(2);
+    const async_delivery_counters counters =
+      run_monitor(context, async_overflow_policy::block, 4, event_count);
+
+    bool ordered = context.events.size() == event_count;
+    for (size_t i = 0; ordered && i < event_count; ++i)
+      ordered = context.events[i].get_path() == "/file" + std::to_string(i);
+
+    ok = expect(!context.delivered_by_producer, "the monitor thread invoked the callback") && ok;
+    ok = expect(ordered, "blocking delivery lost or reordered events") && ok;
+    ok = expect(counters.delivered == event_count, "wrong delivered counter") && ok;
+    ok = expect(counters.blocked > 0, "the monitor thread never blocked") && ok;
+    ok = expect(counters.dropped == 0 && counters.coalesced == 0,
+                "blocking delivery dropped or coalesced events") && ok;
+  }
+
+  // The drop oldest policy keeps the newest events.
+  {
+    delivery_context context;
+    context.hold = true;
+    const async_delivery_counters counters =
+      run_monitor(context, async_overflow_policy::drop_oldest, 4, event_count);
+
+    ok = expect(counters.dropped > 0, "no events were dropped") && ok;
+    ok = expect(counters.delivered + counters.dropped == event_count,
+                "dropped and delivered events do not add up") && ok;
+    ok = expect(context.events.size() == counters.delivered, "wrong delivered counter") && ok;
+    ok = expect(!context.events.empty() &&
+                  context.events.back().get_path() == "/file" + std::to_string(event_count - 1),
+                "the newest event was dropped") && ok;
+  }
+
+  // The coalesce policy merges the flags of the events of the same path.
+  {
+    constexpr size_t path_count = 4;
+    delivery_context context;
+    context.hold = true;
+    const async_delivery_counters counters =
+      run_monitor(context, async_overflow_policy::coalesce, 4, path_count);
+
+    ok = expect(counters.coalesced > 0, "no events were coalesced") && ok;
+    ok = expect(counters.delivered + counters.coalesced == event_count,
+                "coalesced and delivered events do not add up") && ok;
+    ok = expect(counters.blocked == 0 && counters.dropped == 0,
+                "coalescing delivery blocked or dropped events") && ok;
+
+    bool merged = false;
+    for (const auto& evt : context.events)
+    {
+      if (evt.get_flag_set() == event_flag_set{fsw_event_flag::Created,
+                                               fsw_event_flag::Updated})
+        merged = true;
+    }
+
+    ok = expect(merged, "flags were not merged") && ok;
+  }
+
+  // The coalesce policy holds aside at most as many paths as the capacity of
+  // the queue and reports an overflow when it drops events.
+  {
+    delivery_context context;
+    context.hold = true;
+    const async_delivery_counters counters =
+      run_monitor(context, async_overflow_policy::coalesce, 4, event_count);
+
+    size_t path_events = 0;
+    bool overflowed = false;
+
+    for (const auto& evt : context.events)
+    {
+      if (evt.get_flag_set() == event_flag_set{fsw_event_flag::Overflow})
+        overflowed = true;
+      else
+        ++path_events;
+    }
+
+    ok = expect(counters.dropped > 0, "the coalescing backlog dropped no events") && ok;
+    ok = expect(path_events + counters.coalesced + counters.dropped == event_count,
+                "coalesced, dropped and delivered events do not add up") && ok;
+    ok = expect(path_events <= 3 * 4, "the coalescing backlog is not bounded") && ok;
+    ok = expect(overflowed, "no overflow was reported") && ok;
+  }
+
+  // A failing callback stops the monitor and the error is rethrown by start().
+  {
+    producing_monitor mon(fail, nullptr, event_count);
+    mon.set_async_delivery(4, async_overflow_policy::block);
+
+    bool thrown = false;
+
+    try
+    {
+      mon.start();
+    }
+    catch (const libfsw_exception&)
+    {
+      thrown = true;
+    }
+
+    ok = expect(thrown, "callback error was not rethrown") && ok;
+    ok = expect(!mon.is_running(), "monitor is still running") && ok;
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <libfswatch/c/libfswatch.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  struct received_event
+  {
+    std::string path;
+    unsigned int flags;
+  };
+
+  struct callback_context
+  {
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<received_event> events;
+    const fsw_cevent_v3 *first_batch = nullptr;
+    unsigned int first_batch_size = 0;
+    unsigned int batches = 0;
+    bool batch_reallocated = false;
+    bool consistent = true;
+  };
+
+  void callback(fsw_cevent_v3 const *const events,
+                const unsigned int event_num,
+                void *data)
+  {
+    auto *context = static_cast<callback_context *>(data);
+
+    {
+      std::lock_guard<std::mutex> guard(context->mutex);
+
+      // Batches no larger than the first one must reuse its memory.
+      if (context->batches++ == 0)
+      {
+        context->first_batch = events;
+        context->first_batch_size = event_num;
+      }
+      else if (event_num <= context->first_batch_size &&
+               events != context->first_batch)
+      {
+        context->batch_reallocated = true;
+      }
+
+      for (unsigned int i = 0; i < event_num; ++i)
+      {
+        if (std::strlen(events[i].path) != events[i].path_length)
+          context->consistent = false;
+
+        // The poll monitor reports no event with a secondary path.
+        if (events[i].secondary_path != nullptr || events[i].secondary_path_length != 0)
+          context->consistent = false;
+
+        context->events.push_back({events[i].path, events[i].flags});
+      }
+    }
+
+    context->condition.notify_all();
+  }
+
+  bool expect_ok(FSW_STATUS status, const char *message)
+  {
+    if (status == FSW_OK) return true;
+
+    std::cerr << message << ": " << fsw_last_error() << "\n";
+    return false;
+  }
+
+  bool has_event(const callback_context& context,
+                 const std::string& needle,
+                 unsigned int flag)
+  {
+    for (const auto& evt : context.events)
+    {
+      if (evt.path.find(needle) != std::string::npos && (evt.flags & flag))
+        return true;
+    }
+
+    return false;
+  }
+}
+
+int main()
+{
+  namespace fs = std::filesystem;
+  using namespace std::chrono_literals;
+
+  if (!expect_ok(fsw_init_library(), "fsw_init_library failed")) return 1;
+
+  const fs::path test_dir =
+    fs::temp_directory_path() /
+    ("fswatch-callback-v3-" +
+     std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+  fs::create_directories(test_dir);
+
+  FSW_HANDLE handle = fsw_init_session(poll_monitor_type);
+  if (!handle)
+  {
+    std::cerr << "fsw_init_session failed\n";
+    fs::remove_all(test_dir);
+    return 1;
+  }
+
+  callback_context context;
+
+  bool ok =
+    expect_ok(fsw_add_path(handle, test_dir.string().c_str()), "fsw_add_path failed") &&
+    expect_ok(fsw_set_recursive(handle, true), "fsw_set_recursive failed") &&
+    expect_ok(fsw_set_callback_v3(handle, callback, &context), "fsw_set_callback_v3 failed") &&
+    expect_ok(fsw_set_latency(handle, 0.5), "fsw_set_latency failed");
+
+  ok = (fsw_set_callback_v3(handle, nullptr, nullptr) == FSW_ERR_INVALID_CALLBACK ||
+        (std::cerr << "null callback was accepted\n", false)) && ok;
+
+  if (!ok)
+  {
+    fsw_destroy_session(handle);
+    fs::remove_all(test_dir);
+    return 1;
+  }
+
+  auto monitor_status = std::async(std::launch::async, [handle] {
+    return fsw_start_monitor(handle);
+  });
+
+  std::this_thread::sleep_for(1s);
+
+  {
+    std::ofstream first(test_dir / "first.txt");
+    first << "first\n";
+  }
+
+  {
+    std::unique_lock<std::mutex> guard(context.mutex);
+    context.condition.wait_for(guard, 6s, [&context] {
+      return has_event(context, "/first.txt", Created);
+    });
+  }
+
+  {
+    std::ofstream second(test_dir / "second.txt");
+    second << "second\n";
+  }
+
+  {
+    std::unique_lock<std::mutex> guard(context.mutex);
+    context.condition.wait_for(guard, 6s, [&context] {
+      return has_event(context, "/second.txt", Created);
+    });
+  }
+
+  if (!expect_ok(fsw_stop_monitor(handle), "fsw_stop_monitor failed"))
+  {
+    std::quick_exit(1);
+  }
+
+  if (monitor_status.wait_for(3s) != std::future_status::ready)
+  {
+    std::cerr << "poll monitor did not stop promptly\n";
+    std::quick_exit(2);
+  }
+
+  ok = expect_ok(monitor_status.get(), "fsw_start_monitor failed") && ok;
+
+  {
+    std::lock_guard<std::mutex> guard(context.mutex);
+    ok = (has_event(context, "/first.txt", Created) ||
+          (std::cerr << "missing creation of first.txt\n", false)) && ok;
+    ok = (has_event(context, "/second.txt", Created) ||
+          (std::cerr << "missing creation of second.txt\n", false)) && ok;
+    ok = (context.consistent ||
+          (std::cerr << "inconsistent event paths\n", false)) && ok;
+    ok = (!context.batch_reallocated ||
+          (std::cerr << "event batch memory was not reused\n", false)) && ok;
+  }
+
+  ok = expect_ok(fsw_destroy_session(handle), "fsw_destroy_session failed") && ok;
+
+  fs::remove_all(test_dir);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libfswatch/c++/libfswatch_exception.hpp>
+#include <libfswatch/c++/monitor.hpp>
+
+using namespace fsw;
+using namespace std::chrono;
+
+namespace
+{
+  constexpr milliseconds window(50);
+  constexpr size_t path_count = 10;
+
+  const fsw_event_flag save_flags[] = {fsw_event_flag::Created,
+                                       fsw_event_flag::Updated,
+                                       fsw_event_flag::AttributeModified,
+                                       fsw_event_flag::CloseWrite,
+                                       fsw_event_flag::MovedTo};
+
+  bool expect(bool condition, const std::string& message)
+  {
+    if (condition) return true;
+
+    std::cerr << message << "\n";
+    return false;
+  }
+
+  struct delivery_context
+  {
+    std::mutex mutex;
+    std::vector<event> events;
+
+    size_t size()
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      return events.size();
+    }
+  };
+
+  void record_events(const std::vector<event>& events, void *data)
+  {
+    auto *context = static_cast<delivery_context *>(data);
+    std::lock_guard<std::mutex> guard(context->mutex);
+    context->events.insert(context->events.end(), events.begin(), events.end());
+  }
+
+  // Runs the specified scenario as its run loop.
+  class scripted_monitor : public monitor
+  {
+  public:
+    scripted_monitor(delivery_context& context,
+                     std::function<void(scripted_monitor&)> script) :
+      monitor({"/"}, record_events, &context), script(std::move(script))
+    {
+    }
+
+    // Notifies a burst of events, one batch per flag, as an editor saving
+    // the files would.
+    void save(size_t first_path, size_t last_path)
+    {
+      for (const fsw_event_flag flag : save_flags)
+      {
+        std::vector<event> batch;
+
+        for (size_t i = first_path; i < last_path; ++i)
+          batch.push_back({"/file" + std::to_string(i), 0, {flag}});
+
+        notify_events(std::move(batch));
+      }
+    }
+
+  protected:
+    void run() override
+    {
+      script(*this);
+    }
+
+  private:
+    std::function<void(scripted_monitor&)> script;
+  };
+
+  bool is_saved(const event& evt)
+  {
+    for (const fsw_event_flag flag : save_flags)
+    {
+      if (!evt.get_flag_set().contains(flag)) return false;
+    }
+
+    return true;
+  }
+}
+
+int main()
+{
+  bool ok = true;
+
+  // Bursts are merged across batches and notified once the path is quiet.
+  {
+    delivery_context context;
+    size_t during_burst = 0;
+    size_t after_burst = 0;
+
+    scripted_monitor mon(context, [&](scripted_monitor& m)
+    {
+      m.save(0, path_count);
+      during_burst = context.size();
+      std::this_thread::sleep_for(window * 4);
+      after_burst = context.size();
+
+      m.save(0, 1);
+      std::this_thread::sleep_for(window * 4);
+    });
+    mon.set_debounce(window);
+    mon.start();
+
+    ok = expect(during_burst == 0, "events were notified before the window elapsed") && ok;
+    ok = expect(after_burst == path_count, "burst was not merged into one event per path") && ok;
+    ok = expect(context.events.size() == path_count + 1, "wrong number of debounced events") && ok;
+
+    bool merged = true;
+    for (const auto& evt : context.events) merged = merged && is_saved(evt);
+    ok = expect(merged, "flags were not merged across batches") && ok;
+  }
+
+  // A path that keeps changing is not notified until it is quiet.
+  {
+    delivery_context context;
+    size_t while_busy = 0;
+
+    scripted_monitor mon(context, [&](scripted_monitor& m)
+    {
+      for (int i = 0; i < 12; ++i)
+      {
+        m.save(0, 1);
+        std::this_thread::sleep_for(window / 4);
+      }
+
+      while_busy = context.size();
+      std::this_thread::sleep_for(window * 4);
+    });
+    mon.set_debounce(window);
+    mon.start();
+
+    ok = expect(while_busy == 0, "a busy path was notified") && ok;
+    ok = expect(context.events.size() == 1, "a busy path was not notified once") && ok;
+  }
+
+  // Pending events are notified when the monitor stops, also through the
+  // asynchronous delivery.
+  {
+    delivery_context context;
+
+    scripted_monitor mon(context, [](scripted_monitor& m)
+    {
+      m.save(0, path_count);
+    });
+    mon.set_debounce(seconds(10));
+    mon.set_async_delivery(4);
+    mon.start();
+
+    ok = expect(context.events.size() == path_count, "pending events were lost") && ok;
+    ok = expect(mon.get_async_delivery_counters().delivered == path_count,
+                "debounced events did not go through the delivery thread") && ok;
+  }
+
+  // Idle events are not held for the window.
+  {
+    delivery_context context;
+    size_t idle_while_running = 0;
+
+    scripted_monitor mon(context, [&](scripted_monitor& m)
+    {
+      m.save(0, 1);
+      std::this_thread::sleep_for(milliseconds(500));
+
+      {
+        std::lock_guard<std::mutex> guard(context.mutex);
+        for (const auto& evt : context.events)
+        {
+          if (evt.get_flag_set().contains(fsw_event_flag::NoOp)) ++idle_while_running;
+        }
+      }
+
+      // The inactivity thread runs until the monitor is stopped.
+      m.stop();
+    });
+    mon.set_debounce(seconds(10));
+    mon.set_latency(0.1);
+    mon.set_fire_idle_event(true);
+    mon.start();
+
+    ok = expect(idle_while_running > 0, "idle events were debounced") && ok;
+    ok = expect(context.events.front().get_flag_set().contains(fsw_event_flag::NoOp) &&
+                  is_saved(context.events.back()),
+                "pending events were notified before the monitor stopped") && ok;
+  }
+
+  // Negative windows are rejected.
+  {
+    delivery_context context;
+    scripted_monitor mon(context, [](scripted_monitor&) {});
+    bool thrown = false;
+
+    try
+    {
+      mon.set_debounce(milliseconds(-1));
+    }
+    catch (const libfsw_exception&)
+    {
+      thrown = true;
+    }
+
+    ok = expect(thrown, "a negative window was accepted") && ok;
+  }
+
+  return ok ? 0 : 1;
+}
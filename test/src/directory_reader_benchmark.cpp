@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares the system calls and the time required to walk a directory tree
+ * and determine the type of each entry with std::filesystem and with
+ * fsw::directory_reader.  The std::filesystem walk lists
+ * each directory twice, the first time to count its entries, and queries the
+ * status of each entry by path.  The system calls are counted in a child
+ * process traced with ptrace(), and the times are measured without tracing.
+ *
+ * Usage: directory_reader_benchmark [entries] [iterations]
+ */
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include <libfswatch/c++/directory_reader.hpp>
+
+using namespace fsw;
+namespace fs = std::filesystem;
+
+namespace
+{
+  struct walk_result
+  {
+    size_t entries = 0;
+    size_t directories = 0;
+  };
+
+  // Creates a tree of count entries, half directories and half files.
+  void make_tree(const fs::path& root, size_t count)
+  {
+    std::vector<fs::path> directories{root};
+    fs::create_directories(root);
+
+    for (size_t i = 1; 2 * i <= count; ++i)
+    {
+      directories.push_back(directories[(i - 1) / 10] / ("module-" + std::to_string((i - 1) % 10)));
+      fs::create_directory(directories.back());
+      std::ofstream(directories.back() / "file.txt") << i << "\n";
+    }
+  }
+
+  void filesystem_walk(const fs::path& path, walk_result& result)
+  {
+    std::vector<fs::directory_entry> entries;
+    entries.reserve(std::distance(fs::directory_iterator(path), fs::directory_iterator{}));
+    for (const auto& entry : fs::directory_iterator(path)) entries.emplace_back(entry);
+
+    for (const auto& entry : entries)
+    {
+      ++result.entries;
+
+      const auto status = fs::symlink_status(entry.path());
+      if (!fs::is_directory(status)) continue;
+
+      ++result.directories;
+      filesystem_walk(entry.path(), result);
+    }
+  }
+
+  void reader_walk(const fs::path& path, walk_result& result)
+  {
+    directory_reader reader(path.string());
+    directory_entry_info entry;
+
+    while (reader.next(entry))
+    {
+      ++result.entries;
+      if (entry.type != entry_type::directory) continue;
+
+      ++result.directories;
+      reader_walk(path / entry.name, result);
+    }
+  }
+
+  // Counts the system calls performed by walk in a traced child process.
+  long count_syscalls(const std::function<void()>& walk)
+  {
+    const pid_t pid = fork();
+    if (pid == -1) return -1;
+
+    if (pid == 0)
+    {
+      if (ptrace(PTRACE_TRACEME, 0, nullptr, nullptr) == -1) _exit(1);
+      raise(SIGSTOP);
+      walk();
+      _exit(0);
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) == -1 || !WIFSTOPPED(status)) return -1;
+    ptrace(PTRACE_SETOPTIONS, pid, nullptr, reinterpret_cast<void *>(PTRACE_O_TRACESYSGOOD));
+
+    // Each system call stops the child on entry and on exit.
+    long stops = 0;
+
+    for (;;)
+    {
+      if (ptrace(PTRACE_SYSCALL, pid, nullptr, nullptr) == -1) return -1;
+      if (waitpid(pid, &status, 0) == -1) return -1;
+      if (WIFEXITED(status)) return WEXITSTATUS(status) == 0 ? stops / 2 : -1;
+      if (WIFSTOPPED(status) && WSTOPSIG(status) == (SIGTRAP | 0x80)) ++stops;
+    }
+  }
+
+  bool run_walk(const std::string& name,
+                const fs::path& root,
+                size_t iterations,
+                void (*walk)(const fs::path&, walk_result&),
+                walk_result& result)
+  {
+    const long syscalls = count_syscalls([&root, walk]
+                                         {
+                                           walk_result ignored;
+                                           walk(root, ignored);
+                                         });
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+      result = walk_result{};
+      walk(root, result);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    const double per_100k = 100000.0 / static_cast<double>(result.entries);
+
+    std::cout << name << " entries:\t" << result.entries << "\n";
+
+    if (syscalls == -1)
+      std::cout << name << " syscalls per 100k entries:\tunavailable\n";
+    else
+      std::cout << name << " syscalls per 100k entries:\t" << static_cast<double>(syscalls) * per_100k << "\n";
+
+    std::cout << name << " ms per 100k entries:\t"
+              << std::chrono::duration<double, std::milli>(elapsed).count() / iterations * per_100k << "\n";
+
+    return result.entries > 0;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+  const size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5;
+
+  if (count < 2 || iterations == 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " [entries] [iterations]\n";
+    return 1;
+  }
+
+  const fs::path root =
+    fs::temp_directory_path() /
+    ("fswatch-directory-reader-" +
+     std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+  make_tree(root, count);
+
+  walk_result filesystem_result;
+  walk_result reader_result;
+
+  bool ok = run_walk("std::filesystem", root, iterations, filesystem_walk, filesystem_result);
+  ok = run_walk("directory_reader", root, iterations, reader_walk, reader_result) && ok;
+  ok = ok &&
+       filesystem_result.entries == reader_result.entries &&
+       filesystem_result.directories == reader_result.directories;
+
+  fs::remove_all(root);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+#include <libfswatch/c++/directory_walker.hpp>
+
+using namespace fsw;
+namespace fs = std::filesystem;
+
+namespace
+{
+  constexpr int fanout = 6;
+  constexpr int depth = 4;
+
+  bool expect(bool condition, const std::string& message)
+  {
+    if (condition) return true;
+
+    std::cerr << message << "\n";
+    return false;
+  }
+
+  // Creates a tree of directories, each containing a file and a symbolic link.
+  size_t make_tree(const fs::path& root, int levels)
+  {
+    fs::create_directories(root);
+    std::ofstream(root / "file.txt") << "\n";
+    fs::create_symlink("file.txt", root / "link");
+
+    if (levels == 0) return 1;
+
+    size_t count = 1;
+    for (int i = 0; i < fanout; ++i)
+      count += make_tree(root / ("dir-" + std::to_string(i)), levels - 1);
+
+    return count;
+  }
+
+  struct walk_result
+  {
+    std::set<std::string> visited;
+    size_t roots = 0;
+    walk_statistics statistics;
+  };
+
+  // Visits the directories of the tree, skipping the subtrees named skip.
+  walk_result walk_tree(const fs::path& root,
+                        size_t threads,
+                        const std::string& skip = "",
+                        bool visit_files = false)
+  {
+    walk_result result;
+
+    directory_walker walker([&result, &skip](const fs::path& path, entry_type type, bool is_root)
+                            -> std::optional<fs::path>
+                            {
+                              if (is_root) ++result.roots;
+                              if (is_root != (type == entry_type::unknown))
+                                throw std::logic_error("wrong entry type");
+                              if (!result.visited.insert(path.string()).second)
+                                throw std::logic_error("path visited twice");
+                              if (!is_root && type != entry_type::directory) return std::nullopt;
+                              if (path.filename() == skip) return std::nullopt;
+
+                              return path;
+                            },
+                            threads,
+                            visit_files);
+
+    result.statistics = walker.walk(root);
+
+    return result;
+  }
+}
+
+int main()
+{
+  bool ok = true;
+
+  const fs::path root =
+    fs::temp_directory_path() /
+    ("fswatch-directory-walker-" +
+     std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+  const size_t directory_count = make_tree(root, depth);
+
+  // A serial walk visits every directory and symbolic link once, and not the
+  // other files.
+  const walk_result serial = walk_tree(root, 1);
+  ok = expect(serial.visited.size() == 2 * directory_count, "serial walk missed directories") && ok;
+  ok = expect(serial.roots == 1, "wrong number of roots") && ok;
+  ok = expect(serial.statistics.directories == directory_count &&
+                serial.statistics.threads == 1,
+              "wrong serial statistics") && ok;
+
+  // A parallel walk visits the same directories.
+  const walk_result parallel = walk_tree(root, 4);
+  ok = expect(parallel.visited == serial.visited, "parallel walk visited other directories") && ok;
+  ok = expect(parallel.statistics.threads > 1 && parallel.statistics.threads <= 4,
+              "wrong number of threads") && ok;
+
+  // Files are visited when requested.
+  const walk_result files = walk_tree(root, 4, "", true);
+  ok = expect(files.visited.size() == 3 * directory_count &&
+                files.statistics.directories == directory_count,
+              "files were not visited") && ok;
+
+  // Subtrees are not listed when the visit returns no directory.
+  const walk_result pruned = walk_tree(root, 4, "dir-0");
+  size_t pruned_count = 0;
+  for (const auto& path : serial.visited)
+  {
+    if (path.find("/dir-0/") != std::string::npos) ++pruned_count;
+  }
+
+  ok = expect(pruned.visited.size() == 2 * directory_count - pruned_count,
+              "pruned subtrees were walked") && ok;
+
+  // A directory without subdirectories is walked without starting threads.
+  const walk_result leaf = walk_tree(root / "dir-1" / "dir-1" / "dir-1" / "dir-1", 4);
+  ok = expect(leaf.visited.size() == 2 && leaf.statistics.threads == 1,
+              "walking a leaf started threads") && ok;
+
+  // Visit errors stop the walk and are rethrown.
+  bool thrown = false;
+
+  try
+  {
+    directory_walker failing([](const fs::path& path, entry_type, bool) -> std::optional<fs::path>
+                             {
+                               if (path.filename() == "dir-5") throw std::runtime_error("visit failure");
+                               return path;
+                             },
+                             4);
+    failing.walk(root);
+  }
+  catch (const std::runtime_error&)
+  {
+    thrown = true;
+  }
+
+  ok = expect(thrown, "visit error was not rethrown") && ok;
+
+  fs::remove_all(root);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares the throughput of the event bubbling performed by fsw::monitor with
+ * a reference implementation aggregating the flags of a batch in a std::map
+ * keyed on the event identity.
+ *
+ * Usage: event_bubbling_benchmark [batch size] [iterations]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <libfswatch/c++/event.hpp>
+#include <libfswatch/c++/monitor.hpp>
+
+using namespace fsw;
+using namespace std::chrono;
+
+namespace
+{
+  size_t delivered = 0;
+  bool keep_batch = false;
+  std::vector<event> last_batch;
+
+  void count_events(const std::vector<event>& events, void *)
+  {
+    delivered += events.size();
+    if (keep_batch) last_batch = events;
+  }
+
+  // Exposes the event notification of fsw::monitor.
+  class bubbling_monitor : public monitor
+  {
+  public:
+    bubbling_monitor() : monitor({"/"}, count_events)
+    {
+      set_bubble_events(true);
+    }
+
+    using monitor::notify_events;
+
+  protected:
+    void run() override
+    {
+    }
+  };
+
+  std::vector<event> legacy_bubble(const std::vector<event>& events)
+  {
+    using bubble_key =
+      std::tuple<time_t, std::string, unsigned long, process_id_kind, long long, int, bool>;
+
+    std::map<bubble_key, std::set<fsw_event_flag>> bubbled_events;
+
+    for (auto const& evt : events)
+    {
+      const auto& flags = evt.get_flag_set();
+      bubbled_events[{evt.get_time(),
+                      evt.get_path(),
+                      evt.get_correlation_id(),
+                      evt.get_process_id_kind(),
+                      evt.get_process_id(),
+                      evt.get_process_pidfd(),
+                      evt.has_process_pidfd()}].insert(flags.begin(), flags.end());
+    }
+
+    std::vector<event> bubbled;
+
+    for (const auto& [key, flags] : bubbled_events)
+    {
+      bubbled.emplace_back(std::get<1>(key),
+                           std::get<0>(key),
+                           std::vector<fsw_event_flag>(flags.begin(), flags.end()),
+                           std::get<2>(key));
+    }
+
+    return bubbled;
+  }
+
+  // Every path receives 4 events, interleaved as they are by a monitor
+  // observing several files being written at the same time.
+  std::vector<event> make_batch(size_t size)
+  {
+    const fsw_event_flag flags[] = {fsw_event_flag::Created,
+                                    fsw_event_flag::Updated,
+                                    fsw_event_flag::AttributeModified,
+                                    fsw_event_flag::CloseWrite};
+    const size_t path_count = size / 4 + 1;
+    std::vector<event> events;
+    events.reserve(size);
+
+    for (size_t i = 0; i < size; ++i)
+    {
+      events.emplace_back("/home/user/projects/module" + std::to_string(i % path_count % 97) +
+                          "/src/file" + std::to_string(i % path_count) + ".cpp",
+                          0,
+                          event_flag_set{flags[(i / path_count) % 4]});
+    }
+
+    return events;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const size_t batch_size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+  const size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10;
+
+  if (batch_size == 0 || iterations == 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " [batch size] [iterations]\n";
+    return 1;
+  }
+
+  const std::vector<event> batch = make_batch(batch_size);
+  bubbling_monitor mon;
+
+  size_t legacy_events = 0;
+  auto start = steady_clock::now();
+
+  for (size_t i = 0; i < iterations; ++i)
+  {
+    std::vector<event> events = batch;
+    legacy_events += legacy_bubble(events).size();
+  }
+
+  const double legacy_ms =
+    duration_cast<microseconds>(steady_clock::now() - start).count() / 1000.0;
+
+  start = steady_clock::now();
+
+  for (size_t i = 0; i < iterations; ++i)
+  {
+    std::vector<event> events = batch;
+    mon.notify_events(std::move(events));
+  }
+
+  const double hash_ms =
+    duration_cast<microseconds>(steady_clock::now() - start).count() / 1000.0;
+
+  if (legacy_events != delivered)
+  {
+    std::cerr << "Result mismatch: " << legacy_events << " != " << delivered << "\n";
+    return 1;
+  }
+
+  // Bubbled events are delivered in first-seen order with all their flags.
+  keep_batch = true;
+  mon.notify_events(std::vector<event>(batch));
+
+  const size_t path_count = batch_size / 4 + 1;
+  if (last_batch.size() != std::min(path_count, batch_size))
+  {
+    std::cerr << "Unexpected number of bubbled events: " << last_batch.size() << "\n";
+    return 1;
+  }
+
+  for (size_t i = 0; i < last_batch.size(); ++i)
+  {
+    size_t expected_flags = 0;
+    for (size_t j = i; j < batch_size; j += path_count) ++expected_flags;
+
+    if (last_batch[i].get_path() != batch[i].get_path() ||
+        last_batch[i].get_flag_set().size() != expected_flags)
+    {
+      std::cerr << "Unexpected bubbled event: " << last_batch[i].get_path() << "\n";
+      return 1;
+    }
+  }
+
+  const double events_processed = static_cast<double>(batch_size) * iterations;
+
+  std::cout << "batch size:\t" << batch_size << "\n"
+            << "bubbled events:\t" << last_batch.size() << "\n"
+            << "map ms/batch:\t" << legacy_ms / iterations << "\n"
+            << "hash ms/batch:\t" << hash_ms / iterations << "\n"
+            << "map events/s:\t" << events_processed / (legacy_ms / 1000.0) << "\n"
+            << "hash events/s:\t" << events_processed / (hash_ms / 1000.0) << "\n"
+            << "speedup:\t" << legacy_ms / hash_ms << "\n";
+
+  return 0;
+}
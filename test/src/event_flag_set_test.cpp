@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <libfswatch/c++/event.hpp>
+
+using namespace fsw;
+
+namespace
+{
+  bool expect(bool condition, const std::string& message)
+  {
+    if (condition) return true;
+
+    std::cerr << message << "\n";
+    return false;
+  }
+}
+
+int main()
+{
+  bool ok = true;
+
+  event_flag_set empty;
+  ok = expect(empty.empty() && empty.size() == 0, "default set is not empty") && ok;
+  ok = expect(empty.begin() == empty.end(), "empty set has flags") && ok;
+
+  // Flags are deduplicated and iterated in increasing order of their value.
+  const event_flag_set flags{fsw_event_flag::IsDir,
+                             fsw_event_flag::Created,
+                             fsw_event_flag::NoOp,
+                             fsw_event_flag::Created,
+                             fsw_event_flag::CloseWrite};
+  const std::vector<fsw_event_flag> expected = {fsw_event_flag::NoOp,
+                                                fsw_event_flag::Created,
+                                                fsw_event_flag::IsDir,
+                                                fsw_event_flag::CloseWrite};
+
+  ok = expect(flags.size() == expected.size(), "wrong set size") && ok;
+  ok = expect(flags.to_vector() == expected, "wrong iteration order") && ok;
+  ok = expect(flags.contains(fsw_event_flag::NoOp), "NoOp was lost") && ok;
+  ok = expect(!flags.contains(fsw_event_flag::Removed), "unexpected flag") && ok;
+
+  event_flag_set merged{fsw_event_flag::Updated};
+  merged |= flags;
+  ok = expect(merged.size() == 5 && merged.contains(fsw_event_flag::Updated),
+              "union lost flags") && ok;
+
+  merged.erase(fsw_event_flag::NoOp);
+  ok = expect(!merged.contains(fsw_event_flag::NoOp) && merged.size() == 4,
+              "erase failed") && ok;
+  ok = expect(event_flag_set::from_mask(merged.get_mask()) == merged,
+              "mask round trip failed") && ok;
+
+  // Events built from vectors keep exposing the legacy accessor.
+  const event evt("/tmp/a", 0, std::vector<fsw_event_flag>{fsw_event_flag::Removed,
+                                                           fsw_event_flag::IsFile});
+  ok = expect(evt.get_flags() == std::vector<fsw_event_flag>{fsw_event_flag::Removed,
+                                                             fsw_event_flag::IsFile},
+              "get_flags() returned the wrong flags") && ok;
+  ok = expect(evt.get_flag_set().get_mask() ==
+                (static_cast<int>(fsw_event_flag::Removed) |
+                 static_cast<int>(fsw_event_flag::IsFile)),
+              "get_flag_set() returned the wrong flags") && ok;
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares the startup time and the memory used by the fanotify monitor
+ * watching a large tree with inode marks and with a filesystem mark.  The tree
+ * is a synthetic tree with ten subdirectories per directory.
+ *
+ *   - The startup time is the time elapsed until the monitor reports the
+ *     changes of a file in the root of the tree, which is written
+ *     repeatedly: the events are only read once the watched trees are marked.
+ *
+ *   - The memory is the size of the heap blocks allocated by the monitor, and
+ *     the number of marks held by the kernel.
+ *
+ * Filesystem marks, and marks in excess of the limit of the user, require
+ * CAP_SYS_ADMIN: the benchmark is skipped if they cannot be added.
+ *
+ * Usage: fanotify_mark_scope_benchmark [directories]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libfswatch/c++/event.hpp>
+#include <libfswatch/c++/fanotify_monitor.hpp>
+#include <libfswatch/c++/libfswatch_exception.hpp>
+
+#include "allocation_counter.hpp"
+
+using namespace fsw;
+using namespace std::chrono;
+namespace fs = std::filesystem;
+
+namespace
+{
+  constexpr int SKIPPED = 77;
+
+  struct result
+  {
+    double startup_ms = 0;
+    long long heap_bytes = 0;
+    size_t marks = 0;
+  };
+
+  void make_tree(const fs::path& root, size_t count)
+  {
+    std::vector<fs::path> directories{root};
+    directories.reserve(count);
+    fs::create_directories(root);
+
+    for (size_t i = 1; i < count; ++i)
+    {
+      directories.push_back(directories[(i - 1) / 10] / ("module-" + std::to_string((i - 1) % 10)));
+      fs::create_directory(directories.back());
+    }
+  }
+
+  // Counts the marks of the fanotify groups of this process, which are listed
+  // in the information of their descriptors.
+  size_t count_marks()
+  {
+    size_t marks = 0;
+
+    for (const auto& entry : fs::directory_iterator("/proc/self/fdinfo"))
+    {
+      std::ifstream info(entry.path());
+      std::string line;
+
+      while (std::getline(info, line))
+      {
+        if (line.rfind("fanotify ", 0) == 0 && line.rfind("fanotify flags:", 0) != 0) ++marks;
+      }
+    }
+
+    return marks;
+  }
+
+  void callback(const std::vector<event>& events, void *context)
+  {
+    auto *probe = static_cast<std::pair<std::string, std::atomic<bool>> *>(context);
+
+    for (const auto& evt : events)
+    {
+      if (evt.get_path() == probe->first) probe->second = true;
+    }
+  }
+
+  bool run_monitor(const fs::path& root, const char *scope, result& measured)
+  {
+    using namespace std::chrono_literals;
+
+    std::pair<std::string, std::atomic<bool>> probe{(root / "probe.txt").string(), false};
+    std::atomic<bool> failed{false};
+    const long long heap_before = allocation_counter::bytes;
+    const auto start = steady_clock::now();
+
+    fanotify_monitor monitor({root.string()}, callback, &probe);
+    monitor.set_recursive(true);
+    monitor.set_latency(0.01);
+    monitor.set_property(fanotify_monitor::MARK_SCOPE_PROPERTY, scope);
+    monitor.set_property(fanotify_monitor::UNLIMITED_MARKS_PROPERTY, "true");
+
+    std::thread runner([&monitor, &failed, scope] {
+      try
+      {
+        monitor.start();
+      }
+      catch (const libfsw_exception& ex)
+      {
+        std::cerr << scope << ": " << ex.what() << "\n";
+        failed = true;
+      }
+    });
+
+    while (!probe.second && !failed)
+    {
+      std::ofstream(probe.first) << "probe\n";
+      std::this_thread::sleep_for(1ms);
+    }
+
+    measured.startup_ms = duration<double, std::milli>(steady_clock::now() - start).count();
+    measured.heap_bytes = allocation_counter::bytes - heap_before;
+    measured.marks = count_marks();
+
+    monitor.stop();
+    runner.join();
+
+    return !failed;
+  }
+
+  void print_result(size_t count, const char *scope, const result& measured)
+  {
+    std::cout << count << " " << scope << " startup ms:\t" << measured.startup_ms << "\n"
+              << count << " " << scope << " heap bytes:\t" << measured.heap_bytes << "\n"
+              << count << " " << scope << " kernel marks:\t" << measured.marks << "\n";
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500000;
+
+  if (count == 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " [directories]\n";
+    return 1;
+  }
+
+  const fs::path root =
+    fs::canonical(fs::temp_directory_path()) /
+    ("fswatch-fanotify-mark-scope-benchmark-" +
+     std::to_string(steady_clock::now().time_since_epoch().count()));
+
+  make_tree(root, count);
+  allocation_counter::counting = true;
+
+  // The filesystem mark is measured first, since it fails without privileges.
+  result filesystem;
+  result inode;
+  const bool marked = run_monitor(root, "filesystem", filesystem) &&
+                      run_monitor(root, "inode", inode);
+
+  fs::remove_all(root);
+
+  if (!marked)
+  {
+    std::cerr << "fanotify filesystem marks are unavailable in this environment.\n";
+    return SKIPPED;
+  }
+
+  print_result(count, "inode", inode);
+  print_result(count, "filesystem", filesystem);
+  std::cout << count << " inode/filesystem startup ratio:\t"
+            << inode.startup_ms / filesystem.startup_ms << "\n";
+
+  return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares the cost of looking up the directory of a fanotify event by a key
+ * built concatenating the filesystem ID and the file handle into a
+ * std::string with the cost of looking it up by a fsw::file_handle_key in a
+ * fsw::file_handle_table.  The handles are
+ * synthetic 8 bytes handles made of an inode number and a generation, as those
+ * of ext4 and XFS.  The lookups are counted in nanoseconds and in heap
+ * allocations.
+ *
+ * Usage: file_handle_lookup_benchmark [directories] [lookups]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <libfswatch/c++/file_handle_key.hpp>
+#include <libfswatch/c++/file_handle_table.hpp>
+
+#include "allocation_counter.hpp"
+
+using namespace fsw;
+using namespace std::chrono;
+
+namespace
+{
+  constexpr int HANDLE_TYPE = 1;
+  constexpr std::uint64_t FSID = 0x2a2a2a2a00000001;
+
+  struct handle
+  {
+    std::uint32_t handle_bytes;
+    std::int32_t handle_type;
+    std::uint32_t f_handle[2];
+  };
+
+  std::string make_string_key(const handle& h)
+  {
+    std::string key(reinterpret_cast<const char *>(&FSID), sizeof(FSID));
+    key.append(reinterpret_cast<const char *>(&h.handle_type), sizeof(h.handle_type));
+    key.append(reinterpret_cast<const char *>(&h.handle_bytes), sizeof(h.handle_bytes));
+    key.append(reinterpret_cast<const char *>(h.f_handle), h.handle_bytes);
+
+    return key;
+  }
+
+  file_handle_key make_key(const handle& h)
+  {
+    return file_handle_key(&FSID, sizeof(FSID), h.handle_type, h.f_handle, h.handle_bytes);
+  }
+
+  struct result
+  {
+    double ns_per_lookup;
+    double allocations_per_lookup;
+  };
+
+  // Looks up the handles of the events, summing the values found so that the
+  // lookups are not optimized away.
+  template<typename F>
+  result measure(const std::vector<handle>& events, size_t& sum, F lookup)
+  {
+    allocation_counter::allocations = 0;
+    allocation_counter::counting = true;
+    const auto start = steady_clock::now();
+
+    for (const auto& event : events) sum += lookup(event);
+
+    const auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start);
+    allocation_counter::counting = false;
+    const size_t allocated = allocation_counter::allocations;
+
+    return {static_cast<double>(elapsed.count()) / events.size(),
+            static_cast<double>(allocated) / events.size()};
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+  const size_t lookups = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000000;
+
+  if (count == 0 || lookups == 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " [directories] [lookups]\n";
+    return 1;
+  }
+
+  std::vector<handle> directories(count);
+  std::unordered_map<std::string, size_t> string_map;
+  file_handle_table<size_t> table;
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    directories[i] = {8, HANDLE_TYPE, {static_cast<std::uint32_t>(i + 2), 0x5eed}};
+    string_map.emplace(make_string_key(directories[i]), i);
+    table.insert_or_assign(make_key(directories[i]), i);
+  }
+
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<size_t> distribution(0, count - 1);
+  std::vector<handle> events(lookups);
+  for (auto& event : events) event = directories[distribution(generator)];
+
+  size_t string_sum = 0;
+  size_t table_sum = 0;
+
+  const result string_result = measure(
+    events, string_sum,
+    [&string_map](const handle& h) { return string_map.find(make_string_key(h))->second; });
+  const result table_result = measure(
+    events, table_sum,
+    [&table](const handle& h) { return *table.find(make_key(h)); });
+
+  if (string_sum != table_sum)
+  {
+    std::cerr << "Result mismatch: " << string_sum << " != " << table_sum << "\n";
+    return 1;
+  }
+
+  std::cout << count << " string key ns/lookup:\t" << string_result.ns_per_lookup << "\n"
+            << count << " string key allocations/lookup:\t" << string_result.allocations_per_lookup << "\n"
+            << count << " handle key ns/lookup:\t" << table_result.ns_per_lookup << "\n"
+            << count << " handle key allocations/lookup:\t" << table_result.allocations_per_lookup << "\n";
+
+  return table_result.allocations_per_lookup == 0 ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <libfswatch/c++/file_handle_key.hpp>
+#include <libfswatch/c++/file_handle_table.hpp>
+
+using namespace fsw;
+
+namespace
+{
+  constexpr size_t KEY_COUNT = 10000;
+
+  bool expect(bool condition, const std::string& message)
+  {
+    if (condition) return true;
+
+    std::cerr << message << "\n";
+    return false;
+  }
+
+  // Builds the key of a handle made of an inode number and a generation, as
+  // the handles of most local filesystems.
+  file_handle_key make_key(std::uint64_t inode, std::uint64_t fsid = 1, int type = 1)
+  {
+    const std::uint32_t handle[] = {static_cast<std::uint32_t>(inode), 7};
+    return file_handle_key(&fsid, sizeof(fsid), type, handle, sizeof(handle));
+  }
+
+  file_handle_key make_long_key(std::uint64_t inode)
+  {
+    std::vector<unsigned char> handle(file_handle_key::INLINE_SIZE + 16, 0xab);
+    handle[0] = static_cast<unsigned char>(inode);
+    const std::uint64_t fsid = 1;
+
+    return file_handle_key(&fsid, sizeof(fsid), 1, handle.data(), handle.size());
+  }
+}
+
+int main()
+{
+  bool ok = true;
+
+  // Keys are equal if their filesystem, type and bytes are equal.
+  ok = expect(make_key(1) == make_key(1) && make_key(1).hash() == make_key(1).hash(),
+              "equal keys differ") && ok;
+  ok = expect(make_key(1) != make_key(2), "keys of different handles are equal") && ok;
+  ok = expect(make_key(1, 1) != make_key(1, 2), "keys of different filesystems are equal") && ok;
+  ok = expect(make_key(1, 1, 1) != make_key(1, 1, 2), "keys of different types are equal") && ok;
+  ok = expect(make_key(1).to_string() == make_key(1).to_string() &&
+              make_key(1).to_string() != make_key(2).to_string(),
+              "wrong binary representation") && ok;
+  ok = expect(file_handle_key().empty() && !make_key(1).empty(), "wrong empty key") && ok;
+  ok = expect(make_key(1, 42).get_fsid() == 42, "wrong filesystem ID") && ok;
+
+  // Long handles are copied and moved with their bytes.
+  file_handle_key long_key = make_long_key(1);
+  file_handle_key copied = long_key;
+  ok = expect(copied == long_key && copied != make_long_key(2), "long key was not copied") && ok;
+  file_handle_key moved = std::move(copied);
+  ok = expect(moved == long_key && copied.empty(), "long key was not moved") && ok;
+  moved = make_key(3);
+  ok = expect(moved == make_key(3), "key was not assigned") && ok;
+
+  file_handle_table<size_t> table;
+  ok = expect(table.empty() && table.find(make_key(1)) == nullptr, "empty table found a key") && ok;
+  ok = expect(table.find(file_handle_key()) == nullptr, "empty key was found") && ok;
+
+  for (size_t i = 0; i < KEY_COUNT; ++i) table.insert_or_assign(make_key(i), i);
+  table.insert_or_assign(make_long_key(1), KEY_COUNT);
+  ok = expect(table.size() == KEY_COUNT + 1, "wrong number of keys") && ok;
+
+  // Inserting a key again replaces its value.
+  table.insert_or_assign(make_key(0), KEY_COUNT + 1);
+  ok = expect(table.size() == KEY_COUNT + 1 && *table.find(make_key(0)) == KEY_COUNT + 1,
+              "value was not replaced") && ok;
+  table.insert_or_assign(make_key(0), 0);
+
+  // Removing keys moves back the keys following them in their probe
+  // sequence, which must still be found.
+  for (size_t i = 0; i < KEY_COUNT; i += 2) ok = expect(table.erase(make_key(i)), "key was not erased") && ok;
+  ok = expect(!table.erase(make_key(0)), "missing key was erased") && ok;
+  ok = expect(table.size() == KEY_COUNT / 2 + 1, "wrong number of keys after erasing") && ok;
+
+  bool found = true;
+  for (size_t i = 0; i < KEY_COUNT; ++i)
+  {
+    const size_t *value = table.find(make_key(i));
+    found = found && (i % 2 == 0 ? value == nullptr : value != nullptr && *value == i);
+  }
+
+  ok = expect(found, "wrong keys found after erasing") && ok;
+  ok = expect(table.contains(make_long_key(1)) && !table.contains(make_long_key(2)),
+              "long key was not found") && ok;
+
+  table.clear();
+  ok = expect(table.empty() && !table.contains(make_key(1)), "table was not cleared") && ok;
+  table.insert_or_assign(make_key(1), 1);
+  ok = expect(table.size() == 1 && *table.find(make_key(1)) == 1, "cleared table is not usable") && ok;
+
+  return ok ? 0 : 1;
+}
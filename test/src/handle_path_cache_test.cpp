@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <libfswatch/c++/handle_path_cache.hpp>
+
+using namespace fsw;
+
+namespace
+{
+  bool expect(bool condition, const std::string& message)
+  {
+    if (condition) return true;
+
+    std::cerr << message << "\n";
+    return false;
+  }
+
+  // Builds the key of a synthetic handle named after a string.
+  file_handle_key make_key(const std::string& name)
+  {
+    const std::uint64_t fsid = 42;
+    return file_handle_key(&fsid, sizeof(fsid), 1, name.data(), name.size());
+  }
+
+  bool has_path(handle_path_cache& cache, const std::string& key, const std::string& path)
+  {
+    const std::string *cached = cache.find(make_key(key));
+    return cached != nullptr && *cached == path;
+  }
+}
+
+int main()
+{
+  bool ok = true;
+
+  handle_path_cache cache(3);
+  cache.insert(make_key("a"), "/root/a");
+  cache.insert(make_key("b"), "/root/b");
+  cache.insert(make_key("c"), "/root/c");
+  ok = expect(cache.size() == 3 && has_path(cache, "b", "/root/b"), "paths were not cached") && ok;
+  ok = expect(cache.find(make_key("d")) == nullptr, "unknown key was found") && ok;
+
+  // The least recently used path is evicted: a was inserted first, but b and
+  // then a were used more recently than c.
+  ok = expect(has_path(cache, "a", "/root/a"), "path was not cached") && ok;
+  cache.insert(make_key("d"), "/root/d");
+  ok = expect(cache.size() == 3, "cache exceeded its capacity") && ok;
+  ok = expect(cache.find(make_key("c")) == nullptr, "least recently used path was not evicted") && ok;
+  ok = expect(has_path(cache, "a", "/root/a") && has_path(cache, "b", "/root/b") &&
+              has_path(cache, "d", "/root/d"),
+              "recently used path was evicted") && ok;
+
+  // Inserting a key again replaces its path.
+  cache.insert(make_key("a"), "/root/moved");
+  ok = expect(cache.size() == 3 && has_path(cache, "a", "/root/moved"), "path was not replaced") && ok;
+
+  cache.erase(make_key("a"));
+  ok = expect(cache.size() == 2 && cache.find(make_key("a")) == nullptr, "path was not erased") && ok;
+
+  // The paths of a moved directory and of its descendants are erased, but not
+  // those of its siblings sharing a prefix.
+  cache.clear();
+  cache.set_capacity(10);
+  cache.insert(make_key("tree"), "/root/tree");
+  cache.insert(make_key("child"), "/root/tree/child");
+  cache.insert(make_key("grandchild"), "/root/tree/child/grandchild");
+  cache.insert(make_key("sibling"), "/root/tree-sibling");
+  cache.erase_tree("/root/tree");
+  ok = expect(cache.size() == 1 && has_path(cache, "sibling", "/root/tree-sibling"),
+              "wrong paths were erased with a tree") && ok;
+
+  cache.insert(make_key("child"), "/child");
+  cache.erase_tree("/");
+  ok = expect(cache.size() == 0, "paths were not erased with the root") && ok;
+
+  // A directory whose path is replaced is erased with the tree of its new path
+  // only, and stale keys sharing a path are erased together.
+  cache.insert(make_key("a"), "/x/a");
+  cache.insert(make_key("a"), "/y/a");
+  cache.insert(make_key("stale"), "/y/a");
+  cache.erase_tree("/x");
+  ok = expect(cache.size() == 2, "tree of a former path was erased") && ok;
+  cache.erase_tree("/y");
+  ok = expect(cache.size() == 0, "tree of a replaced path was not erased") && ok;
+
+  // The deletion of a deep tree from a full cache is reported bottom up, one
+  // directory at a time, and erases the paths of that tree only.  The other
+  // paths share a prefix with the tree, and sort right before and right after
+  // its descendants.
+  const size_t depth = 1000;
+  handle_path_cache full;
+  std::vector<std::string> tree{"/deep"};
+
+  for (size_t i = 1; i <= depth; ++i) tree.push_back(tree.back() + "/d");
+  for (size_t i = 0; i < tree.size(); ++i) full.insert(make_key("tree" + std::to_string(i)), tree[i]);
+
+  for (size_t i = 0; full.size() < full.capacity(); ++i)
+  {
+    const std::string name = std::to_string(i);
+    full.insert(make_key("other" + name), ((i % 2) ? "/deep-other/" : "/deep0/") + name);
+  }
+
+  bool erased_one = true;
+
+  for (size_t i = tree.size(); i > 0; --i)
+  {
+    const size_t size = full.size();
+    full.erase_tree(tree[i - 1]);
+    erased_one = erased_one && full.size() == size - 1 &&
+                 full.find(make_key("tree" + std::to_string(i - 1))) == nullptr;
+  }
+
+  ok = expect(erased_one, "deleted directory was not erased alone") && ok;
+  ok = expect(full.size() == full.capacity() - tree.size() &&
+              has_path(full, "other0", "/deep0/0") && has_path(full, "other1", "/deep-other/1"),
+              "paths outside a deleted tree were erased") && ok;
+
+  // A deleted tree is erased at once with its root.
+  for (size_t i = 0; i < tree.size(); ++i) full.insert(make_key("tree" + std::to_string(i)), tree[i]);
+  full.erase_tree("/deep");
+  ok = expect(full.size() == full.capacity() - tree.size(), "deleted tree was not erased") && ok;
+
+  // Reducing the capacity evicts the least recently used paths.
+  for (const char *key : {"1", "2", "3", "4"}) cache.insert(make_key(key), std::string("/") + key);
+  cache.set_capacity(2);
+  ok = expect(cache.size() == 2 && has_path(cache, "3", "/3") && has_path(cache, "4", "/4"),
+              "wrong paths were evicted") && ok;
+
+  // A cache without capacity keeps no path.
+  handle_path_cache disabled(0);
+  disabled.insert(make_key("a"), "/root/a");
+  ok = expect(disabled.size() == 0 && disabled.find(make_key("a")) == nullptr,
+              "disabled cache kept a path") && ok;
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Measures the number of heap allocations performed by the inotify monitor per
+ * delivered event while a burst of files is created.  Allocations performed by
+ * the thread creating the files are not counted.
+ *
+ * Usage: inotify_event_allocation_benchmark [files]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <libfswatch/c++/event.hpp>
+#include <libfswatch/c++/monitor.hpp>
+#include <libfswatch/c++/monitor_factory.hpp>
+
+#include "allocation_counter.hpp"
+
+using namespace allocation_counter;
+
+namespace
+{
+  std::atomic<unsigned long> events_received{0};
+
+  void callback(const std::vector<fsw::event>& events, void *)
+  {
+    events_received += events.size();
+  }
+}
+
+int main(int argc, char **argv)
+{
+  namespace fs = std::filesystem;
+  using namespace std::chrono_literals;
+
+  const unsigned long file_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000;
+  excluded_thread = true;
+
+  const fs::path test_dir =
+    fs::temp_directory_path() /
+    ("fswatch-inotify-allocations-" +
+     std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+  fs::create_directory(test_dir);
+
+  std::unique_ptr<fsw::monitor> monitor(
+    fsw::monitor_factory::create_monitor(fsw_monitor_type::inotify_monitor_type,
+                                         {test_dir.string()},
+                                         callback));
+  monitor->set_latency(0.1);
+
+  std::thread runner([&monitor] { monitor->start(); });
+  std::this_thread::sleep_for(500ms);
+
+  counting = true;
+
+  for (unsigned long i = 0; i < file_count; ++i)
+  {
+    const std::string path = (test_dir / ("burst-" + std::to_string(i))).string();
+    const int fd = open(path.c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+    if (fd != -1) close(fd);
+  }
+
+  // Each file generates IN_CREATE and IN_CLOSE_WRITE.
+  const auto deadline = std::chrono::steady_clock::now() + 20s;
+  while (events_received < 2 * file_count &&
+         std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(50ms);
+
+  counting = false;
+
+  monitor->stop();
+  runner.join();
+  fs::remove_all(test_dir);
+
+  const unsigned long received = events_received;
+
+  if (received == 0)
+  {
+    std::cerr << "No events were received.\n";
+    return 1;
+  }
+
+  std::cout << "files:\t" << file_count << "\n"
+            << "events:\t" << received << "\n"
+            << "allocations:\t" << allocations << "\n"
+            << "allocations/event:\t"
+            << static_cast<double>(allocations) / received << "\n";
+
+  return 0;
+}
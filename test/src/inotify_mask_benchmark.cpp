@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Measures the queue overflows caused by a write-heavy workload in a directory
+ * watched by the inotify monitor, with and without event type filters.  The
+ * monitor is blocked in its callback while files are written, so that the
+ * kernel queues the events until it is released: the events of kinds that are
+ * not requested must not be queued at all.  The files are written round
+ * robin, since identical consecutive events are coalesced by the kernel.
+ *
+ * Usage: inotify_mask_benchmark [writes]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <libfswatch/c/libfswatch.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  constexpr size_t FILE_COUNT = 16;
+
+  struct event_log
+  {
+    std::mutex mutex;
+    size_t events = 0;
+    size_t overflows = 0;
+    std::chrono::steady_clock::time_point last_event;
+    std::atomic<bool> blocked{false};
+    std::shared_future<void> release;
+  };
+
+  void callback(fsw_cevent const *const events, const unsigned int event_num, void *data)
+  {
+    auto *log = static_cast<event_log *>(data);
+
+    // The first batch blocks the monitor until the workload is completed.
+    if (!log->blocked.exchange(true)) log->release.wait();
+
+    std::lock_guard<std::mutex> guard(log->mutex);
+    log->events += event_num;
+    log->last_event = std::chrono::steady_clock::now();
+
+    for (unsigned int i = 0; i < event_num; ++i)
+    {
+      for (unsigned int j = 0; j < events[i].flags_num; ++j)
+      {
+        if (events[i].flags[j] == Overflow) ++log->overflows;
+      }
+    }
+  }
+
+  bool expect_ok(FSW_STATUS status, const char *message)
+  {
+    if (status == FSW_OK) return true;
+
+    std::cerr << message << ": " << fsw_last_error() << "\n";
+    return false;
+  }
+
+  bool run_workload(const std::string& name,
+                    const std::vector<fsw_event_flag>& event_types,
+                    size_t writes,
+                    event_log& log)
+  {
+    using namespace std::chrono_literals;
+
+    const fs::path test_dir =
+      fs::temp_directory_path() /
+      ("fswatch-inotify-mask-" +
+       std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    fs::create_directory(test_dir);
+
+    std::promise<void> release;
+    log.release = release.get_future().share();
+
+    FSW_HANDLE handle = fsw_init_session(inotify_monitor_type);
+    bool ok = handle != nullptr &&
+              expect_ok(fsw_add_path(handle, test_dir.string().c_str()), "fsw_add_path failed") &&
+              expect_ok(fsw_set_allow_overflow(handle, true), "fsw_set_allow_overflow failed") &&
+              expect_ok(fsw_set_latency(handle, 0.1), "fsw_set_latency failed") &&
+              expect_ok(fsw_set_callback(handle, callback, &log), "fsw_set_callback failed");
+
+    for (const fsw_event_flag type : event_types)
+    {
+      if (!ok) break;
+      ok = expect_ok(fsw_add_event_type_filter(handle, {type}), "fsw_add_event_type_filter failed");
+    }
+
+    if (!ok)
+    {
+      if (handle) fsw_destroy_session(handle);
+      fs::remove_all(test_dir);
+      return false;
+    }
+
+    auto monitor_status = std::async(std::launch::async, [handle] {
+      return fsw_start_monitor(handle);
+    });
+
+    std::this_thread::sleep_for(500ms);
+
+    // Block the monitor with the creation of the files.
+    std::vector<int> files;
+    for (size_t i = 0; i < FILE_COUNT; ++i)
+    {
+      const fs::path path = test_dir / ("file-" + std::to_string(i) + ".txt");
+      files.push_back(open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644));
+    }
+
+    const auto block_started = std::chrono::steady_clock::now();
+    while (!log.blocked && std::chrono::steady_clock::now() - block_started < 5s)
+      std::this_thread::sleep_for(10ms);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < writes; ++i)
+    {
+      if (write(files[i % FILE_COUNT], "x", 1) != 1) ok = false;
+    }
+    const auto written = std::chrono::steady_clock::now();
+
+    for (const int fd : files) close(fd);
+    release.set_value();
+
+    // Wait until the events stop.
+    for (;;)
+    {
+      std::this_thread::sleep_for(200ms);
+
+      std::lock_guard<std::mutex> guard(log.mutex);
+      if (std::chrono::steady_clock::now() - log.last_event > 1s) break;
+    }
+
+    ok = expect_ok(fsw_stop_monitor(handle), "fsw_stop_monitor failed") && ok;
+    ok = expect_ok(monitor_status.get(), "fsw_start_monitor failed") && ok;
+    fsw_destroy_session(handle);
+    fs::remove_all(test_dir);
+
+    std::cout << name << " writes ms:\t"
+              << std::chrono::duration<double, std::milli>(written - start).count() << "\n"
+              << name << " events:\t" << log.events << "\n"
+              << name << " overflows:\t" << log.overflows << "\n";
+
+    return ok;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const size_t writes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+  if (writes == 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " [writes]\n";
+    return 1;
+  }
+
+  if (!expect_ok(fsw_init_library(), "fsw_init_library failed")) return 1;
+
+  event_log all_events;
+  event_log created_removed;
+
+  bool ok = run_workload("all events", {}, writes, all_events);
+  ok = run_workload("created/removed", {Created, Removed, Overflow}, writes, created_removed) && ok;
+
+  // The writes must not fill the queue when only creations and removals are
+  // requested.  Overflows are requested as well, since they would be filtered
+  // out otherwise.
+  return ok && created_removed.overflows == 0 ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Overflows the queue of the inotify monitor while it is blocked in its
+ * callback, changes the watched directory once the queue is full, and checks
+ * that the changes whose events were dropped by the kernel are recovered from
+ * the snapshot of the directory.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <libfswatch/c/libfswatch.h>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  constexpr size_t FILE_COUNT = 16;
+  constexpr size_t WRITE_COUNT = 40000;
+
+  struct event_log
+  {
+    std::mutex mutex;
+    std::set<std::pair<std::string, fsw_event_flag>> events;
+    std::chrono::steady_clock::time_point last_event;
+    std::atomic<bool> blocked{false};
+    std::shared_future<void> release;
+  };
+
+  void callback(fsw_cevent const *const events, const unsigned int event_num, void *data)
+  {
+    auto *log = static_cast<event_log *>(data);
+
+    // The first batch blocks the monitor until the queue is overflown.
+    if (!log->blocked.exchange(true)) log->release.wait();
+
+    std::lock_guard<std::mutex> guard(log->mutex);
+    log->last_event = std::chrono::steady_clock::now();
+
+    for (unsigned int i = 0; i < event_num; ++i)
+    {
+      for (unsigned int j = 0; j < events[i].flags_num; ++j)
+        log->events.emplace(events[i].path, events[i].flags[j]);
+    }
+  }
+
+  bool expect_ok(FSW_STATUS status, const char *message)
+  {
+    if (status == FSW_OK) return true;
+
+    std::cerr << message << ": " << fsw_last_error() << "\n";
+    return false;
+  }
+
+  bool expect_event(event_log& log, const fs::path& path, fsw_event_flag flag, const char *message)
+  {
+    std::lock_guard<std::mutex> guard(log.mutex);
+    if (log.events.find({path.string(), flag}) != log.events.end()) return true;
+
+    std::cerr << message << ": " << path.string() << "\n";
+    return false;
+  }
+
+  bool expect_overflow(event_log& log)
+  {
+    std::lock_guard<std::mutex> guard(log.mutex);
+    for (const auto& [path, flag] : log.events)
+    {
+      if (flag == Overflow) return true;
+    }
+
+    std::cerr << "overflow was not reported\n";
+    return false;
+  }
+}
+
+int main()
+{
+  using namespace std::chrono_literals;
+
+  if (!expect_ok(fsw_init_library(), "fsw_init_library failed")) return 1;
+
+  const fs::path test_dir =
+    fs::canonical(fs::temp_directory_path()) /
+    ("fswatch-inotify-overflow-recovery-" +
+     std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+  fs::create_directory(test_dir);
+
+  std::ofstream(test_dir / "removed.txt") << "removed\n";
+  std::ofstream(test_dir / "updated.txt") << "updated\n";
+
+  std::vector<int> files;
+  for (size_t i = 0; i < FILE_COUNT; ++i)
+  {
+    const fs::path path = test_dir / ("file-" + std::to_string(i) + ".txt");
+    files.push_back(open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644));
+  }
+
+  event_log log;
+  std::promise<void> release;
+  log.release = release.get_future().share();
+
+  FSW_HANDLE handle = fsw_init_session(inotify_monitor_type);
+  bool ok = handle != nullptr &&
+            expect_ok(fsw_add_path(handle, test_dir.string().c_str()), "fsw_add_path failed") &&
+            expect_ok(fsw_add_property(handle, "inotify.overflow-recovery", "5000"),
+                      "fsw_add_property failed") &&
+            expect_ok(fsw_set_allow_overflow(handle, true), "fsw_set_allow_overflow failed") &&
+            expect_ok(fsw_set_latency(handle, 0.1), "fsw_set_latency failed") &&
+            expect_ok(fsw_set_callback(handle, callback, &log), "fsw_set_callback failed");
+
+  if (!ok)
+  {
+    for (const int fd : files) close(fd);
+    if (handle) fsw_destroy_session(handle);
+    fs::remove_all(test_dir);
+    return 1;
+  }
+
+  auto monitor_status = std::async(std::launch::async, [handle] {
+    return fsw_start_monitor(handle);
+  });
+
+  std::this_thread::sleep_for(500ms);
+
+  // Block the monitor with a first event.
+  std::ofstream(test_dir / "blocker.txt") << "blocker\n";
+
+  const auto block_started = std::chrono::steady_clock::now();
+  while (!log.blocked && std::chrono::steady_clock::now() - block_started < 5s)
+    std::this_thread::sleep_for(10ms);
+
+  // Fill the queue, writing the files round robin since identical consecutive
+  // events are coalesced by the kernel.
+  for (size_t i = 0; i < WRITE_COUNT; ++i)
+  {
+    if (write(files[i % FILE_COUNT], "x", 1) != 1) ok = false;
+  }
+
+  for (const int fd : files) close(fd);
+
+  // The events of these changes are dropped.
+  std::ofstream(test_dir / "created.txt") << "created\n";
+  fs::remove(test_dir / "removed.txt");
+  std::ofstream(test_dir / "updated.txt", std::ios::app) << "appended\n";
+
+  release.set_value();
+  const auto released = std::chrono::steady_clock::now();
+
+  // Wait until the events stop.
+  for (;;)
+  {
+    std::this_thread::sleep_for(200ms);
+
+    std::lock_guard<std::mutex> guard(log.mutex);
+    if (!log.events.empty() && std::chrono::steady_clock::now() - log.last_event > 1s) break;
+    if (std::chrono::steady_clock::now() - released > 15s) break;
+  }
+
+  ok = expect_ok(fsw_stop_monitor(handle), "fsw_stop_monitor failed") && ok;
+  ok = expect_ok(monitor_status.get(), "fsw_start_monitor failed") && ok;
+  fsw_destroy_session(handle);
+
+  ok = expect_overflow(log) && ok;
+  ok = expect_event(log, test_dir / "created.txt", Created, "creation was not recovered") && ok;
+  ok = expect_event(log, test_dir / "removed.txt", Removed, "removal was not recovered") && ok;
+  ok = expect_event(log, test_dir / "updated.txt", Updated, "update was not recovered") && ok;
+
+  fs::remove_all(test_dir);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares the time required to scan a directory tree and add an inotify watch
+ * to each directory with a serial walk and with parallel walks, as the
+ * inotify monitor does at startup.  The tree is a synthetic tree with ten
+ * subdirectories and a file per directory.
+ *
+ * The scan of a tree in the page cache is dominated by the watch registration,
+ * which is serialized.  The listing of the directories, which is performed in
+ * parallel, dominates the scan of an uncached tree: if --drop-caches is
+ * specified, the page cache is dropped before each walk, which requires
+ * privileges.
+ *
+ * Usage: inotify_scan_benchmark [--drop-caches] [directories] [threads...]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <vector>
+
+#include <libfswatch/c++/directory_walker.hpp>
+
+using namespace fsw;
+namespace fs = std::filesystem;
+
+namespace
+{
+  void make_tree(const fs::path& root, size_t count)
+  {
+    std::vector<fs::path> directories{root};
+    fs::create_directories(root);
+
+    for (size_t i = 1; i < count; ++i)
+    {
+      directories.push_back(directories[(i - 1) / 10] / ("module-" + std::to_string((i - 1) % 10)));
+      fs::create_directory(directories.back());
+      std::ofstream(directories.back() / "file.txt") << i << "\n";
+    }
+  }
+
+  bool drop_caches()
+  {
+    sync();
+    std::ofstream caches("/proc/sys/vm/drop_caches");
+    caches << "3\n";
+
+    return static_cast<bool>(caches.flush());
+  }
+
+  bool run_walk(const fs::path& root, size_t threads, bool cold)
+  {
+    const int fd = inotify_init1(IN_CLOEXEC);
+    if (fd == -1)
+    {
+      perror("inotify_init1");
+      return false;
+    }
+
+    if (cold && !drop_caches())
+    {
+      std::cerr << "Cannot drop the page cache.\n";
+      close(fd);
+      return false;
+    }
+
+    size_t watches = 0;
+
+    directory_walker walker([fd, &watches](const fs::path& path, entry_type type, bool is_root)
+                            -> std::optional<fs::path>
+                            {
+                              if (!is_root && type != entry_type::directory) return std::nullopt;
+                              if (inotify_add_watch(fd, path.c_str(), IN_ALL_EVENTS | IN_ONLYDIR) == -1)
+                                return std::nullopt;
+
+                              ++watches;
+                              return path;
+                            },
+                            threads);
+
+    const walk_statistics statistics = walker.walk(root);
+    close(fd);
+
+    std::cout << threads << " threads watches:\t" << watches << "\n"
+              << threads << " threads threads started:\t" << statistics.threads << "\n"
+              << threads << " threads scan ms:\t"
+              << std::chrono::duration<double, std::milli>(statistics.elapsed).count() << "\n";
+
+    return watches == statistics.directories;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  bool cold = false;
+  int arg = 1;
+
+  if (arg < argc && std::strcmp(argv[arg], "--drop-caches") == 0)
+  {
+    cold = true;
+    ++arg;
+  }
+
+  const size_t count = arg < argc ? std::strtoul(argv[arg++], nullptr, 10) : 20000;
+  std::vector<size_t> thread_counts;
+  while (arg < argc) thread_counts.push_back(std::strtoul(argv[arg++], nullptr, 10));
+  if (thread_counts.empty()) thread_counts = {1, directory_walker::default_thread_count()};
+
+  if (count == 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " [--drop-caches] [directories] [threads...]\n";
+    return 1;
+  }
+
+  const fs::path root =
+    fs::temp_directory_path() /
+    ("fswatch-inotify-scan-" +
+     std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+  make_tree(root, count);
+
+  std::cout << "directories:\t" << count << "\n";
+
+  bool ok = true;
+  for (const size_t threads : thread_counts) ok = run_walk(root, threads, cold) && ok;
+
+  fs::remove_all(root);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Extracts a tarball of nested directories, each containing a file, into a
+ * directory watched recursively by the inotify monitor, and measures the rate
+ * at which Created events are received and the number of extracted paths for
+ * which no Created event is received.  Directories created before the watch
+ * of their parent is added are only reported by the synthetic events of the
+ * monitor, so that every creation must be reported.
+ *
+ * Usage: inotify_tarball_benchmark [directories] [tar]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <libfswatch/c/libfswatch.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  struct event_log
+  {
+    std::mutex mutex;
+    std::unordered_set<std::string> created;
+    size_t events = 0;
+    std::chrono::steady_clock::time_point last_event;
+  };
+
+  void callback(fsw_cevent const *const events, const unsigned int event_num, void *data)
+  {
+    auto *log = static_cast<event_log *>(data);
+    std::lock_guard<std::mutex> guard(log->mutex);
+
+    log->events += event_num;
+    log->last_event = std::chrono::steady_clock::now();
+
+    for (unsigned int i = 0; i < event_num; ++i)
+    {
+      for (unsigned int j = 0; j < events[i].flags_num; ++j)
+      {
+        if (events[i].flags[j] == Created) log->created.insert(events[i].path);
+      }
+    }
+  }
+
+  bool expect_ok(FSW_STATUS status, const char *message)
+  {
+    if (status == FSW_OK) return true;
+
+    std::cerr << message << ": " << fsw_last_error() << "\n";
+    return false;
+  }
+
+  // Creates a tree of count directories with ten subdirectories and a file
+  // per directory, and returns the paths of its entries.
+  std::vector<fs::path> make_tree(const fs::path& root, size_t count)
+  {
+    std::vector<fs::path> directories{root};
+    std::vector<fs::path> entries;
+    fs::create_directories(root);
+
+    for (size_t i = 1; i < count; ++i)
+    {
+      directories.push_back(directories[(i - 1) / 10] / ("module-" + std::to_string((i - 1) % 10)));
+      fs::create_directory(directories.back());
+      std::ofstream(directories.back() / "file.txt") << i << "\n";
+
+      entries.push_back(directories.back());
+      entries.push_back(directories.back() / "file.txt");
+    }
+
+    return entries;
+  }
+
+  std::string quote(const fs::path& path)
+  {
+    return "'" + path.string() + "'";
+  }
+}
+
+int main(int argc, char **argv)
+{
+  using namespace std::chrono_literals;
+
+  const size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000;
+  const std::string tar = argc > 2 ? argv[2] : "tar";
+
+  if (count < 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " [directories] [tar]\n";
+    return 1;
+  }
+
+  if (!expect_ok(fsw_init_library(), "fsw_init_library failed")) return 1;
+
+  const fs::path work_dir =
+    fs::temp_directory_path() /
+    ("fswatch-inotify-tarball-" +
+     std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+  const fs::path source_dir = work_dir / "source";
+  const fs::path target_dir = work_dir / "target";
+  const fs::path archive = work_dir / "tree.tar";
+
+  const std::vector<fs::path> entries = make_tree(source_dir / "tree", count);
+  fs::create_directories(target_dir);
+
+  if (std::system((tar + " -cf " + quote(archive) + " -C " + quote(source_dir) + " tree").c_str()) != 0)
+  {
+    std::cerr << "Cannot create the archive.\n";
+    fs::remove_all(work_dir);
+    return 1;
+  }
+
+  event_log log;
+  FSW_HANDLE handle = fsw_init_session(inotify_monitor_type);
+
+  bool ok = handle != nullptr &&
+            expect_ok(fsw_add_path(handle, target_dir.string().c_str()), "fsw_add_path failed") &&
+            expect_ok(fsw_set_recursive(handle, true), "fsw_set_recursive failed") &&
+            expect_ok(fsw_set_latency(handle, 0.1), "fsw_set_latency failed") &&
+            expect_ok(fsw_set_callback(handle, callback, &log), "fsw_set_callback failed");
+
+  if (!ok)
+  {
+    if (handle) fsw_destroy_session(handle);
+    fs::remove_all(work_dir);
+    return 1;
+  }
+
+  auto monitor_status = std::async(std::launch::async, [handle] {
+    return fsw_start_monitor(handle);
+  });
+
+  std::this_thread::sleep_for(500ms);
+
+  const auto start = std::chrono::steady_clock::now();
+  ok = std::system((tar + " -xf " + quote(archive) + " -C " + quote(target_dir)).c_str()) == 0;
+  const auto extracted = std::chrono::steady_clock::now();
+
+  // Wait until the events stop.
+  for (;;)
+  {
+    std::this_thread::sleep_for(200ms);
+
+    std::lock_guard<std::mutex> guard(log.mutex);
+    if (log.events > 0 && std::chrono::steady_clock::now() - log.last_event > 1s) break;
+    if (std::chrono::steady_clock::now() - extracted > 30s) break;
+  }
+
+  ok = expect_ok(fsw_stop_monitor(handle), "fsw_stop_monitor failed") && ok;
+  ok = expect_ok(monitor_status.get(), "fsw_start_monitor failed") && ok;
+  fsw_destroy_session(handle);
+
+  size_t missed = 0;
+  const fs::path canonical_target = fs::canonical(target_dir);
+
+  for (const auto& entry : entries)
+  {
+    const fs::path extracted_path = canonical_target / fs::relative(entry, source_dir);
+    if (log.created.find(extracted_path.string()) == log.created.end()) ++missed;
+  }
+
+  const double seconds = std::chrono::duration<double>(log.last_event - start).count();
+
+  std::cout << "entries:\t" << entries.size() << "\n"
+            << "extraction ms:\t" << std::chrono::duration<double, std::milli>(extracted - start).count() << "\n"
+            << "notification ms:\t" << seconds * 1000 << "\n"
+            << "events:\t" << log.events << "\n"
+            << "events per second:\t" << (seconds > 0 ? log.events / seconds : 0) << "\n"
+            << "missed creations:\t" << missed << "\n";
+
+  fs::remove_all(work_dir);
+
+  return ok && missed == 0 ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Checks that the number of watches held by the inotify monitor follows the
+ * directories of a recursively watched tree, and that an invalid value of the
+ * inotify.watch-limit property is rejected.
+ */
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libfswatch/c++/event.hpp>
+#include <libfswatch/c++/inotify_monitor.hpp>
+#include <libfswatch/c++/libfswatch_exception.hpp>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  constexpr size_t DIRECTORY_COUNT = 10;
+
+  void callback(const std::vector<fsw::event>&, void *)
+  {
+  }
+
+  bool expect(bool condition, const std::string& message)
+  {
+    if (condition) return true;
+
+    std::cerr << message << "\n";
+    return false;
+  }
+
+  bool wait_for_watch_count(const fsw::inotify_monitor& monitor, size_t count)
+  {
+    using namespace std::chrono_literals;
+
+    const auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (monitor.get_watch_count() != count && std::chrono::steady_clock::now() < deadline)
+      std::this_thread::sleep_for(10ms);
+
+    return monitor.get_watch_count() == count;
+  }
+}
+
+int main()
+{
+  const fs::path test_dir =
+    fs::temp_directory_path() /
+    ("fswatch-inotify-watch-count-" +
+     std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+
+  for (size_t i = 0; i < DIRECTORY_COUNT; ++i)
+    fs::create_directories(test_dir / ("dir-" + std::to_string(i)));
+
+  bool ok = true;
+
+  {
+    fsw::inotify_monitor monitor({test_dir.string()}, callback);
+    monitor.set_recursive(true);
+    monitor.set_latency(0.1);
+    monitor.set_property(fsw::inotify_monitor::WATCH_LIMIT_PROPERTY, "fail");
+    ok = expect(monitor.get_watch_count() == 0, "watches held before start") && ok;
+
+    std::thread runner([&monitor] { monitor.start(); });
+
+    // The root and its subdirectories are watched.
+    ok = expect(wait_for_watch_count(monitor, DIRECTORY_COUNT + 1), "wrong number of watches") && ok;
+
+    fs::create_directory(test_dir / "created");
+    ok = expect(wait_for_watch_count(monitor, DIRECTORY_COUNT + 2),
+                "created directory was not counted") && ok;
+
+    fs::remove(test_dir / "dir-0");
+    ok = expect(wait_for_watch_count(monitor, DIRECTORY_COUNT + 1),
+                "removed directory was counted") && ok;
+
+    monitor.stop();
+    runner.join();
+  }
+
+  {
+    fsw::inotify_monitor monitor({test_dir.string()}, callback);
+    monitor.set_property(fsw::inotify_monitor::WATCH_LIMIT_PROPERTY, "ignore");
+
+    bool rejected = false;
+
+    try
+    {
+      monitor.start();
+    }
+    catch (const fsw::libfsw_exception&)
+    {
+      rejected = true;
+    }
+
+    ok = expect(rejected, "invalid watch limit policy was accepted") && ok;
+  }
+
+  fs::remove_all(test_dir);
+
+  return ok ? 0 : 1;
+}
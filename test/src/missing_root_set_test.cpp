@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include <libfswatch/c++/missing_root_set.hpp>
+
+using namespace fsw;
+namespace fs = std::filesystem;
+
+namespace
+{
+  bool expect(bool condition, const std::string& message)
+  {
+    if (condition) return true;
+
+    std::cerr << message << "\n";
+    return false;
+  }
+}
+
+int main()
+{
+  bool ok = true;
+
+  using clock = missing_root_set<int>::clock;
+  const clock::time_point now = clock::now();
+
+  missing_root_set<int> roots;
+  ok = expect(roots.empty() && roots.get_timeout_ms(now) == -1,
+              "new set is not empty") && ok;
+
+  // Anchored paths are found from their anchor and are never due.
+  roots.insert("/a/b", 1, now);
+  roots.insert("/a/c", 1, now);
+  roots.insert("/d/e", 2, now);
+  ok = expect(roots.size() == 3 && roots.contains("/a/b"), "inserted path was not found") && ok;
+  ok = expect(roots.is_anchor(1) && !roots.is_anchor(3), "wrong anchor") && ok;
+  ok = expect(roots.get_anchored(1).size() == 2 && roots.get_anchored(3).empty(),
+              "wrong anchored paths") && ok;
+  ok = expect(roots.get_due(now + std::chrono::hours(1)).empty() &&
+                roots.get_timeout_ms(now) == -1,
+              "anchored path is waiting for a retry") && ok;
+
+  // Anchors without paths are forgotten.
+  roots.erase("/d/e");
+  ok = expect(!roots.is_anchor(2) && !roots.contains("/d/e"), "erased path was found") && ok;
+
+  // Moving a path to another anchor detaches it from the previous one.
+  roots.insert("/a/c", 4, now);
+  ok = expect(roots.get_anchored(1).size() == 1 && roots.is_anchor(4),
+              "path was not moved to the new anchor") && ok;
+
+  // Paths without an anchor are retried with a doubling interval.
+  roots.insert("/f", std::nullopt, now);
+  ok = expect(roots.get_timeout_ms(now) == 1000, "wrong first retry interval") && ok;
+  ok = expect(roots.get_due(now).empty(), "path is due before its interval") && ok;
+  ok = expect(roots.get_due(now + std::chrono::seconds(1)).size() == 1,
+              "path is not due after its interval") && ok;
+
+  roots.insert("/f", std::nullopt, now);
+  ok = expect(roots.get_timeout_ms(now) == 2000, "retry interval was not doubled") && ok;
+  ok = expect(roots.get_timeout_ms(now + std::chrono::seconds(3)) == 0,
+              "late retry has a timeout") && ok;
+
+  for (int i = 0; i < 10; ++i) roots.insert("/f", std::nullopt, now);
+  ok = expect(roots.get_timeout_ms(now) == 64000, "retry interval was not capped") && ok;
+
+  // Anchoring a path stops its retries, and the backoff restarts afterwards.
+  roots.insert("/f", 5, now);
+  ok = expect(roots.get_timeout_ms(now) == -1, "anchored path is still retried") && ok;
+  roots.insert("/f", std::nullopt, now);
+  ok = expect(roots.get_timeout_ms(now) == 1000, "backoff did not restart") && ok;
+
+  roots.erase("/f");
+  roots.erase("/a/b");
+  roots.erase("/a/c");
+  ok = expect(roots.empty() && !roots.is_anchor(1) && !roots.is_anchor(4) &&
+                roots.get_timeout_ms(now) == -1,
+              "set is not empty") && ok;
+
+  // The anchor of a path is its nearest existing ancestor directory.
+  const fs::path root =
+    fs::temp_directory_path() /
+    ("fswatch-missing-root-set-" +
+     std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+  fs::create_directories(root / "a");
+
+  ok = expect(find_anchor_path((root / "a" / "b" / "c").string()) ==
+                (root / "a").string(),
+              "wrong anchor of a nested path") && ok;
+  ok = expect(find_anchor_path((root / "b").string() + "/") == root.string(),
+              "wrong anchor of a path with a trailing separator") && ok;
+  ok = expect(find_anchor_path("missing-root") == ".",
+              "wrong anchor of a relative path") && ok;
+  ok = expect(find_anchor_path("/missing-root") == "/",
+              "wrong anchor of a top-level path") && ok;
+
+  fs::remove_all(root);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <libfswatch/c++/event.hpp>
+#include <libfswatch/c++/libfswatch_exception.hpp>
+#include <libfswatch/c++/monitor.hpp>
+
+using namespace fsw;
+
+namespace
+{
+  void test_callback(const std::vector<event>&, void *)
+  {
+  }
+
+  class test_monitor : public monitor
+  {
+  public:
+    test_monitor() : monitor({"."}, test_callback)
+    {
+    }
+
+    size_t get_number(const std::string& value, size_t min_value = 0)
+    {
+      set_property("test.number", value);
+      return get_unsigned_property("test.number", 42, min_value);
+    }
+
+  private:
+    void run() override
+    {
+    }
+  };
+
+  bool expect(bool condition, const std::string& message)
+  {
+    if (condition) return true;
+
+    std::cerr << message << "\n";
+    return false;
+  }
+
+  bool rejects(test_monitor& monitor, const std::string& value, size_t min_value = 0)
+  {
+    try
+    {
+      monitor.get_number(value, min_value);
+      return false;
+    }
+    catch (const libfsw_exception&)
+    {
+      return true;
+    }
+  }
+}
+
+int main()
+{
+  bool ok = true;
+  test_monitor monitor;
+
+  ok = expect(monitor.get_number("") == 42, "unset property was not defaulted") && ok;
+  ok = expect(monitor.get_number("0") == 0, "zero was not parsed") && ok;
+  ok = expect(monitor.get_number("65536") == 65536, "decimal value was not parsed") && ok;
+  ok = expect(monitor.get_number("0100") == 100, "leading zero was not parsed as decimal") && ok;
+  ok = expect(monitor.get_number("4096", 4096) == 4096, "minimum value was rejected") && ok;
+
+  for (const char *value : {"-1", " -1", " 1", "\t1", "+1", "1 ", "1k", "x", "0x", "0x10",
+                            "99999999999999999999999"})
+  {
+    ok = expect(rejects(monitor, value), std::string("invalid value was accepted: ") + value) && ok;
+  }
+
+  try
+  {
+    monitor.get_number("x");
+  }
+  catch (const libfsw_exception& ex)
+  {
+    ok = expect(std::string(ex.what()).find("test.number") != std::string::npos,
+                "the error does not name the property") && ok;
+  }
+
+  ok = expect(rejects(monitor, "4095", 4096), "value below the minimum was accepted") && ok;
+  ok = expect(rejects(monitor, "0", 1), "zero was accepted with a positive minimum") && ok;
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Measures how the inotify or the fanotify monitor reads a burst of files
+ * being created, as in test/inotify_burst_create.sh, with a small read buffer
+ * and with the default one.
+ *
+ *   - inotify: the buffer holds 10 events of maximum size (2720 bytes).
+ *
+ *   - fanotify: the buffer is 4 KiB, and the burst is also read by the
+ *     inotify monitor with its default buffer for comparison.
+ *
+ * Files are created in chunks while the callback is stalled, as a busy
+ * consumer would be, so that events accumulate in the kernel queue between
+ * reads.  The time taken to deliver the events of a chunk once the callback
+ * is released is measured in files per second, together with the number of
+ * read() and epoll_wait() calls and of heap allocations of the monitor thread
+ * per delivered event.
+ *
+ * The fanotify monitor requires CAP_SYS_ADMIN: its benchmark is skipped if it
+ * cannot be started.
+ *
+ * Usage: monitor_read_benchmark [inotify|fanotify] [files]
+ */
+
+#include <libfswatch/libfswatch_config.h>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <libfswatch/c++/event.hpp>
+#include <libfswatch/c++/inotify_monitor.hpp>
+#include <libfswatch/c++/monitor_factory.hpp>
+
+#ifdef HAVE_FANOTIFY
+#  include <sys/fanotify.h>
+#  include <libfswatch/c++/fanotify_monitor.hpp>
+#endif
+
+#include "allocation_counter.hpp"
+
+using namespace allocation_counter;
+
+namespace
+{
+  constexpr int SKIPPED = 77;
+
+  std::atomic<unsigned long> reads{0};
+  std::atomic<unsigned long> waits{0};
+  std::atomic<unsigned long> events_received{0};
+  std::atomic<unsigned long> files_received{0};
+
+  constexpr unsigned long chunk_size = 1000;
+
+  std::mutex gate_mutex;
+  std::condition_variable gate;
+  bool hold = false;
+  bool held = false;
+
+  void callback(const std::vector<fsw::event>& events, void *)
+  {
+    std::unique_lock<std::mutex> guard(gate_mutex);
+    events_received += events.size();
+
+    for (const auto& evt : events)
+      if (evt.get_flag_set().contains(fsw_event_flag::Created)) ++files_received;
+
+    gate.notify_all();
+
+    if (!hold) return;
+
+    held = true;
+    gate.wait(guard, [] { return !hold; });
+    held = false;
+  }
+
+  void create_file(const std::filesystem::path& path)
+  {
+    const int fd = open(path.c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+    if (fd != -1) close(fd);
+  }
+
+#ifdef HAVE_FANOTIFY
+  bool fanotify_available()
+  {
+    const int fd = fanotify_init(FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME, O_RDONLY);
+    if (fd == -1) return false;
+
+    close(fd);
+    return true;
+  }
+#endif
+
+  struct run_config
+  {
+    const char *label;
+    fsw_monitor_type type;
+    const char *buffer_size_property;
+    std::string buffer_size;
+  };
+
+  struct run_result
+  {
+    unsigned long files;
+    unsigned long events;
+    unsigned long reads;
+    unsigned long waits;
+    unsigned long allocations;
+    double drain_seconds;
+  };
+
+  run_result run_burst(const run_config& config, unsigned long file_count)
+  {
+    namespace fs = std::filesystem;
+    using namespace std::chrono_literals;
+
+    const fs::path test_dir =
+      fs::canonical(fs::temp_directory_path()) /
+      ("fswatch-monitor-reads-" +
+       std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    fs::create_directory(test_dir);
+
+    std::unique_ptr<fsw::monitor> monitor(
+      fsw::monitor_factory::create_monitor(config.type, {test_dir.string()}, callback));
+    monitor->set_latency(0.1);
+    if (!config.buffer_size.empty())
+      monitor->set_property(config.buffer_size_property, config.buffer_size);
+
+    events_received = 0;
+    files_received = 0;
+    reads = 0;
+    waits = 0;
+    allocations = 0;
+
+    std::thread runner([&monitor] { monitor->start(); });
+    std::this_thread::sleep_for(500ms);
+
+    counting = true;
+
+    unsigned long created = 0;
+    std::chrono::steady_clock::duration drain_time{};
+
+    for (unsigned long chunk = 0; created < file_count; ++chunk)
+    {
+      // Stall the callback on a gate file, then queue a chunk of events.
+      {
+        std::unique_lock<std::mutex> guard(gate_mutex);
+        hold = true;
+        create_file(test_dir / ("gate-" + std::to_string(chunk)));
+        ++created;
+
+        if (!gate.wait_for(guard, 5s, [] { return held; })) break;
+      }
+
+      for (unsigned long i = 0; i < chunk_size && created < file_count; ++i, ++created)
+        create_file(test_dir / ("burst-" + std::to_string(created) + ".txt"));
+
+      // The creation and the close after write of a file are merged into one
+      // event by fanotify, and are reported as two events by inotify: the
+      // files are counted by their Created flag.
+      std::unique_lock<std::mutex> guard(gate_mutex);
+      const unsigned long expected = created;
+      const auto released = std::chrono::steady_clock::now();
+      hold = false;
+      gate.notify_all();
+
+      gate.wait_for(guard, 5s, [expected] { return files_received >= expected; });
+      drain_time += std::chrono::steady_clock::now() - released;
+    }
+
+    {
+      std::lock_guard<std::mutex> guard(gate_mutex);
+      hold = false;
+      gate.notify_all();
+    }
+
+    counting = false;
+
+    monitor->stop();
+    runner.join();
+    fs::remove_all(test_dir);
+
+    return {files_received,
+            events_received,
+            reads,
+            waits,
+            allocations,
+            std::chrono::duration<double>(drain_time).count()};
+  }
+
+  void print_result(const char *label, const run_result& result)
+  {
+    const double per_10k = 10000.0 / static_cast<double>(result.events);
+
+    std::cout << label << " events:\t" << result.events << "\n"
+              << label << " files/s:\t" << result.files / result.drain_seconds << "\n"
+              << label << " read/10k events:\t" << result.reads * per_10k << "\n"
+              << label << " epoll_wait/10k events:\t" << result.waits * per_10k << "\n"
+              << label << " syscalls/10k events:\t"
+              << (result.reads + result.waits) * per_10k << "\n"
+              << label << " allocations/event:\t"
+              << static_cast<double>(result.allocations) / result.events << "\n";
+  }
+}
+
+// The monitor is linked statically or resolves these symbols through the
+// executable, which lets the benchmark count the calls without tracing.
+extern "C" ssize_t read(int fd, void *buf, size_t count)
+{
+  if (counted()) reads.fetch_add(1, std::memory_order_relaxed);
+
+  return syscall(SYS_read, fd, buf, count);
+}
+
+extern "C" int epoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout)
+{
+  if (counted()) waits.fetch_add(1, std::memory_order_relaxed);
+
+  return static_cast<int>(
+    syscall(SYS_epoll_pwait, epfd, events, maxevents, timeout, nullptr, _NSIG / 8));
+}
+
+int main(int argc, char **argv)
+{
+  const std::string monitor_name = argc > 1 ? argv[1] : "inotify";
+  const unsigned long file_count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000;
+  excluded_thread = true;
+
+  const run_config inotify_default{"inotify default buffer",
+                                   fsw_monitor_type::inotify_monitor_type,
+                                   fsw::inotify_monitor::BUFFER_SIZE_PROPERTY,
+                                   ""};
+  std::vector<run_config> configs;
+
+  if (monitor_name == "inotify")
+  {
+    configs.push_back({"inotify 2720 B buffer",
+                       fsw_monitor_type::inotify_monitor_type,
+                       fsw::inotify_monitor::BUFFER_SIZE_PROPERTY,
+                       std::to_string(10 * (sizeof(struct inotify_event) + NAME_MAX + 1))});
+    configs.push_back(inotify_default);
+  }
+#ifdef HAVE_FANOTIFY
+  else if (monitor_name == "fanotify")
+  {
+    if (!fanotify_available())
+    {
+      std::cerr << "fanotify is unavailable in this environment.\n";
+      return SKIPPED;
+    }
+
+    configs.push_back({"fanotify 4 KiB buffer",
+                       fsw_monitor_type::fanotify_monitor_type,
+                       fsw::fanotify_monitor::BUFFER_SIZE_PROPERTY,
+                       "4096"});
+    configs.push_back({"fanotify default buffer",
+                       fsw_monitor_type::fanotify_monitor_type,
+                       fsw::fanotify_monitor::BUFFER_SIZE_PROPERTY,
+                       ""});
+    configs.push_back(inotify_default);
+  }
+#endif
+
+  if (configs.empty() || file_count == 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " [inotify|fanotify] [files]\n";
+    return 1;
+  }
+
+  std::vector<run_result> results;
+
+  for (const run_config& config : configs)
+  {
+    results.push_back(run_burst(config, file_count));
+
+    if (results.back().files != file_count)
+    {
+      std::cerr << config.label << ": events were missed: "
+                << results.back().files << " of " << file_count << " files.\n";
+      return 1;
+    }
+  }
+
+  std::cout << "files:\t" << file_count << "\n";
+
+  for (size_t i = 0; i < configs.size(); ++i) print_result(configs[i].label, results[i]);
+
+  return 0;
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares the cost of evaluating a growing list of path filters one regular
+ * expression at a time with the cost of evaluating the same list compiled into
+ * a fsw::path_filter_set.
+ *
+ * Usage: path_filter_benchmark [paths] [max filters]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include <libfswatch/c++/path_filter_set.hpp>
+
+using namespace fsw;
+using namespace std::chrono;
+
+namespace
+{
+  struct naive_filter
+  {
+    std::regex regex;
+    fsw_filter_type type;
+  };
+
+  bool naive_accept(const std::vector<naive_filter>& filters,
+                    const std::string& path)
+  {
+    bool is_excluded = false;
+
+    for (const auto& filter : filters)
+    {
+      if (std::regex_search(path, filter.regex))
+      {
+        if (filter.type == fsw_filter_type::filter_include) return true;
+
+        is_excluded = true;
+      }
+    }
+
+    return !is_excluded;
+  }
+
+  std::vector<monitor_filter> make_filters(size_t count)
+  {
+    std::vector<monitor_filter> filters;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      std::string text;
+
+      switch (i % 3)
+      {
+      case 0:
+        text = "\\.ext" + std::to_string(i) + "$";
+        break;
+      case 1:
+        text = "/module" + std::to_string(i) + "/";
+        break;
+      default:
+        text = "^/srv/data" + std::to_string(i) + "/.*\\.tmp$";
+        break;
+      }
+
+      filters.push_back({text, fsw_filter_type::filter_exclude, true, true});
+    }
+
+    return filters;
+  }
+
+  std::vector<std::string> make_paths(size_t count)
+  {
+    std::vector<std::string> paths;
+    paths.reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      paths.push_back("/home/user/projects/module" + std::to_string(i % 97) +
+                      "/src/component" + std::to_string(i) +
+                      "/file" + std::to_string(i) +
+                      ".ext" + std::to_string(i % 53));
+    }
+
+    return paths;
+  }
+
+  template<typename F>
+  double measure_ns_per_path(const std::vector<std::string>& paths,
+                             size_t& accepted,
+                             F accept)
+  {
+    const auto start = steady_clock::now();
+
+    for (const auto& path : paths)
+    {
+      if (accept(path)) ++accepted;
+    }
+
+    const auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start);
+
+    return static_cast<double>(elapsed.count()) / paths.size();
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const size_t path_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+  const size_t max_filters = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 300;
+
+  if (path_count == 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " [paths] [max filters]\n";
+    return 1;
+  }
+
+  const std::vector<std::string> paths = make_paths(path_count);
+
+  std::cout << "filters\tloop ns/path\tset ns/path\tspeedup\n";
+
+  for (size_t count : {10, 50, 100, 300, 1000})
+  {
+    if (count > max_filters) break;
+
+    const std::vector<monitor_filter> filters = make_filters(count);
+    std::vector<naive_filter> naive;
+    path_filter_set set;
+
+    for (const auto& filter : filters)
+    {
+      naive.push_back({std::regex(filter.text, std::regex::extended), filter.type});
+      set.add(filter);
+    }
+
+    set.compile();
+
+    size_t naive_accepted = 0;
+    size_t set_accepted = 0;
+
+    const double naive_ns = measure_ns_per_path(
+      paths, naive_accepted,
+      [&naive](const std::string& path) { return naive_accept(naive, path); });
+    const double set_ns = measure_ns_per_path(
+      paths, set_accepted,
+      [&set](const std::string& path)
+      { return set.accept(path, fsw_filter_mode::filter_mode_legacy); });
+
+    if (naive_accepted != set_accepted)
+    {
+      std::cerr << "Result mismatch with " << count << " filters: "
+                << naive_accepted << " != " << set_accepted << "\n";
+      return 1;
+    }
+
+    std::cout << count << "\t" << naive_ns << "\t" << set_ns << "\t"
+              << naive_ns / set_ns << "\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <unistd.h>
+
+#include <libfswatch/c++/libfswatch_exception.hpp>
+#include <libfswatch/c++/path_filter_set.hpp>
+#include <libfswatch/c/error.h>
+
+using namespace fsw;
+
+namespace
+{
+  bool expect(bool condition, const std::string& message)
+  {
+    if (condition) return true;
+
+    std::cerr << message << "\n";
+    return false;
+  }
+
+  std::regex compile(const monitor_filter& filter)
+  {
+    std::regex::flag_type regex_flags = std::regex::basic;
+
+    if (filter.extended) regex_flags = std::regex::extended;
+    if (!filter.case_sensitive) regex_flags |= std::regex::icase;
+
+    return std::regex(filter.text, regex_flags);
+  }
+
+  // Reference implementation: every filter is evaluated in order.
+  bool reference_accept(const std::vector<monitor_filter>& filters,
+                        const std::string& path,
+                        fsw_filter_mode mode)
+  {
+    if (mode == fsw_filter_mode::filter_mode_conjunctive)
+    {
+      bool has_includes = false;
+      bool included = false;
+
+      for (const auto& filter : filters)
+      {
+        const bool matches = std::regex_search(path, compile(filter));
+
+        if (filter.type == fsw_filter_type::filter_include)
+        {
+          has_includes = true;
+          included = included || matches;
+        }
+        else if (matches)
+        {
+          return false;
+        }
+      }
+
+      return !has_includes || included;
+    }
+
+    bool is_excluded = false;
+
+    for (const auto& filter : filters)
+    {
+      if (std::regex_search(path, compile(filter)))
+      {
+        if (filter.type == fsw_filter_type::filter_include) return true;
+
+        is_excluded = true;
+      }
+    }
+
+    return !is_excluded;
+  }
+
+  bool reference_matches_any(const std::vector<monitor_filter>& filters,
+                             const std::string& path)
+  {
+    for (const auto& filter : filters)
+    {
+      if (std::regex_search(path, compile(filter))) return true;
+    }
+
+    return false;
+  }
+}
+
+int main()
+{
+  bool ok = true;
+
+  const std::vector<std::pair<std::string, bool>> patterns = {
+    {"\\.c$", false},
+    {"/skip\\.c$", false},
+    {"^/tmp/", false},
+    {"\\.git/", false},
+    {"node_modules", true},
+    {"\\.(o|a|so)$", true},
+    {"build[0-9]*/", true},
+    {"ab*c", false},
+    {"ab+c", true},
+    {"a\\.c", false},
+    {"colou?r", true},
+    {"x\\{2\\}y", false},
+    {"x{2}y", true},
+    {"(foo|bar)baz", true},
+    {"\\(foo\\)\\1", false},
+    {"foo|bar", true},
+    {"[[:digit:]]+\\.log", true},
+    {"[]a]bc", true},
+    {".*", false},
+    {"", false},
+    {"s*tar", false},
+    {"\\.\\.\\.", false},
+    {"Makefile", false},
+    {"README", true},
+    {" word ", true},
+    {"^/var/log/.*\\.gz$", true},
+    {"^/src/Makefile$", false},
+    {"^.*\\.log.*$", true},
+    {"\\.\\*star", false},
+    {"a\\$", true},
+  };
+
+  const std::vector<std::string> paths = {
+    "/tmp/keep.c",
+    "/tmp/skip.c",
+    "/home/user/project/.git/index",
+    "/home/user/project/node_modules/x/index.js",
+    "/home/user/project/NODE_MODULES/y",
+    "/srv/lib.so",
+    "/srv/lib.a",
+    "/srv/libxo",
+    "/work/build12/out",
+    "/work/build/out",
+    "/ac",
+    "/abbbc",
+    "/ab+c",
+    "/color",
+    "/colour",
+    "/COLOR",
+    "/xxy",
+    "/xy",
+    "/foobaz",
+    "/barbaz",
+    "/bazbaz",
+    "/foofoo",
+    "/foo",
+    "/123.log",
+    "/abc",
+    "/]bc",
+    "/star",
+    "/*star",
+    "/a...b",
+    "/src/makefile",
+    "/src/Makefile",
+    "/src/readme.md",
+    "/a word here",
+    "/var/log/syslog.1.gz",
+    "/VAR/LOG/syslog.1.GZ",
+    "",
+  };
+
+  const std::vector<fsw_filter_mode> modes = {
+    fsw_filter_mode::filter_mode_legacy,
+    fsw_filter_mode::filter_mode_conjunctive
+  };
+
+  // Build filter lists of increasing size, alternating filter types and case
+  // sensitivity, and compare the compiled set against the reference.
+  for (size_t count = 0; count <= patterns.size(); ++count)
+  {
+    for (bool case_sensitive : {true, false})
+    {
+      std::vector<monitor_filter> filters;
+      path_filter_set set;
+
+      for (size_t i = 0; i < count; ++i)
+      {
+        const monitor_filter filter{
+          patterns[i].first,
+          (i % 3 == 0) ? fsw_filter_type::filter_include
+                       : fsw_filter_type::filter_exclude,
+          case_sensitive || (i % 2 == 0),
+          patterns[i].second};
+
+        filters.push_back(filter);
+        set.add(filter);
+      }
+
+      set.compile();
+
+      for (const auto& path : paths)
+      {
+        for (const auto mode : modes)
+        {
+          ok = expect(set.accept(path, mode) ==
+                        reference_accept(filters, path, mode),
+                      "accept mismatch for " + path + " with " +
+                        std::to_string(count) + " filters") && ok;
+        }
+
+        ok = expect(set.matches_any(path) ==
+                      reference_matches_any(filters, path),
+                    "matches_any mismatch for " + path + " with " +
+                      std::to_string(count) + " filters") && ok;
+      }
+    }
+  }
+
+  // Glob patterns match the whole path.
+  const std::vector<std::tuple<std::string, bool, std::string, bool>> globs = {
+    {"*.c", true, "/tmp/keep.c", true},
+    {"*.c", true, "/tmp/keep.cpp", false},
+    {"*.C", false, "/tmp/KEEP.c", true},
+    {"*/node_modules/*", true, "/p/node_modules/x", true},
+    {"*/node_modules/*", true, "/p/node_modules", false},
+    {"/tmp/*", true, "/tmp/a/b", true},
+    {"/tmp/*", true, "/var/tmp/a", false},
+    {"/tmp/a.c", true, "/tmp/a.c", true},
+    {"/tmp/a.c", true, "/tmp/a.cc", false},
+    {"*.[ch]", true, "/src/x.h", true},
+    {"*.[!ch]", true, "/src/x.h", false},
+    {"*.[!ch]", true, "/src/x.o", true},
+    {"*.[[:digit:]]", true, "/log.1", true},
+    {"/src/?.c", true, "/src/a.c", true},
+    {"/src/?.c", true, "/src/ab.c", false},
+    {"*\\*", true, "/a*", true},
+    {"*\\*", true, "/a", false},
+    {"*(1)+{2}|$^", true, "/x(1)+{2}|$^", true},
+    {"*[", true, "/a[", true},
+    {"*/a}b/*.c", true, "/p/a}b/x.c", true},
+    {"*/a}b/*.c", true, "/p/ab/x.c", false},
+    {"*/x]y/*.c", true, "/p/x]y/x.c", true},
+    {"*/x]y/*.c", true, "/p/xy/x.c", false},
+    {"*\\]*", true, "/a]b", true},
+    {"*\\}*", true, "/a}b", true},
+    {"*", true, "", true},
+  };
+
+  for (const auto& [pattern, case_sensitive, path, expected] : globs)
+  {
+    monitor_filter filter{pattern, fsw_filter_type::filter_exclude, case_sensitive, false};
+    filter.glob = true;
+
+    path_filter_set set;
+    set.add(filter);
+    set.compile();
+
+    ok = expect(set.matches_any(path) == expected,
+                "glob " + pattern + " failed on " + path) && ok;
+  }
+
+  // Prefixes whose extensions are all rejected.
+  path_filter_set hot;
+  hot.add({"/\\.git/", fsw_filter_type::filter_exclude, true, false});
+  hot.add({"\\.o$", fsw_filter_type::filter_exclude, true, false});
+  hot.add({"^/build/[a-z]*$", fsw_filter_type::filter_exclude, true, false});
+  hot.compile();
+
+  ok = expect(hot.rejects_prefix("/src/.git/objects/",
+                                 fsw_filter_mode::filter_mode_legacy),
+              "excluded subtree was not detected") && ok;
+  ok = expect(!hot.rejects_prefix("/src/lib.o/",
+                                  fsw_filter_mode::filter_mode_legacy),
+              "end anchored exclusion rejected a subtree") && ok;
+  ok = expect(!hot.rejects_prefix("/build/",
+                                  fsw_filter_mode::filter_mode_legacy),
+              "regular expression containing $ rejected a subtree") && ok;
+  ok = expect(!hot.rejects_prefix("/src/",
+                                  fsw_filter_mode::filter_mode_conjunctive),
+              "unmatched prefix was rejected") && ok;
+
+  hot.add({"\\.c$", fsw_filter_type::filter_include, true, false});
+  ok = expect(!hot.rejects_prefix("/src/.git/objects/",
+                                  fsw_filter_mode::filter_mode_legacy),
+              "legacy inclusion filters were ignored") && ok;
+  ok = expect(hot.rejects_prefix("/src/.git/objects/",
+                                 fsw_filter_mode::filter_mode_conjunctive),
+              "conjunctive exclusion did not reject a subtree") && ok;
+
+  // The g flag of the filter file grammar selects glob patterns.
+  char filter_file[] = "/tmp/fswatch_filter_XXXXXX";
+  const int fd = mkstemp(filter_file);
+  ok = expect(fd != -1, "cannot create filter file") && ok;
+
+  if (fd != -1)
+  {
+    close(fd);
+    std::ofstream(filter_file) << "-g *.o\n+gi *.C\n-e \\.swp$\n";
+
+    const std::vector<monitor_filter> parsed =
+      monitor_filter::read_from_file(filter_file);
+    unlink(filter_file);
+
+    ok = expect(parsed.size() == 3, "filter file was not parsed") && ok;
+
+    if (parsed.size() == 3)
+    {
+      ok = expect(parsed[0].glob && parsed[0].case_sensitive &&
+                    parsed[0].text == "*.o",
+                  "g flag was not parsed") && ok;
+      ok = expect(parsed[1].glob && !parsed[1].case_sensitive,
+                  "gi flags were not parsed") && ok;
+      ok = expect(!parsed[2].glob && parsed[2].extended,
+                  "e flag was parsed as a glob") && ok;
+    }
+  }
+
+  // Filters added after compile() must still be evaluated.
+  path_filter_set late;
+  late.add({"\\.c$", fsw_filter_type::filter_exclude, true, false});
+  late.compile();
+  late.add({"\\.h$", fsw_filter_type::filter_exclude, true, false});
+
+  ok = expect(!late.accept("/tmp/a.h", fsw_filter_mode::filter_mode_legacy),
+              "filter added after compile() was ignored") && ok;
+
+  path_filter_set empty;
+  ok = expect(empty.accept("/tmp/a.c", fsw_filter_mode::filter_mode_conjunctive),
+              "empty set rejected a path") && ok;
+  ok = expect(!empty.matches_any("/tmp/a.c"), "empty set matched a path") && ok;
+
+  try
+  {
+    path_filter_set invalid;
+    invalid.add({"(", fsw_filter_type::filter_include, true, true});
+    ok = expect(false, "invalid regular expression was accepted") && ok;
+  }
+  catch (const libfsw_exception& ex)
+  {
+    ok = expect(static_cast<int>(ex) == FSW_ERR_INVALID_REGEX,
+                "invalid regular expression reported the wrong error") && ok;
+  }
+
+  // Escape sequences std::regex rejects are rejected by the literal matcher
+  // too.
+  const std::vector<std::pair<std::string, bool>> invalid_escapes = {
+    {"\\/word", true},
+    {"a\\]b", true},
+    {"a\\]b", false},
+    {"a\\}b", true},
+  };
+
+  for (const auto& [pattern, extended] : invalid_escapes)
+  {
+    try
+    {
+      path_filter_set invalid;
+      invalid.add({pattern, fsw_filter_type::filter_include, true, extended});
+      ok = expect(false, "invalid escape sequence was accepted: " + pattern) && ok;
+    }
+    catch (const libfsw_exception& ex)
+    {
+      ok = expect(static_cast<int>(ex) == FSW_ERR_INVALID_REGEX,
+                  "invalid escape sequence reported the wrong error") && ok;
+    }
+  }
+
+  return ok ? 0 : 1;
+}
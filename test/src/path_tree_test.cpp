@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <libfswatch/c++/path_tree.hpp>
+
+using namespace fsw;
+
+namespace
+{
+  bool expect(bool condition, const std::string& message)
+  {
+    if (condition) return true;
+
+    std::cerr << message << "\n";
+    return false;
+  }
+
+  // Checks that a path is found and materialized as expected.
+  bool round_trips(const path_tree& tree, const std::string& path, const std::string& expected)
+  {
+    const path_tree::node_id id = tree.find(path);
+
+    return id != path_tree::npos && tree.get_path(id) == expected;
+  }
+}
+
+int main()
+{
+  bool ok = true;
+
+  path_tree tree;
+  ok = expect(tree.empty() && tree.find("/") == path_tree::npos, "new tree is not empty") && ok;
+  ok = expect(tree.insert("") == path_tree::npos && tree.insert("//") != path_tree::npos,
+              "wrong components of empty paths") && ok;
+  ok = expect(round_trips(tree, "/", "/"), "root directory was not found") && ok;
+
+  const path_tree::node_id ab = tree.insert("/a/b");
+  tree.insert("relative/path");
+  ok = expect(tree.size() == 3 && tree.node_count() == 5, "wrong number of nodes") && ok;
+  ok = expect(round_trips(tree, "/a//b/", "/a/b"), "path was not normalized") && ok;
+  ok = expect(round_trips(tree, "relative/path", "relative/path"), "relative path was lost") && ok;
+  ok = expect(tree.find("/a") == path_tree::npos && tree.find("/relative/path") == path_tree::npos,
+              "unreferenced path was found") && ok;
+
+  std::string appended = "path: ";
+  tree.append_path(ab, appended, 2);
+  ok = expect(appended == "path: /a/b" && appended.capacity() >= appended.size() + 2,
+              "path was not appended") && ok;
+
+  // Nodes are referenced once per insertion, and their ancestors are kept as
+  // long as they have children.
+  ok = expect(tree.insert("/a/b") == ab, "inserting a path twice created a node") && ok;
+  tree.release(ab);
+  ok = expect(tree.find("/a/b") == ab, "referenced node was freed") && ok;
+
+  const path_tree::node_id abc = tree.insert("/a/b/c");
+  tree.release(ab);
+  ok = expect(tree.find("/a/b") == path_tree::npos && round_trips(tree, "/a/b/c", "/a/b/c"),
+              "unreferenced parent was not kept for its child") && ok;
+
+  tree.release(abc);
+  ok = expect(tree.node_count() == 3, "unreferenced ancestors were not freed") && ok;
+
+  // Paths survive the removal of other paths, the reuse of their nodes and
+  // the compaction of the names.
+  std::vector<std::string> paths;
+  std::vector<path_tree::node_id> ids;
+
+  for (int i = 0; i < 40000; ++i)
+  {
+    paths.push_back("/tree/level-" + std::to_string(i % 97) +
+                    "/directory-with-a-long-name-" + std::to_string(i));
+    ids.push_back(tree.insert(paths.back()));
+  }
+
+  for (size_t i = 0; i < ids.size(); ++i)
+  {
+    if (i % 3 != 0) tree.release(ids[i]);
+  }
+
+  for (size_t i = 0; i < ids.size(); ++i)
+  {
+    if (i % 3 != 0) ids[i] = tree.insert(paths[i] + "/again");
+  }
+
+  bool preserved = true;
+
+  for (size_t i = 0; i < ids.size(); ++i)
+  {
+    const std::string expected = (i % 3 != 0) ? paths[i] + "/again" : paths[i];
+
+    preserved = preserved && tree.find(expected) == ids[i] && tree.get_path(ids[i]) == expected;
+    if (i % 3 != 0) preserved = preserved && tree.find(paths[i]) == path_tree::npos;
+  }
+
+  ok = expect(preserved, "paths were lost") && ok;
+
+  for (const path_tree::node_id id : ids) tree.release(id);
+  ok = expect(tree.size() == 2 && tree.node_count() == 3, "released paths were kept") && ok;
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <libfswatch/c/libfswatch.h>
+#include <poll.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  struct received_event
+  {
+    std::string path;
+    unsigned int flags;
+  };
+
+  bool expect(bool condition, const std::string& message)
+  {
+    if (condition) return true;
+
+    std::cerr << message << "\n";
+    return false;
+  }
+
+  bool expect_ok(FSW_STATUS status, const char *message)
+  {
+    if (status == FSW_OK) return true;
+
+    std::cerr << message << ": " << fsw_last_error() << "\n";
+    return false;
+  }
+
+  // Waits for events on the session descriptor and reads them until an event
+  // matching the predicate is received or the timeout expires.
+  template<typename P>
+  bool read_until(FSW_HANDLE handle,
+                  std::vector<received_event>& received,
+                  P predicate)
+  {
+    const int fd = fsw_get_event_fd(handle);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(6);
+    fsw_cevent_v3 events[4];
+
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+      struct pollfd pfd = {fd, POLLIN, 0};
+      if (poll(&pfd, 1, 100) <= 0) continue;
+
+      int count;
+      while ((count = fsw_read_events(handle, events, 4)) > 0)
+      {
+        for (int i = 0; i < count; ++i)
+          received.push_back({events[i].path, events[i].flags});
+      }
+
+      if (count == -1) return false;
+
+      for (const auto& evt : received)
+      {
+        if (predicate(evt)) return true;
+      }
+    }
+
+    return false;
+  }
+
+  bool run_session(const std::filesystem::path& test_dir,
+                   unsigned int capacity,
+                   unsigned int file_count,
+                   std::vector<received_event>& received)
+  {
+    namespace fs = std::filesystem;
+
+    FSW_HANDLE handle = fsw_init_session(poll_monitor_type);
+    if (!handle) return expect(false, "fsw_init_session failed");
+
+    bool ok =
+      expect_ok(fsw_add_path(handle, test_dir.string().c_str()), "fsw_add_path failed") &&
+      expect_ok(fsw_set_recursive(handle, true), "fsw_set_recursive failed") &&
+      expect_ok(fsw_set_latency(handle, 0.5), "fsw_set_latency failed") &&
+      expect_ok(fsw_set_pull_mode(handle, capacity), "fsw_set_pull_mode failed") &&
+      expect(fsw_get_event_fd(handle) >= 0, "invalid event descriptor");
+
+    // fsw_start_monitor() returns immediately in pull mode.
+    ok = ok && expect_ok(fsw_start_monitor(handle), "fsw_start_monitor failed");
+    ok = ok && expect(fsw_is_running(handle), "monitor is not running");
+
+    if (ok)
+    {
+      // Let the poll monitor take its initial snapshot.
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+
+      for (unsigned int i = 0; i < file_count; ++i)
+      {
+        std::ofstream(test_dir / ("file-" + std::to_string(i) + ".txt")) << i << "\n";
+      }
+
+      const std::string last = "/file-" + std::to_string(file_count - 1) + ".txt";
+      ok = expect(read_until(handle, received,
+                             [&last, capacity, file_count](const received_event& evt)
+                             {
+                               if (file_count > capacity) return (evt.flags & Overflow) != 0;
+                               return evt.path.find(last) != std::string::npos;
+                             }),
+                  "expected event was not read") && ok;
+
+      ok = expect_ok(fsw_stop_monitor(handle), "fsw_stop_monitor failed") && ok;
+      ok = expect(!fsw_is_running(handle), "monitor did not stop") && ok;
+    }
+
+    ok = expect_ok(fsw_destroy_session(handle), "fsw_destroy_session failed") && ok;
+
+    return ok;
+  }
+
+  // Starts a monitor failing once it is running and checks that the reader is
+  // woken up and reads the error.
+  bool run_failing_session(const std::filesystem::path& test_dir)
+  {
+    FSW_HANDLE handle = fsw_init_session(inotify_monitor_type);
+    if (!handle) return expect(false, "fsw_init_session failed");
+
+    bool ok =
+      expect_ok(fsw_add_path(handle, test_dir.string().c_str()), "fsw_add_path failed") &&
+      expect_ok(fsw_add_property(handle, "inotify.buffer-size", "invalid"), "fsw_add_property failed") &&
+      expect_ok(fsw_set_pull_mode(handle, 4), "fsw_set_pull_mode failed");
+
+    // The monitor fails once it is running: fsw_start_monitor() succeeds, and
+    // the error is reported by fsw_read_events() and fsw_stop_monitor().
+    const FSW_STATUS status = fsw_start_monitor(handle);
+
+    // The inotify monitor is not available on this platform.
+    if (status == FSW_ERR_UNKNOWN_MONITOR_TYPE)
+    {
+      fsw_destroy_session(handle);
+      return ok;
+    }
+
+    ok = ok && expect_ok(status, "fsw_start_monitor failed");
+
+    if (ok)
+    {
+      struct pollfd pfd = {fsw_get_event_fd(handle), POLLIN, 0};
+      ok = expect(poll(&pfd, 1, 5000) == 1, "the end of the monitor was not signalled") && ok;
+
+      fsw_cevent_v3 events[4];
+      ok = expect(fsw_read_events(handle, events, 4) == -1 &&
+                    fsw_last_error() != FSW_OK,
+                  "the error of the monitor was not read") && ok;
+      ok = expect(fsw_stop_monitor(handle) != FSW_OK,
+                  "the error of the monitor was not returned on stop") && ok;
+    }
+
+    ok = expect_ok(fsw_destroy_session(handle), "fsw_destroy_session failed") && ok;
+
+    return ok;
+  }
+}
+
+int main()
+{
+  namespace fs = std::filesystem;
+
+  if (!expect_ok(fsw_init_library(), "fsw_init_library failed")) return 1;
+
+  bool ok = true;
+
+  // The pull mode API requires a session in pull mode.
+  FSW_HANDLE handle = fsw_init_session(poll_monitor_type);
+  fsw_cevent_v3 event;
+  ok = expect(fsw_get_event_fd(handle) == -1 &&
+                fsw_last_error() == FSW_ERR_INVALID_MODE,
+              "event descriptor of a callback session") && ok;
+  ok = expect(fsw_read_events(handle, &event, 1) == -1 &&
+                fsw_last_error() == FSW_ERR_INVALID_MODE,
+              "events read from a callback session") && ok;
+  ok = expect(fsw_set_pull_mode(handle, 0) == FSW_ERR_UNKNOWN_VALUE,
+              "pull mode with no capacity was accepted") && ok;
+  fsw_destroy_session(handle);
+
+  const fs::path test_dir =
+    fs::temp_directory_path() /
+    ("fswatch-pull-c-api-" +
+     std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+
+  // Events are read through the descriptor.
+  fs::create_directories(test_dir / "read");
+  std::vector<received_event> received;
+  ok = run_session(test_dir / "read", 64, 5, received) && ok;
+
+  for (unsigned int i = 0; i < 5; ++i)
+  {
+    bool found = false;
+
+    for (const auto& evt : received)
+    {
+      if (evt.path.find("/file-" + std::to_string(i) + ".txt") != std::string::npos &&
+          (evt.flags & Created))
+        found = true;
+    }
+
+    ok = expect(found, "missing creation of file-" + std::to_string(i)) && ok;
+  }
+
+  // A full queue reports an overflow.
+  fs::create_directories(test_dir / "overflow");
+  received.clear();
+  ok = run_session(test_dir / "overflow", 2, 16, received) && ok;
+
+  // The reader is notified when the monitor fails.
+  fs::create_directories(test_dir / "failure");
+  ok = run_failing_session(test_dir / "failure") && ok;
+
+  fs::remove_all(test_dir);
+  return ok ? 0 : 1;
+}
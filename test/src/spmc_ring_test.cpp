@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <libfswatch/c++/spmc_ring.hpp>
+
+using namespace fsw;
+
+namespace
+{
+  bool expect(bool condition, const std::string& message)
+  {
+    if (condition) return true;
+
+    std::cerr << message << "\n";
+    return false;
+  }
+}
+
+int main()
+{
+  bool ok = true;
+
+  spmc_ring<std::string> ring(3);
+  ok = expect(ring.capacity() == 4, "capacity was not rounded up") && ok;
+  ok = expect(ring.empty() && !ring.try_pop(), "new ring is not empty") && ok;
+
+  for (int i = 0; i < 4; ++i)
+  {
+    ok = expect(ring.try_push(std::to_string(i)), "push failed on a ring with room") && ok;
+  }
+
+  ok = expect(!ring.try_push(std::string("full")), "push succeeded on a full ring") && ok;
+  ok = expect(ring.size() == 4, "wrong size of a full ring") && ok;
+
+  for (int i = 0; i < 4; ++i)
+  {
+    const auto value = ring.try_pop();
+    ok = expect(value && *value == std::to_string(i), "elements were not popped in order") && ok;
+  }
+
+  ok = expect(ring.empty(), "drained ring is not empty") && ok;
+
+  // A producer and a consumer exchange a sequence through a small ring.
+  constexpr unsigned long count = 200000;
+  spmc_ring<unsigned long> numbers(16);
+
+  std::thread producer([&numbers]
+                       {
+                         for (unsigned long i = 0; i < count;)
+                         {
+                           if (numbers.try_push(i)) ++i;
+                           else std::this_thread::yield();
+                         }
+                       });
+
+  unsigned long expected = 0;
+  bool ordered = true;
+
+  while (expected < count)
+  {
+    const auto value = numbers.try_pop();
+
+    if (!value)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    if (*value != expected) ordered = false;
+    ++expected;
+  }
+
+  producer.join();
+
+  ok = expect(ordered, "concurrent sequence was reordered or lost") && ok;
+  ok = expect(numbers.empty(), "ring is not empty after the exchange") && ok;
+
+  // The producer discards the oldest elements of the full ring while the
+  // consumer is popping: every element is either discarded or popped, once.
+  spmc_ring<unsigned long> latest(16);
+  std::atomic<bool> done{false};
+  unsigned long discarded = 0;
+
+  std::thread discarding_producer([&latest, &done, &discarded]
+                                  {
+                                    for (unsigned long i = 0; i < count; ++i)
+                                    {
+                                      while (!latest.try_push(i))
+                                      {
+                                        if (latest.try_pop()) ++discarded;
+                                      }
+                                    }
+
+                                    done = true;
+                                  });
+
+  unsigned long popped = 0;
+  unsigned long last = 0;
+  ordered = true;
+
+  for (;;)
+  {
+    const bool finished = done;
+    const auto value = latest.try_pop();
+
+    if (!value)
+    {
+      if (finished) break;
+      std::this_thread::yield();
+      continue;
+    }
+
+    if (popped > 0 && *value <= last) ordered = false;
+    last = *value;
+    ++popped;
+  }
+
+  discarding_producer.join();
+
+  ok = expect(ordered, "discarding sequence was reordered") && ok;
+  ok = expect(popped + discarded == count, "elements were lost or duplicated") && ok;
+  ok = expect(last == count - 1, "the newest element was not popped") && ok;
+
+  return ok ? 0 : 1;
+}
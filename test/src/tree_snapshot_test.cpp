@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include <libfswatch/c++/tree_snapshot.hpp>
+
+using namespace fsw;
+
+namespace
+{
+  bool expect(bool condition, const std::string& message)
+  {
+    if (condition) return true;
+
+    std::cerr << message << "\n";
+    return false;
+  }
+
+  struct stat make_stat(ino_t inode, off_t size, time_t mtime, time_t ctime, bool is_dir = false)
+  {
+    struct stat fd_stat{};
+    fd_stat.st_ino = inode;
+    fd_stat.st_size = size;
+    fd_stat.st_mtime = mtime;
+    fd_stat.st_ctime = ctime;
+    fd_stat.st_mode = is_dir ? S_IFDIR : S_IFREG;
+
+    return fd_stat;
+  }
+
+  // Gets the flags of the events of each path, joined in the order they were
+  // reported.
+  std::map<std::string, std::vector<fsw_event_flag>> get_changes(const std::vector<event>& events)
+  {
+    std::map<std::string, std::vector<fsw_event_flag>> changes;
+
+    for (const auto& evt : events)
+    {
+      for (const fsw_event_flag flag : evt.get_flags()) changes[evt.get_path()].push_back(flag);
+    }
+
+    return changes;
+  }
+
+  bool has_flags(const std::map<std::string, std::vector<fsw_event_flag>>& changes,
+                 const std::string& path,
+                 const std::vector<fsw_event_flag>& flags)
+  {
+    const auto found = changes.find(path);
+    return found != changes.end() && found->second == flags;
+  }
+}
+
+int main()
+{
+  bool ok = true;
+
+  tree_snapshot previous;
+  previous.insert("/root", make_stat(1, 4096, 10, 10, true));
+  previous.insert("/root/unchanged", make_stat(2, 10, 10, 10));
+  previous.insert("/root/updated", make_stat(3, 10, 10, 10));
+  previous.insert("/root/resized", make_stat(4, 10, 10, 10));
+  previous.insert("/root/chmod", make_stat(5, 10, 10, 10));
+  previous.insert("/root/replaced", make_stat(6, 10, 10, 10));
+  previous.insert("/root/removed", make_stat(7, 10, 10, 10, true));
+  ok = expect(previous.size() == 7 && previous.contains("/root/removed"), "wrong snapshot size") && ok;
+
+  // Inserting a path again replaces its status.
+  previous.insert("/root/unchanged", make_stat(2, 20, 10, 10));
+  previous.insert("/root/unchanged", make_stat(2, 10, 10, 10));
+  ok = expect(previous.size() == 7, "path was inserted twice") && ok;
+
+  ok = expect(previous.diff(previous, 0).empty(), "identical snapshots differ") && ok;
+
+  tree_snapshot current;
+  current.insert("/root", make_stat(1, 4096, 20, 20, true));
+  current.insert("/root/unchanged", make_stat(2, 10, 10, 10));
+  current.insert("/root/updated", make_stat(3, 10, 20, 20));
+  current.insert("/root/resized", make_stat(4, 30, 10, 10));
+  current.insert("/root/chmod", make_stat(5, 10, 10, 20));
+  current.insert("/root/replaced", make_stat(8, 10, 10, 10));
+  current.insert("/root/created", make_stat(9, 0, 20, 20, true));
+
+  const auto changes = get_changes(previous.diff(current, 0));
+
+  // The changes of the times of directories are caused by their entries.
+  ok = expect(changes.find("/root") == changes.end(), "modified directory was reported") && ok;
+  ok = expect(changes.find("/root/unchanged") == changes.end(), "unchanged file was reported") && ok;
+  ok = expect(has_flags(changes, "/root/updated", {Updated}), "updated file was not reported") && ok;
+  ok = expect(has_flags(changes, "/root/resized", {Updated}), "resized file was not reported") && ok;
+  ok = expect(has_flags(changes, "/root/chmod", {AttributeModified}),
+              "attribute change was not reported") && ok;
+  ok = expect(has_flags(changes, "/root/replaced", {Removed, Created}),
+              "replaced file was not reported") && ok;
+  ok = expect(has_flags(changes, "/root/removed", {Removed, IsDir}),
+              "removed directory was not reported") && ok;
+  ok = expect(has_flags(changes, "/root/created", {Created, IsDir}),
+              "created directory was not reported") && ok;
+  ok = expect(changes.size() == 6, "wrong number of changes") && ok;
+
+  // An empty snapshot, such as the one of a removed tree, removes all paths.
+  ok = expect(previous.diff(tree_snapshot(), 0).size() == previous.size(),
+              "removed tree was not reported") && ok;
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares the memory used per watched directory by the bookkeeping of the
+ * Linux monitors with reference maps of full paths, and the cost of
+ * materializing the path of an event.
+ *
+ *   - inotify: fsw::watch_table against a std::unordered_set of descriptors,
+ *     two std::unordered_map mapping descriptors to paths and back, and a
+ *     std::unordered_map of exclusion verdicts.
+ *
+ *   - fanotify: a fsw::path_tree and a fsw::file_handle_table mapping
+ *     directory handles to nodes against a std::unordered_set of paths and a
+ *     map from directory handles to paths.  Synthetic 16 bytes handle keys are
+ *     used: the first 8 bytes are the filesystem ID of the fsw::file_handle_key
+ *     of the table.
+ *
+ * The watched directories are synthetic trees with ten subdirectories per
+ * directory.  Memory is measured counting the usable size of the heap blocks
+ * allocated by each structure.
+ *
+ * Usage: watch_memory_benchmark [directories...]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <libfswatch/c++/file_handle_key.hpp>
+#include <libfswatch/c++/file_handle_table.hpp>
+#include <libfswatch/c++/path_tree.hpp>
+#include <libfswatch/c++/watch_table.hpp>
+
+#include "allocation_counter.hpp"
+
+using namespace fsw;
+using namespace std::chrono;
+
+namespace
+{
+  constexpr size_t lookups = 1000000;
+
+  struct legacy_inotify_table
+  {
+    std::unordered_set<int> watched_descriptors;
+    std::unordered_map<std::string, int> path_to_wd;
+    std::unordered_map<int, std::string> wd_to_path;
+    std::unordered_map<int, bool> excluded_directories;
+
+    void insert(int wd, const std::string& path)
+    {
+      watched_descriptors.insert(wd);
+      excluded_directories.emplace(wd, false);
+      wd_to_path[wd] = path;
+      path_to_wd[path] = wd;
+    }
+
+    std::string get_path(int wd) const
+    {
+      const auto path = wd_to_path.find(wd);
+      return path != wd_to_path.end() ? path->second : std::string();
+    }
+  };
+
+  struct legacy_fanotify_table
+  {
+    std::unordered_set<std::string> watched_paths;
+    std::unordered_map<std::string, std::string> handle_to_path;
+
+    void insert(const std::string& handle, const std::string& path)
+    {
+      watched_paths.insert(path);
+      handle_to_path[handle] = path;
+    }
+  };
+
+  struct fanotify_table
+  {
+    path_tree watched_paths;
+    file_handle_table<path_tree::node_id> handle_to_path;
+
+    void insert(const std::string& handle, const std::string& path)
+    {
+      const file_handle_key key(handle.data(), 8, 1, handle.data() + 8, handle.size() - 8);
+      handle_to_path.insert_or_assign(key, watched_paths.insert(path));
+    }
+  };
+
+  // Builds the paths of a tree rooted at a typical checkout.
+  std::vector<std::string> make_paths(size_t count)
+  {
+    std::vector<std::string> paths;
+    paths.reserve(count);
+    paths.emplace_back("/home/developer/src/monorepo");
+
+    for (size_t i = 1; i < count; ++i)
+      paths.push_back(paths[(i - 1) / 10] + "/module-" + std::to_string((i - 1) % 10));
+
+    return paths;
+  }
+
+  std::string make_handle(size_t i)
+  {
+    std::string handle(16, '\0');
+    for (size_t b = 0; b < sizeof(i); ++b) handle[8 + b] = static_cast<char>(i >> (8 * b));
+
+    return handle;
+  }
+
+  template<typename T>
+  size_t measure_memory(T& table, const std::vector<std::string>& paths)
+  {
+    allocation_counter::bytes = 0;
+    allocation_counter::counting = true;
+    table.reset(new typename T::element_type);
+
+    for (size_t i = 0; i < paths.size(); ++i)
+      table->insert(static_cast<int>(i + 1), paths[i]);
+
+    allocation_counter::counting = false;
+
+    return static_cast<size_t>(allocation_counter::bytes.load());
+  }
+
+  template<typename T>
+  size_t measure_handle_memory(T& table,
+                               const std::vector<std::string>& handles,
+                               const std::vector<std::string>& paths)
+  {
+    allocation_counter::bytes = 0;
+    allocation_counter::counting = true;
+    table.reset(new typename T::element_type);
+
+    for (size_t i = 0; i < paths.size(); ++i) table->insert(handles[i], paths[i]);
+
+    allocation_counter::counting = false;
+
+    return static_cast<size_t>(allocation_counter::bytes.load());
+  }
+
+  template<typename T>
+  double measure_lookups(const T& lookup, size_t count)
+  {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(1, static_cast<int>(count));
+    std::vector<int> wds(1024);
+    for (int& wd : wds) wd = distribution(generator);
+
+    size_t total_length = 0;
+    const auto start = steady_clock::now();
+
+    for (size_t i = 0; i < lookups; ++i)
+      total_length += lookup(wds[i % wds.size()]).size();
+
+    const auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start);
+
+    if (total_length == 0) std::cerr << "No paths were found.\n";
+
+    return static_cast<double>(elapsed.count()) / lookups;
+  }
+
+  void print_result(size_t count, const char *label, size_t bytes)
+  {
+    std::cout << count << " " << label << " bytes/directory:\t"
+              << static_cast<double>(bytes) / count << "\n";
+  }
+}
+
+int main(int argc, char **argv)
+{
+  std::vector<size_t> counts;
+  for (int i = 1; i < argc; ++i) counts.push_back(std::strtoul(argv[i], nullptr, 10));
+  if (counts.empty()) counts = {100000, 1000000};
+
+  bool smaller = true;
+
+  for (const size_t count : counts)
+  {
+    if (count == 0)
+    {
+      std::cerr << "Usage: " << argv[0] << " [directories...]\n";
+      return 1;
+    }
+
+    const std::vector<std::string> paths = make_paths(count);
+    std::vector<std::string> handles;
+    handles.reserve(count);
+    size_t path_bytes = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      path_bytes += paths[i].size();
+      handles.push_back(make_handle(i));
+    }
+
+    // Descriptors are assigned starting from 1.
+    std::unique_ptr<legacy_inotify_table> legacy_inotify;
+    std::unique_ptr<watch_table> inotify;
+    const size_t legacy_inotify_bytes = measure_memory(legacy_inotify, paths);
+    const size_t inotify_bytes = measure_memory(inotify, paths);
+
+    const double legacy_ns =
+      measure_lookups([&legacy_inotify](int wd) { return legacy_inotify->get_path(wd); }, count);
+    const double table_ns =
+      measure_lookups([&inotify](int wd) { return inotify->get_path(wd); }, count);
+
+    legacy_inotify.reset();
+    inotify.reset();
+
+    std::unique_ptr<legacy_fanotify_table> legacy_fanotify;
+    std::unique_ptr<fanotify_table> fanotify;
+    const size_t legacy_fanotify_bytes = measure_handle_memory(legacy_fanotify, handles, paths);
+    const size_t fanotify_bytes = measure_handle_memory(fanotify, handles, paths);
+
+    std::cout << count << " directories, average path length:\t"
+              << static_cast<double>(path_bytes) / count << "\n";
+    print_result(count, "inotify maps", legacy_inotify_bytes);
+    print_result(count, "inotify watch table", inotify_bytes);
+    print_result(count, "fanotify maps", legacy_fanotify_bytes);
+    print_result(count, "fanotify path tree", fanotify_bytes);
+    std::cout << count << " inotify maps path ns:\t" << legacy_ns << "\n"
+              << count << " inotify watch table path ns:\t" << table_ns << "\n";
+
+    smaller = smaller && inotify_bytes < legacy_inotify_bytes &&
+              fanotify_bytes < legacy_fanotify_bytes;
+  }
+
+  return smaller ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2026 Enrico M. Crisostomo
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 3, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <string>
+
+#include <libfswatch/c++/watch_table.hpp>
+
+using namespace fsw;
+
+namespace
+{
+  bool expect(bool condition, const std::string& message)
+  {
+    if (condition) return true;
+
+    std::cerr << message << "\n";
+    return false;
+  }
+
+  std::string path_of(int wd)
+  {
+    return "/watched/directory-" + std::to_string(wd);
+  }
+}
+
+int main()
+{
+  bool ok = true;
+
+  watch_table table;
+  ok = expect(table.empty() && table.get_path(1).empty(), "new table is not empty") && ok;
+  ok = expect(!table.contains(-1) && table.get_path(-1).empty(),
+              "negative descriptor was found") && ok;
+
+  table.insert(1, "/a");
+  table.insert(5, "/a/b");
+  ok = expect(table.size() == 2, "wrong size") && ok;
+  ok = expect(table.get_path(5) == "/a/b" && table.get_descriptor("/a/b") == 5,
+              "inserted descriptor was not found") && ok;
+  ok = expect(!table.contains(3) && !table.contains(6) && table.get_descriptor("/c") == -1,
+              "missing descriptor was found") && ok;
+
+  // Looking up a missing descriptor does not insert it.
+  ok = expect(table.size() == 2, "lookup inserted a descriptor") && ok;
+
+  // Exclusion verdicts are reset when a descriptor is reinserted.
+  table.set_exclusion(5, watch_exclusion::excluded);
+  table.set_exclusion(6, watch_exclusion::excluded);
+  ok = expect(table.get_exclusion(5) == watch_exclusion::excluded &&
+                table.get_exclusion(6) == watch_exclusion::unknown,
+              "wrong exclusion verdict") && ok;
+
+  table.insert(5, "/a/c");
+  ok = expect(table.size() == 2 && table.get_path(5) == "/a/c", "path was not replaced") && ok;
+  ok = expect(table.get_descriptor("/a/b") == -1 && table.get_descriptor("/a/c") == 5,
+              "index was not updated") && ok;
+  ok = expect(table.get_exclusion(5) == watch_exclusion::unknown, "verdict was not reset") && ok;
+
+  // A replaced directory watched by a new descriptor shadows the old one.
+  table.insert(7, "/a/c");
+  ok = expect(table.get_descriptor("/a/c") == 7, "newest descriptor is not indexed") && ok;
+  ok = expect(table.erase(5) && table.get_descriptor("/a/c") == 7,
+              "erasing the old descriptor removed the new one") && ok;
+  ok = expect(!table.erase(5), "erased descriptor was erased twice") && ok;
+
+  // Erasing the newest descriptor of a path falls back to an older one.
+  table.insert(8, "/a/c");
+  table.insert(9, "/a/c");
+  ok = expect(table.erase(9) && table.get_descriptor("/a/c") == 8,
+              "erasing the newest descriptor unwatched the path") && ok;
+  ok = expect(table.erase(8) && table.get_descriptor("/a/c") == 7,
+              "erasing the newest descriptor did not fall back to the oldest one") && ok;
+
+  // Erasing every descriptor empties the table.
+  ok = expect(table.erase(1) && table.erase(7) && table.empty(), "table is not empty") && ok;
+  ok = expect(table.get_descriptor("/a/c") == -1, "erased path is still watched") && ok;
+
+  // Paths survive the removal of their siblings.
+  constexpr int count = 20000;
+
+  for (int wd = 0; wd < count; ++wd) table.insert(wd, path_of(wd));
+  for (int wd = 0; wd < count; wd += 4) table.insert(wd, path_of(wd) + "/renamed");
+  for (int wd = 1; wd < count; wd += 2) table.erase(wd);
+
+  bool preserved = table.size() == count / 2;
+
+  for (int wd = 0; wd < count; ++wd)
+  {
+    const std::string expected = (wd % 4 == 0) ? path_of(wd) + "/renamed" : path_of(wd);
+
+    if (wd % 2 == 1)
+      preserved = preserved && !table.contains(wd) && table.get_descriptor(path_of(wd)) == -1;
+    else
+      preserved = preserved && table.get_path(wd) == expected &&
+                  table.get_descriptor(expected) == wd;
+  }
+
+  ok = expect(preserved, "paths were lost") && ok;
+
+  size_t visited = 0;
+  table.for_each([&visited](int wd)
+                 {
+                   if (wd % 2 == 0) ++visited;
+                 });
+  ok = expect(visited == count / 2, "wrong descriptors were visited") && ok;
+
+  return ok ? 0 : 1;
+}